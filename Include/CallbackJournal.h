@@ -0,0 +1,357 @@
+/*
+Callback journal file format and writer.
+
+Author: The Iron Wolf (vleonavicius@hotmail.com)
+Website: thecrewchief.org
+
+Description:
+  Journal captures game callbacks exactly as plugin received them, so that frame assembly and publication
+  can be replayed deterministically outside of the game (see Tools\JournalReplay.cpp).
+
+  File is rF2CallbackJournalFileHeader followed by events:
+    rF2CallbackJournalEventHeader, payload
+    ...
+
+  Payloads:
+    Startup, ThreadStarted, ThreadStopping - int argument
+    Shutdown, Start/EndSession, Enter/ExitRealtime - none
+    UpdateTelemetry - TelemInfoV01
+    UpdateScoring - ScoringInfoV01, mNumVehicles VehicleScoringInfoV01, mResultsStream text (no terminator, may be empty).
+                    Pointers in ScoringInfoV01 are meaningless and have to be fixed up by the reader.
+    SetPhysicsOptions - PhysicsOptionsV01
+
+  Payload layouts are raw ISI structures, so journal can only be replayed by a build with the same structure sizes
+  (recorded in the file header).
+
+  Callbacks can come from simulation and multimedia threads, so events are serialized on a spin lock, which only
+  guards a memcpy into the active one of two BUFFER_BYTES buffers.  Full buffer is handed to the writer thread,
+  which does all file I/O, and callbacks continue into the other one.  Events are never dropped: if the writer
+  has not finished with the other buffer yet, callback waits for it (yielding, and so do callbacks waiting on the
+  lock meanwhile).  Event larger than a buffer (huge results stream) is written directly by the callback, after
+  the writer went idle.  Up to BUFFER_BYTES of the latest events are only written out on Close.
+*/
+#pragma once
+
+#include <assert.h>
+#include <atomic>
+#include <new>                                  // std::nothrow
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+namespace CallbackJournal
+{
+  unsigned int const FORMAT_VERSION = 1u;
+  char const FILE_MAGIC[8] = { 'R', 'F', '2', 'S', 'M', 'C', 'J', '\0' };
+
+  enum class EventType : unsigned int
+  {
+    Startup = 1,
+    Shutdown = 2,
+    StartSession = 3,
+    EndSession = 4,
+    EnterRealtime = 5,
+    ExitRealtime = 6,
+    UpdateTelemetry = 7,
+    UpdateScoring = 8,
+    ThreadStarted = 9,
+    ThreadStopping = 10,
+    SetPhysicsOptions = 11
+  };
+
+#pragma pack(push, 4)
+  struct rF2CallbackJournalFileHeader
+  {
+    char mMagic[8];                           // FILE_MAGIC
+    unsigned int mVersion;                    // FORMAT_VERSION
+    unsigned int mTelemInfoBytes;             // sizeof(TelemInfoV01) of the writer
+    unsigned int mScoringInfoBytes;           // sizeof(ScoringInfoV01) of the writer
+    unsigned int mVehicleScoringInfoBytes;    // sizeof(VehicleScoringInfoV01) of the writer
+    unsigned int mPhysicsOptionsBytes;        // sizeof(PhysicsOptionsV01) of the writer
+  };
+
+  struct rF2CallbackJournalEventHeader
+  {
+    EventType mType;
+    unsigned int mPayloadBytes;
+    double mTimestampMicroseconds;            // Since journal was opened
+  };
+#pragma pack(pop)
+
+  class JournalWriter
+  {
+  public:
+    static unsigned int const BUFFER_BYTES = 1024u * 1024u;
+    static unsigned long const WRITER_IDLE_SLEEP_MS = 5uL;
+
+    JournalWriter()
+      : mWriteLock(false)
+      , mPendingBuffer(NO_BUFFER)
+      , mStopRequested(false)
+      , mWriteFailed(false)
+      , mWriteErrors(0u)
+    {}
+
+    ~JournalWriter()
+    {
+      Close();
+    }
+
+    // Opens RF2SMMP_CallbackJournal_<YYYYMMDD>_<HHMMSS>.rf2cj in the current directory.
+    bool Open()
+    {
+      assert(mpFile == nullptr);
+
+      auto const now = time(nullptr);
+      strftime(mFileName, sizeof(mFileName), "RF2SMMP_CallbackJournal_%Y%m%d_%H%M%S.rf2cj", localtime(&now));
+
+      mpFile = fopen(mFileName, "wb");
+      if (mpFile == nullptr)
+        return false;
+
+      // Writes are BUFFER_BYTES at a time already.
+      setvbuf(mpFile, nullptr, _IONBF, 0u);
+
+      for (int i = 0; i < BUFFER_COUNT; ++i) {
+        mBuffers[i].mpBytes = new (std::nothrow) unsigned char[BUFFER_BYTES];
+        mBuffers[i].mUsedBytes = 0u;
+        mBuffers[i].mNumEvents = 0u;
+        if (mBuffers[i].mpBytes == nullptr) {
+          Close();
+          return false;
+        }
+      }
+
+      rF2CallbackJournalFileHeader header = {};
+      memcpy(header.mMagic, FILE_MAGIC, sizeof(header.mMagic));
+      header.mVersion = FORMAT_VERSION;
+      header.mTelemInfoBytes = sizeof(TelemInfoV01);
+      header.mScoringInfoBytes = sizeof(ScoringInfoV01);
+      header.mVehicleScoringInfoBytes = sizeof(VehicleScoringInfoV01);
+      header.mPhysicsOptionsBytes = sizeof(PhysicsOptionsV01);
+
+      if (fwrite(&header, sizeof(header), 1, mpFile) != 1) {
+        Close();
+        return false;
+      }
+
+      mActiveBuffer = 0;
+      mPendingBuffer.store(NO_BUFFER);
+      mWriteFailed.store(false);
+      mStopRequested.store(false);
+      mhWriterThread = Platform::StartThread(JournalWriter::WriterThreadProc, this);
+      if (mhWriterThread == nullptr) {
+        Close();
+        return false;
+      }
+
+      mOpenTicksMicroseconds = Platform::TicksMicroseconds();
+      return true;
+    }
+
+    // Writes out buffered events and closes the file.
+    void Close()
+    {
+      AcquireWriteLock();
+
+      if (mhWriterThread != nullptr) {
+        // Writer finishes the pending buffer before it stops.
+        mStopRequested.store(true);
+        Platform::JoinThread(mhWriterThread);
+        mhWriterThread = nullptr;
+
+        auto& active = mBuffers[mActiveBuffer];
+        if (active.mUsedBytes > 0u)
+          WriteBuffer(active);
+      }
+
+      if (mpFile != nullptr) {
+        fclose(mpFile);
+        mpFile = nullptr;
+      }
+
+      for (int i = 0; i < BUFFER_COUNT; ++i) {
+        delete[] mBuffers[i].mpBytes;
+        mBuffers[i].mpBytes = nullptr;
+      }
+
+      mWriteLock.store(false, std::memory_order_release);
+    }
+
+    bool IsOpen() const { return mpFile != nullptr; }
+    char const* FileName() const { return mFileName; }
+
+    void WriteEvent(EventType type)
+    {
+      WriteEventParts(type, nullptr, 0u, nullptr, 0u, nullptr, 0u);
+    }
+
+    void WriteEvent(EventType type, int argument)
+    {
+      WriteEventParts(type, &argument, sizeof(argument), nullptr, 0u, nullptr, 0u);
+    }
+
+    void WriteTelemetry(TelemInfoV01 const& info)
+    {
+      WriteEventParts(EventType::UpdateTelemetry, &info, sizeof(info), nullptr, 0u, nullptr, 0u);
+    }
+
+    void WriteScoring(ScoringInfoV01 const& info)
+    {
+      auto const vehicleBytes = info.mVehicle != nullptr && info.mNumVehicles > 0
+        ? static_cast<unsigned int>(info.mNumVehicles * sizeof(VehicleScoringInfoV01))
+        : 0u;
+
+      auto const resultsBytes = info.mResultsStream != nullptr ? static_cast<unsigned int>(strlen(info.mResultsStream)) : 0u;
+
+      WriteEventParts(EventType::UpdateScoring, &info, sizeof(info), info.mVehicle, vehicleBytes, info.mResultsStream, resultsBytes);
+    }
+
+    void WritePhysicsOptions(PhysicsOptionsV01 const& options)
+    {
+      WriteEventParts(EventType::SetPhysicsOptions, &options, sizeof(options), nullptr, 0u, nullptr, 0u);
+    }
+
+    // Number of events that failed to write.  Nothing is written after the first failure.
+    unsigned int WriteErrors() const { return mWriteErrors.load(std::memory_order_relaxed); }
+
+  private:
+    JournalWriter(JournalWriter const&) = delete;
+    JournalWriter& operator=(JournalWriter const&) = delete;
+
+    static int const BUFFER_COUNT = 2;
+    static int const NO_BUFFER = -1;
+
+    struct Buffer
+    {
+      unsigned char* mpBytes;
+      unsigned int mUsedBytes;
+      unsigned int mNumEvents;
+    };
+
+    static void WriterThreadProc(void* pContext)
+    {
+      static_cast<JournalWriter*>(pContext)->WriterLoop();
+    }
+
+    // Writer thread.
+    void WriterLoop()
+    {
+      for (;;) {
+        auto const pending = mPendingBuffer.load(std::memory_order_acquire);
+        if (pending != NO_BUFFER) {
+          WriteBuffer(mBuffers[pending]);
+          mPendingBuffer.store(NO_BUFFER, std::memory_order_release);
+          continue;
+        }
+
+        // Stop is only honoured once pending buffer is written.
+        if (mStopRequested.load())
+          break;
+
+        Platform::SleepMillis(WRITER_IDLE_SLEEP_MS);
+      }
+    }
+
+    // Writer thread, or callback thread holding the lock while writer is idle.
+    void WriteBuffer(Buffer& buffer)
+    {
+      if (mWriteFailed.load(std::memory_order_relaxed)
+        || fwrite(buffer.mpBytes, 1, buffer.mUsedBytes, mpFile) != buffer.mUsedBytes) {
+        mWriteErrors.fetch_add(buffer.mNumEvents, std::memory_order_relaxed);
+        mWriteFailed.store(true, std::memory_order_relaxed);
+      }
+
+      buffer.mUsedBytes = 0u;
+      buffer.mNumEvents = 0u;
+    }
+
+    void AcquireWriteLock()
+    {
+      while (mWriteLock.exchange(true, std::memory_order_acquire))
+        Platform::SleepMillis(0uL);
+    }
+
+    // Lock held.  Waits until writer is done with the pending buffer, if any.
+    void WaitWriterIdle() const
+    {
+      while (mPendingBuffer.load(std::memory_order_acquire) != NO_BUFFER)
+        Platform::SleepMillis(0uL);
+    }
+
+    // Lock held.  Hands active buffer to the writer and continues into the other one.
+    void HandOffActiveBuffer()
+    {
+      WaitWriterIdle();
+      mPendingBuffer.store(mActiveBuffer, std::memory_order_release);
+      mActiveBuffer = (mActiveBuffer + 1) % BUFFER_COUNT;
+    }
+
+    static unsigned char* AppendPart(unsigned char* pDst, void const* pPart, unsigned int partBytes)
+    {
+      if (partBytes > 0u)
+        memcpy(pDst, pPart, partBytes);
+
+      return pDst + partBytes;
+    }
+
+    void WriteEventParts(EventType type, void const* pPart1, unsigned int part1Bytes, void const* pPart2, unsigned int part2Bytes,
+      void const* pPart3, unsigned int part3Bytes)
+    {
+      AcquireWriteLock();
+
+      if (mhWriterThread != nullptr) {
+        rF2CallbackJournalEventHeader header = {};
+        header.mType = type;
+        header.mPayloadBytes = part1Bytes + part2Bytes + part3Bytes;
+        header.mTimestampMicroseconds = Platform::TicksMicroseconds() - mOpenTicksMicroseconds;
+
+        auto const eventBytes = static_cast<unsigned int>(sizeof(header)) + header.mPayloadBytes;
+        if (mBuffers[mActiveBuffer].mUsedBytes + eventBytes > BUFFER_BYTES && mBuffers[mActiveBuffer].mUsedBytes > 0u)
+          HandOffActiveBuffer();
+
+        auto& active = mBuffers[mActiveBuffer];
+        if (mWriteFailed.load(std::memory_order_relaxed))
+          mWriteErrors.fetch_add(1u, std::memory_order_relaxed);
+        else if (eventBytes <= BUFFER_BYTES) {
+          auto pDst = AppendPart(active.mpBytes + active.mUsedBytes, &header, sizeof(header));
+          pDst = AppendPart(pDst, pPart1, part1Bytes);
+          pDst = AppendPart(pDst, pPart2, part2Bytes);
+          AppendPart(pDst, pPart3, part3Bytes);
+
+          active.mUsedBytes += eventBytes;
+          ++active.mNumEvents;
+        }
+        else {
+          // Active buffer is empty here, so file is up to date once writer is idle.
+          WaitWriterIdle();
+          if (fwrite(&header, sizeof(header), 1, mpFile) != 1
+            || (part1Bytes > 0u && fwrite(pPart1, 1, part1Bytes, mpFile) != part1Bytes)
+            || (part2Bytes > 0u && fwrite(pPart2, 1, part2Bytes, mpFile) != part2Bytes)
+            || (part3Bytes > 0u && fwrite(pPart3, 1, part3Bytes, mpFile) != part3Bytes)) {
+            mWriteErrors.fetch_add(1u, std::memory_order_relaxed);
+            mWriteFailed.store(true, std::memory_order_relaxed);
+          }
+        }
+      }
+
+      mWriteLock.store(false, std::memory_order_release);
+    }
+
+    FILE* mpFile = nullptr;
+    char mFileName[MAX_PATH] = {};
+    double mOpenTicksMicroseconds = 0.0;
+
+    // Callback threads, under mWriteLock.
+    std::atomic<bool> mWriteLock;
+    Buffer mBuffers[BUFFER_COUNT] = {};
+    int mActiveBuffer = 0;
+
+    // Buffer handed to the writer thread, NO_BUFFER if writer is idle.
+    std::atomic<int> mPendingBuffer;
+    Platform::ThreadHandle mhWriterThread = nullptr;
+    std::atomic<bool> mStopRequested;
+    std::atomic<bool> mWriteFailed;
+    std::atomic<unsigned int> mWriteErrors;
+  };
+}
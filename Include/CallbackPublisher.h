@@ -0,0 +1,471 @@
+/*
+Definition of CallbackPublisher class.
+
+Author: The Iron Wolf (vleonavicius@hotmail.com)
+Website: thecrewchief.org
+
+Description:
+  CallbackPublisher moves buffer publication off the game threads.  Game callbacks copy their arguments into a
+  preallocated record of the MpscRing and return; a publisher thread pops records in order and hands them to the
+  plugin, which then assembles frames, updates extended state and flips mapped buffers on that one thread.
+
+  Game thread cost of telemetry and scoring is one copy of the callback arguments plus the queue atomics: no
+  allocation, no kernel calls, and mapped buffer mutexes are only ever waited on by the publisher thread.  If the
+  publisher falls behind and the queue is full, telemetry and scoring updates are dropped and counted.  Rare events
+  (session, realtime, thread and physics changes) wait up to EVENT_SUBMIT_WAIT_MS for a free record instead.
+
+  Telemetry is dropped a whole update chain (frame) at a time: chains are detected on submission the same way
+  UpdateTelemetry does (vehicle mID 0, or a vehicle already seen in the chain), and once a vehicle of the chain does
+  not fit, the rest of the chain is dropped too.  Vehicles of the chain queued before that are not published either:
+  publisher replaces them with a single TelemetryChainDropped record, so the plugin never flips a partial frame.
+
+  Scoring has pointers to the vehicle array and results text, which do not fit a fixed size record.  They are
+  copied into a separate ring of scoring snapshots first, and the scoring record carries the snapshot position.
+  Results text longer than RESULTS_STREAM_CHARS is truncated.
+
+  Once the queue runs empty, publisher yields for IDLE_SPIN_MICROSECONDS (vehicles of a telemetry frame come back to
+  back), then waits on an unnamed event.  Submitters signal it after a push only if the publisher announced it is
+  waiting, so there's one kernel call per idle to busy transition (roughly per frame), not per record, and the
+  publisher is not at the mercy of the scheduler tick the way sleeping would be.  IDLE_WAIT_MS is only a safety net.
+*/
+#pragma once
+
+#include <atomic>
+#include <string.h>
+#include "MpscRing.h"
+
+class CallbackPublisher
+{
+public:
+  // ~8MB, 32 frames of 128 vehicles.
+  static unsigned int const QUEUE_RECORDS = 4096u;
+  // ~0.8 seconds at 5Hz, ~450KB.
+  static unsigned int const QUEUE_SCORING_SNAPSHOTS = 4u;
+  static int const RESULTS_STREAM_CHARS = 32 * 1024;
+  static unsigned long const IDLE_WAIT_MS = 100uL;
+  static unsigned int const IDLE_SPIN_MICROSECONDS = 200u;
+  static unsigned long long const EVENT_SUBMIT_WAIT_MS = 100uLL;
+
+  enum class Kind
+  {
+    Telemetry,
+    Scoring,
+    ThreadStarted,
+    ThreadStopping,
+    PhysicsOptions,
+    StartSession,
+    EndSession,
+    EnterRealtime,
+    ExitRealtime,
+    TelemetryChainDropped                    // Publisher only, in place of the queued part of a dropped update chain.
+  };
+
+  struct Record
+  {
+    Kind mKind;
+    long mArgument;                          // ThreadStarted, ThreadStopping - thread type
+    unsigned int mSnapshotPosition;          // Scoring - position in the scoring snapshot ring
+    unsigned int mChainNumber;               // Telemetry - update chain the vehicle belongs to
+    union
+    {
+      TelemInfoV01 mTelemetry;
+      PhysicsOptionsV01 mPhysicsOptions;
+    };
+  };
+
+  // Called on the publisher thread for every record, in queue order.  pScoringInfo is set for Scoring records only,
+  // and points to the snapshot (vehicle and results text pointers fixed up).
+  typedef void (*Handler)(void* pContext, Record& record, ScoringInfoV01 const* pScoringInfo);
+
+  CallbackPublisher()
+    : mStopRequested(false)
+    , mPublisherWaiting(false)
+    , mDroppedChainNumber(NO_CHAIN)
+    , mRecordsDropped(0uLL)
+    , mChainsDropped(0uLL)
+    , mScoringDropped(0uLL)
+    , mResultsTruncated(0uLL)
+  {}
+
+  ~CallbackPublisher()
+  {
+    Stop();
+  }
+
+  // Allocates queues and starts the publisher thread.
+  bool Start(Handler handler, void* pContext)
+  {
+    if (IsRunning())
+      return true;
+
+    mhWakeEvent = Platform::CreateNamedEvent(nullptr /*name*/);
+    if (mhWakeEvent == nullptr
+      || !mQueue.Initialize(QUEUE_RECORDS)
+      || !mScoringQueue.Initialize(QUEUE_SCORING_SNAPSHOTS)) {
+      ReleaseResources();
+      return false;
+    }
+
+    mpHandler = handler;
+    mpHandlerContext = pContext;
+    mSubmitChainNumber = NO_CHAIN;
+    mSubmitChainDropped = false;
+    memset(mSubmitChainSeen, 0, sizeof(mSubmitChainSeen));
+    mDroppedChainNumber.store(NO_CHAIN);
+    mPublishChainNumber = NO_CHAIN;
+    mPublishChainDiscarded = false;
+    mStopRequested.store(false);
+    mPublisherWaiting.store(false);
+    mhPublisherThread = Platform::StartThread(CallbackPublisher::PublisherThreadProc, this);
+    if (mhPublisherThread == nullptr) {
+      ReleaseResources();
+      return false;
+    }
+
+    return true;
+  }
+
+  // Publishes queued records and stops the publisher thread.
+  void Stop()
+  {
+    if (mhPublisherThread != nullptr) {
+      mStopRequested.store(true);
+      Platform::SignalEvent(mhWakeEvent);
+      Platform::JoinThread(mhPublisherThread);
+      mhPublisherThread = nullptr;
+    }
+
+    ReleaseResources();
+  }
+
+  bool IsRunning() const { return mhPublisherThread != nullptr; }
+
+  bool IsPublisherThread() const { return CurrentThreadPublisher() == this; }
+
+  // Simulation thread only (update chains are tracked per submitting thread).  Never blocks: returns false if update
+  // was dropped because publisher is behind.
+  bool SubmitTelemetry(TelemInfoV01 const& info)
+  {
+    auto const seenIndex = max(0, min(static_cast<int>(info.mID), rF2MappedBufferHeader::MAX_MAPPED_IDS - 1));
+    if (info.mID == 0 || mSubmitChainSeen[seenIndex]) {
+      memset(mSubmitChainSeen, 0, sizeof(mSubmitChainSeen));
+      mSubmitChainNumber = mSubmitChainNumber + 1u != NO_CHAIN ? mSubmitChainNumber + 1u : 0u;
+      mSubmitChainDropped = false;
+    }
+
+    mSubmitChainSeen[seenIndex] = true;
+
+    auto position = 0u;
+    auto const pRecord = !mSubmitChainDropped ? mQueue.BeginPush(position) : nullptr;
+    if (pRecord == nullptr) {
+      if (!mSubmitChainDropped) {
+        mSubmitChainDropped = true;
+        mChainsDropped.fetch_add(1uLL, std::memory_order_relaxed);
+        mDroppedChainNumber.store(mSubmitChainNumber, std::memory_order_release);
+      }
+
+      mRecordsDropped.fetch_add(1uLL, std::memory_order_relaxed);
+      return false;
+    }
+
+    pRecord->mKind = Kind::Telemetry;
+    pRecord->mChainNumber = mSubmitChainNumber;
+    memcpy(&(pRecord->mTelemetry), &info, sizeof(TelemInfoV01));
+
+    EndPush(position);
+    return true;
+  }
+
+  // Any thread.  Never blocks: returns false if update was dropped because publisher is behind.
+  bool SubmitScoring(ScoringInfoV01 const& info)
+  {
+    auto snapshotPosition = 0u;
+    auto const pSnapshot = mScoringQueue.BeginPush(snapshotPosition);
+    if (pSnapshot == nullptr) {
+      mScoringDropped.fetch_add(1uLL, std::memory_order_relaxed);
+      return false;
+    }
+
+    auto const numVehicles = info.mVehicle != nullptr
+      ? max(0, min(static_cast<int>(info.mNumVehicles), rF2MappedBufferHeader::MAX_MAPPED_VEHICLES))
+      : 0;
+
+    memcpy(&(pSnapshot->mInfo), &info, sizeof(ScoringInfoV01));
+    pSnapshot->mInfo.mNumVehicles = numVehicles;
+    memcpy(pSnapshot->mVehicles, info.mVehicle, numVehicles * sizeof(VehicleScoringInfoV01));
+
+    auto resultsChars = 0u;
+    if (info.mResultsStream != nullptr) {
+      resultsChars = static_cast<unsigned int>(strnlen(info.mResultsStream, RESULTS_STREAM_CHARS - 1));
+      if (info.mResultsStream[resultsChars] != '\0')
+        mResultsTruncated.fetch_add(1uLL, std::memory_order_relaxed);
+
+      memcpy(pSnapshot->mResultsStream, info.mResultsStream, resultsChars);
+    }
+
+    pSnapshot->mResultsStream[resultsChars] = '\0';
+    mScoringQueue.EndPush(snapshotPosition);
+
+    // If this fails, publisher discards the snapshot when it gets to the next scoring record.
+    auto position = 0u;
+    auto const pRecord = mQueue.BeginPush(position);
+    if (pRecord == nullptr) {
+      mScoringDropped.fetch_add(1uLL, std::memory_order_relaxed);
+      return false;
+    }
+
+    pRecord->mKind = Kind::Scoring;
+    pRecord->mSnapshotPosition = snapshotPosition;
+
+    EndPush(position);
+    return true;
+  }
+
+  // Any thread.  Waits up to EVENT_SUBMIT_WAIT_MS if the queue is full.
+  bool SubmitEvent(Kind kind, long argument = 0L)
+  {
+    auto position = 0u;
+    auto const pRecord = BeginPushWait(position);
+    if (pRecord == nullptr)
+      return false;
+
+    pRecord->mKind = kind;
+    pRecord->mArgument = argument;
+
+    EndPush(position);
+    return true;
+  }
+
+  // Any thread.  Waits up to EVENT_SUBMIT_WAIT_MS if the queue is full.
+  bool SubmitPhysicsOptions(PhysicsOptionsV01 const& options)
+  {
+    auto position = 0u;
+    auto const pRecord = BeginPushWait(position);
+    if (pRecord == nullptr)
+      return false;
+
+    pRecord->mKind = Kind::PhysicsOptions;
+    memcpy(&(pRecord->mPhysicsOptions), &options, sizeof(PhysicsOptionsV01));
+
+    EndPush(position);
+    return true;
+  }
+
+  // Safe to read from any thread.
+  unsigned long long RecordsDropped() const { return mRecordsDropped.load(std::memory_order_relaxed); }
+  unsigned long long ChainsDropped() const { return mChainsDropped.load(std::memory_order_relaxed); }
+  unsigned long long ScoringDropped() const { return mScoringDropped.load(std::memory_order_relaxed); }
+  unsigned long long ResultsTruncated() const { return mResultsTruncated.load(std::memory_order_relaxed); }
+
+private:
+  CallbackPublisher(CallbackPublisher const&) = delete;
+  CallbackPublisher& operator=(CallbackPublisher const&) = delete;
+
+  static unsigned int const NO_CHAIN = 0xFFFFFFFFu;
+
+  struct ScoringSnapshot
+  {
+    ScoringInfoV01 mInfo;
+    VehicleScoringInfoV01 mVehicles[rF2MappedBufferHeader::MAX_MAPPED_VEHICLES];
+    char mResultsStream[RESULTS_STREAM_CHARS];
+  };
+
+  // Set on the publisher thread only.  Thread local, so the check costs game threads no kernel call.
+  static CallbackPublisher const*& CurrentThreadPublisher()
+  {
+    static PLATFORM_THREAD_LOCAL CallbackPublisher const* tlsPublisher = nullptr;
+    return tlsPublisher;
+  }
+
+  static void PublisherThreadProc(void* pContext)
+  {
+    static_cast<CallbackPublisher*>(pContext)->PublisherLoop();
+  }
+
+  // Wakes the publisher if it is waiting.  Pairs with the fence in PublisherLoop: either publisher sees the record
+  // before it waits, or this sees mPublisherWaiting set.
+  void EndPush(unsigned int position)
+  {
+    mQueue.EndPush(position);
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (mPublisherWaiting.load(std::memory_order_relaxed) && mPublisherWaiting.exchange(false))
+      Platform::SignalEvent(mhWakeEvent);
+  }
+
+  Record* BeginPushWait(unsigned int& position)
+  {
+    auto const waitStartTicks = Platform::TickCountMillis();
+    Record* pRecord = nullptr;
+    while ((pRecord = mQueue.BeginPush(position)) == nullptr) {
+      if (Platform::TickCountMillis() - waitStartTicks > EVENT_SUBMIT_WAIT_MS) {
+        mRecordsDropped.fetch_add(1uLL, std::memory_order_relaxed);
+        return nullptr;
+      }
+
+      Platform::SleepMillis(1uL);
+    }
+
+    return pRecord;
+  }
+
+  // Publisher thread.
+  void PublisherLoop()
+  {
+    CurrentThreadPublisher() = this;
+
+    auto idle = false;
+    auto idleStartMicroseconds = 0.0;
+    for (;;) {
+      if (PublishNext()) {
+        idle = false;
+        continue;
+      }
+
+      // Stop is only honoured once queue is drained.
+      if (mStopRequested.load())
+        break;
+
+      if (!idle) {
+        idle = true;
+        idleStartMicroseconds = Platform::TicksMicroseconds();
+      }
+
+      if (Platform::TicksMicroseconds() - idleStartMicroseconds < IDLE_SPIN_MICROSECONDS) {
+        Platform::SleepMillis(0uL);
+        continue;
+      }
+
+      // Re-check after announcing the wait, record might have been pushed before submitter could see the flag.
+      mPublisherWaiting.store(true);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (mQueue.Front() == nullptr && !mStopRequested.load())
+        Platform::WaitEvent(mhWakeEvent, IDLE_WAIT_MS);
+
+      mPublisherWaiting.store(false);
+      idle = false;
+    }
+
+    CurrentThreadPublisher() = nullptr;
+  }
+
+  // Publisher thread.  Returns false if the queue is empty.
+  bool PublishNext()
+  {
+    auto const pRecord = mQueue.Front();
+    if (pRecord == nullptr)
+      return false;
+
+    if (pRecord->mKind == Kind::Telemetry && DiscardTelemetry(*pRecord)) {
+      mQueue.Pop();
+      return true;
+    }
+
+    if (pRecord->mKind != Kind::Scoring)
+      mpHandler(mpHandlerContext, *pRecord, nullptr /*pScoringInfo*/);
+    else {
+      auto const pSnapshot = TakeScoringSnapshot(pRecord->mSnapshotPosition);
+      if (pSnapshot != nullptr) {
+        mpHandler(mpHandlerContext, *pRecord, &(pSnapshot->mInfo));
+        mScoringQueue.Pop();
+      }
+      else
+        mScoringDropped.fetch_add(1uLL, std::memory_order_relaxed);
+    }
+
+    mQueue.Pop();
+    return true;
+  }
+
+  // Publisher thread.  Returns true if vehicle belongs to a dropped update chain.  Handler is told once per dropped
+  // chain, also if chain was dropped only after all of its queued vehicles were published.
+  bool DiscardTelemetry(Record& record)
+  {
+    auto const droppedChainNumber = mDroppedChainNumber.load(std::memory_order_acquire);
+    if (record.mChainNumber != mPublishChainNumber) {
+      if (mPublishChainNumber == droppedChainNumber && !mPublishChainDiscarded)
+        NotifyChainDropped(record);
+
+      mPublishChainNumber = record.mChainNumber;
+      mPublishChainDiscarded = false;
+    }
+
+    if (record.mChainNumber != droppedChainNumber)
+      return false;
+
+    if (!mPublishChainDiscarded) {
+      NotifyChainDropped(record);
+      mPublishChainDiscarded = true;
+    }
+
+    return true;
+  }
+
+  void NotifyChainDropped(Record& record)
+  {
+    auto const kind = record.mKind;
+    record.mKind = Kind::TelemetryChainDropped;
+    mpHandler(mpHandlerContext, record, nullptr /*pScoringInfo*/);
+    record.mKind = kind;
+  }
+
+  // Publisher thread.  Discards snapshots whose records were dropped, returns snapshot at the position.
+  ScoringSnapshot* TakeScoringSnapshot(unsigned int position)
+  {
+    for (;;) {
+      auto snapshotPosition = 0u;
+      auto const pSnapshot = mScoringQueue.Front(snapshotPosition);
+      if (pSnapshot == nullptr || static_cast<int>(snapshotPosition - position) > 0)
+        return nullptr;  // Only possible if scoring is submitted from more than one thread.
+
+      if (snapshotPosition == position) {
+        pSnapshot->mInfo.mVehicle = pSnapshot->mVehicles;
+        pSnapshot->mInfo.mResultsStream = pSnapshot->mResultsStream;
+        return pSnapshot;
+      }
+
+      mScoringQueue.Pop();
+    }
+  }
+
+  void ReleaseResources()
+  {
+    mQueue.ReleaseResources();
+    mScoringQueue.ReleaseResources();
+
+    if (mhWakeEvent != nullptr) {
+      Platform::CloseEvent(mhWakeEvent);
+      mhWakeEvent = nullptr;
+    }
+  }
+
+  MpscRing<Record> mQueue;
+  MpscRing<ScoringSnapshot> mScoringQueue;
+
+  Handler mpHandler = nullptr;
+  void* mpHandlerContext = nullptr;
+
+  Platform::ThreadHandle mhPublisherThread = nullptr;
+  std::atomic<bool> mStopRequested;
+
+  // Publisher is (about to be) waiting on mhWakeEvent.
+  Platform::EventHandle mhWakeEvent = nullptr;
+  std::atomic<bool> mPublisherWaiting;
+
+  // Simulation thread only.
+  unsigned int mSubmitChainNumber = NO_CHAIN;
+  bool mSubmitChainDropped = false;
+  bool mSubmitChainSeen[rF2MappedBufferHeader::MAX_MAPPED_IDS];
+
+  // Latest update chain dropped by SubmitTelemetry.
+  std::atomic<unsigned int> mDroppedChainNumber;
+
+  // Publisher thread only.
+  unsigned int mPublishChainNumber = NO_CHAIN;
+  bool mPublishChainDiscarded = false;
+
+  std::atomic<unsigned long long> mRecordsDropped;
+  std::atomic<unsigned long long> mChainsDropped;
+  std::atomic<unsigned long long> mScoringDropped;
+  std::atomic<unsigned long long> mResultsTruncated;
+};
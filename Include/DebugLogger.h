@@ -0,0 +1,414 @@
+/*
+Definition of DebugLogger class.
+
+Author: The Iron Wolf (vleonavicius@hotmail.com)
+Website: thecrewchief.org
+
+Description:
+  DebugLogger takes debug output (DEBUG_MSG* macros) off the game threads.
+
+  Each thread that logs gets its own SpscRing of fixed size records on its first message.  A record holds format
+  id (which DEBUG_* macro), __FUNCTION__ pointer, line, int/float argument, CPU timestamp counter and a copy of
+  the message strings, so logging costs a strlen/memcpy of the messages and no formatting, locks or kernel calls.
+  Message strings are copied rather than referenced because callers mostly pass stack buffers they just formatted
+  into.  Writer thread polls the rings, merges records by timestamp, formats them and appends to the debug output
+  file.
+
+  Writer does all file I/O, including periodic flushes.  Records are timestamped with seconds since Start, using
+  the timestamp counter calibrated against Platform::TicksMicroseconds.
+
+  If writer falls behind and the thread's ring is full, or more than MAX_THREADS live threads log, message is
+  dropped and counted; writer reports drops in the output.
+
+  Thread slots are handed back when their thread exits: thread exit callback marks the slot, and writer releases
+  it for other threads once its ring is drained.  If thread exit notification is not available, slots stay
+  claimed for the lifetime of the logger.
+
+  Rings are only released by the destructor, so a thread racing Stop never writes into freed memory (its record
+  may be lost, however).  Stop must be called before module unload: joining threads from static destructors can
+  deadlock on Windows loader lock.
+*/
+#pragma once
+
+#include <assert.h>
+#include <atomic>
+#include <stdio.h>
+#include <string.h>
+
+class DebugLogger
+{
+public:
+  // Message layouts, one per DEBUG_* macro.
+  enum class Format : unsigned char
+  {
+    Msg = 0,       // DEBUG_MSG
+    Msg2 = 1,      // DEBUG_MSG2
+    Msg3 = 2,      // DEBUG_MSG3
+    Int2 = 3,      // DEBUG_INT2
+    Float2 = 4     // DEBUG_FLOAT2
+  };
+
+  // Simulation, multimedia and a couple of spare threads.
+  static unsigned int const MAX_THREADS = 8u;
+  // ~40ms of continuous Verbose output, 128KB per thread.
+  static unsigned int const RECORDS_PER_THREAD = 512u;
+  static unsigned int const TEXT_BYTES = 223u;
+  static unsigned long const WRITER_IDLE_SLEEP_MS = 5uL;
+  static unsigned long const CALIBRATION_MS = 20uL;
+  static unsigned long long const FLUSH_PERIOD_MS = 1000uLL;
+
+  DebugLogger()
+    : mAccepting(false)
+    , mStopRequested(false)
+    , mDropped(0uLL)
+  {}
+
+  ~DebugLogger()
+  {
+    if (mThreadExitKeyCreated)
+      Platform::DeleteThreadExitKey(mThreadExitKey);
+
+    // See Stop comment in the header.
+    if (!IsRunning())
+      ReleaseResources();
+  }
+
+  // printf format of the record layout: %s(%d) function and line, followed by the messages and argument.
+  static char const* FormatString(Format format)
+  {
+    switch (format) {
+    case Format::Msg:
+      return "%s(%d) : %s\n";
+    case Format::Msg2:
+      return "%s(%d) : %s %s\n";
+    case Format::Msg3:
+      return "%s(%d) : %s %s %s\n";
+    case Format::Int2:
+      return "%s(%d) : %s %d\n";
+    case Format::Float2:
+      return "%s(%d) : %s %f\n";
+    default:
+      return "%s(%d) : %s\n";
+    }
+  }
+
+  // Allocates rings (first time only) and starts the writer thread.  pFile is owned by the caller, and must stay
+  // open until Stop.
+  bool Start(FILE* pFile)
+  {
+    if (IsRunning())
+      return true;
+
+    if (pFile == nullptr)
+      return false;
+
+    for (unsigned int i = 0u; i < MAX_THREADS; ++i) {
+      if (!mSlots[i].mRing.IsInitialized() && !mSlots[i].mRing.Initialize(RECORDS_PER_THREAD))
+        return false;
+    }
+
+    if (!mThreadExitKeyCreated)
+      mThreadExitKeyCreated = Platform::CreateThreadExitKey(mThreadExitKey, DebugLogger::OnThreadExit);
+
+    mpFile = pFile;
+    mStartCycles = Platform::CycleCounter();
+    mStartMicroseconds = Platform::TicksMicroseconds();
+    mCyclesPerSecond = 0.0;
+    mDropped.store(0uLL);
+
+    mStopRequested.store(false);
+    mhWriterThread = Platform::StartThread(DebugLogger::WriterThreadProc, this);
+    if (mhWriterThread == nullptr) {
+      mpFile = nullptr;
+      return false;
+    }
+
+    mAccepting.store(true);
+    return true;
+  }
+
+  // Writes out queued records and stops the writer thread.  File is flushed, but not closed.
+  void Stop()
+  {
+    mAccepting.store(false);
+
+    if (mhWriterThread != nullptr) {
+      mStopRequested.store(true);
+      Platform::JoinThread(mhWriterThread);
+      mhWriterThread = nullptr;
+    }
+
+    mpFile = nullptr;
+  }
+
+  bool IsRunning() const { return mhWriterThread != nullptr; }
+
+  // Any thread.  Returns false if logger is not running, and caller has to write the message itself.
+  // Never blocks: if the ring is full, message is dropped.
+  bool Log(Format format, char const* function, int line, char const* msg, char const* msg2, char const* msg3,
+    int intValue, double floatValue)
+  {
+    if (!mAccepting.load(std::memory_order_relaxed))
+      return false;
+
+    auto const pSlot = CurrentThreadSlot();
+    auto const pRecord = pSlot != nullptr ? pSlot->mRing.BeginPush() : nullptr;
+    if (pRecord == nullptr) {
+      mDropped.fetch_add(1uLL, std::memory_order_relaxed);
+      return true;
+    }
+
+    pRecord->mCycles = Platform::CycleCounter();
+    pRecord->mpFunction = function;
+    pRecord->mLine = line;
+    pRecord->mFormat = format;
+    pRecord->mIntValue = intValue;
+    pRecord->mFloatValue = floatValue;
+
+    auto const pEnd = pRecord->mText + TEXT_BYTES;
+    auto pText = AppendText(pRecord->mText, pEnd, msg);
+    if (format == Format::Msg2 || format == Format::Msg3)
+      pText = AppendText(pText, pEnd, msg2);
+
+    if (format == Format::Msg3)
+      AppendText(pText, pEnd, msg3);
+
+    pSlot->mRing.EndPush();
+    return true;
+  }
+
+  // Safe to read from any thread.
+  unsigned long long Dropped() const { return mDropped.load(std::memory_order_relaxed); }
+
+private:
+  DebugLogger(DebugLogger const&) = delete;
+  DebugLogger& operator=(DebugLogger const&) = delete;
+
+  struct Record
+  {
+    unsigned long long mCycles;
+    char const* mpFunction;               // __FUNCTION__, literal.
+    double mFloatValue;
+    int mLine;
+    int mIntValue;
+    Format mFormat;
+    char mText[TEXT_BYTES];               // Messages, each zero terminated.  Truncated to fit.
+  };
+
+  struct ThreadSlot
+  {
+    ThreadSlot()
+      : mClaimed(false)
+      , mOwnerExited(false)
+    {}
+
+    std::atomic<bool> mClaimed;
+    std::atomic<bool> mOwnerExited;       // Set by the owner's thread exit callback, cleared by writer on release.
+    DWORD mThreadId = 0uL;                // Written by the owner before its first push.
+    SpscRing<Record> mRing;
+  };
+
+  // Copies as much of pSrc as fits, zero terminated.  Returns position after the terminator.
+  static char* AppendText(char* pDst, char const* pEnd, char const* pSrc)
+  {
+    if (pDst >= pEnd)
+      return pDst;
+
+    if (pSrc == nullptr)
+      pSrc = "";
+
+    auto const available = static_cast<size_t>(pEnd - pDst) - 1u;
+    auto bytes = strlen(pSrc);
+    if (bytes > available)
+      bytes = available;
+
+    memcpy(pDst, pSrc, bytes);
+    pDst[bytes] = '\0';
+
+    return pDst + bytes + 1;
+  }
+
+  // Next message in the record text, or empty string if it was truncated away.
+  static char const* NextText(Record const& record, char const* pText)
+  {
+    auto const pEnd = record.mText + TEXT_BYTES;
+    if (pText < record.mText || pText >= pEnd)
+      return "";
+
+    auto const pNext = pText + strlen(pText) + 1;
+    return pNext < pEnd ? pNext : "";
+  }
+
+  // Claims a slot for the calling thread on its first message.  Returns nullptr if all slots are taken.
+  ThreadSlot* CurrentThreadSlot()
+  {
+    static PLATFORM_THREAD_LOCAL DebugLogger* tlsOwner = nullptr;
+    static PLATFORM_THREAD_LOCAL ThreadSlot* tlsSlot = nullptr;
+
+    if (tlsOwner == this)
+      return tlsSlot;
+
+    tlsOwner = this;
+    tlsSlot = nullptr;
+    for (unsigned int i = 0u; i < MAX_THREADS; ++i) {
+      auto expected = false;
+      if (mSlots[i].mClaimed.compare_exchange_strong(expected, true)) {
+        mSlots[i].mThreadId = GetCurrentThreadId();
+        tlsSlot = &mSlots[i];
+        if (mThreadExitKeyCreated)
+          Platform::SetThreadExitValue(mThreadExitKey, tlsSlot);
+
+        break;
+      }
+    }
+
+    return tlsSlot;
+  }
+
+  // Called on the exiting thread, after its last push.
+  static void PLATFORM_CALLBACK OnThreadExit(void* pValue)
+  {
+    static_cast<ThreadSlot*>(pValue)->mOwnerExited.store(true, std::memory_order_release);
+  }
+
+  static void WriterThreadProc(void* pContext)
+  {
+    static_cast<DebugLogger*>(pContext)->WriterLoop();
+  }
+
+  // Writer thread.
+  void WriterLoop()
+  {
+    // Give timestamp counter calibration some distance.  Records queue up meanwhile.
+    Platform::SleepMillis(CALIBRATION_MS);
+
+    auto lastFlushTicks = Platform::TickCountMillis();
+    auto droppedReported = 0uLL;
+    for (;;) {
+      // Read before draining, so that nothing pushed before the stop request is missed.
+      auto const stopRequested = mStopRequested.load();
+
+      Calibrate();
+      auto written = WriteQueuedRecords();
+      ReleaseExitedSlots();
+
+      auto const dropped = mDropped.load(std::memory_order_relaxed);
+      if (dropped != droppedReported) {
+        fprintf(mpFile, "DebugLogger : %llu message(s) dropped, writer is falling behind\n", dropped - droppedReported);
+        droppedReported = dropped;
+        written = true;
+      }
+
+      auto const ticksNow = Platform::TickCountMillis();
+      if (stopRequested || (written && ticksNow - lastFlushTicks > FLUSH_PERIOD_MS)) {
+        fflush(mpFile);
+        lastFlushTicks = ticksNow;
+      }
+
+      if (stopRequested)
+        break;
+
+      if (!written)
+        Platform::SleepMillis(WRITER_IDLE_SLEEP_MS);
+    }
+  }
+
+  // Writer thread.  Rate is measured over the whole run, so it gets more precise the longer logger runs.
+  void Calibrate()
+  {
+    auto const elapsedMicroseconds = Platform::TicksMicroseconds() - mStartMicroseconds;
+    if (elapsedMicroseconds > 0.0)
+      mCyclesPerSecond = static_cast<double>(Platform::CycleCounter() - mStartCycles) * 1000000.0 / elapsedMicroseconds;
+  }
+
+  // Writer thread.  Writes records in timestamp order across threads.  Returns true if anything was written.
+  bool WriteQueuedRecords()
+  {
+    auto written = false;
+    for (;;) {
+      ThreadSlot* pOldest = nullptr;
+      Record const* pOldestRecord = nullptr;
+      for (unsigned int i = 0u; i < MAX_THREADS; ++i) {
+        auto const pRecord = mSlots[i].mRing.Front();
+        if (pRecord != nullptr && (pOldestRecord == nullptr || pRecord->mCycles < pOldestRecord->mCycles)) {
+          pOldest = &mSlots[i];
+          pOldestRecord = pRecord;
+        }
+      }
+
+      if (pOldest == nullptr)
+        return written;
+
+      WriteRecord(pOldest->mThreadId, *pOldestRecord);
+      pOldest->mRing.Pop();
+      written = true;
+    }
+  }
+
+  // Writer thread.  Hands slots of exited threads back for claiming.  Ring is drained first, so that the next owner
+  // continues from an empty ring, and the exited thread's records are still written with its thread id.
+  void ReleaseExitedSlots()
+  {
+    for (unsigned int i = 0u; i < MAX_THREADS; ++i) {
+      auto& slot = mSlots[i];
+      if (!slot.mOwnerExited.load(std::memory_order_acquire) || slot.mRing.Front() != nullptr)
+        continue;
+
+      slot.mOwnerExited.store(false, std::memory_order_relaxed);
+      slot.mClaimed.store(false, std::memory_order_release);
+    }
+  }
+
+  // Writer thread.
+  void WriteRecord(DWORD threadId, Record const& record)
+  {
+    auto const seconds = mCyclesPerSecond > 0.0
+      ? static_cast<double>(static_cast<long long>(record.mCycles - mStartCycles)) / mCyclesPerSecond
+      : 0.0;
+
+    fprintf(mpFile, "TID:0x%04x  %10.6f  ", threadId, seconds);
+
+    auto const pFormat = FormatString(record.mFormat);
+    auto const msg = record.mText;
+    switch (record.mFormat) {
+    case Format::Int2:
+      fprintf(mpFile, pFormat, record.mpFunction, record.mLine, msg, record.mIntValue);
+      break;
+    case Format::Float2:
+      fprintf(mpFile, pFormat, record.mpFunction, record.mLine, msg, record.mFloatValue);
+      break;
+    default:
+      {
+        auto const msg2 = NextText(record, msg);
+        auto const msg3 = NextText(record, msg2);
+        fprintf(mpFile, pFormat, record.mpFunction, record.mLine, msg, msg2, msg3);
+      }
+      break;
+    }
+  }
+
+  void ReleaseResources()
+  {
+    assert(mhWriterThread == nullptr);
+
+    for (unsigned int i = 0u; i < MAX_THREADS; ++i)
+      mSlots[i].mRing.ReleaseResources();
+  }
+
+  // Shared between logging threads and writer thread.
+  ThreadSlot mSlots[MAX_THREADS];
+  std::atomic<bool> mAccepting;
+  std::atomic<bool> mStopRequested;
+  std::atomic<unsigned long long> mDropped;
+
+  // Set by Start before writer thread starts.
+  Platform::ThreadHandle mhWriterThread = nullptr;
+  FILE* mpFile = nullptr;
+  Platform::ThreadExitKey mThreadExitKey = {};
+  bool mThreadExitKeyCreated = false;
+  unsigned long long mStartCycles = 0uLL;
+  double mStartMicroseconds = 0.0;
+
+  // Writer thread only.
+  double mCyclesPerSecond = 0.0;
+};
@@ -19,7 +19,9 @@
 
 #include "PluginObjects.hpp"     // base class for plugin objects to derive from
 #include <cmath>                 // for sqrt()
+#ifdef _WIN32
 #include <windows.h>             // for HWND
+#endif
 
 
 // rF and plugins must agree on structure packing, so set it explicitly here ... whatever the current
@@ -0,0 +1,209 @@
+/*
+Definition of MappedControlInput<> class.
+
+Author: The Iron Wolf (vleonavicius@hotmail.com)
+Website: thecrewchief.org
+
+Description:
+  MappedControlInput<> maps the control command queue external processes post to (see rF2ControlInput for the
+  producer protocol), and keeps the table of controls currently overridden by those commands.
+
+  Plugin is the only consumer.  Drain() is called once per frame: if nothing was posted, it costs a single load of
+  the next slot's ticket.  Commands are applied to the override table in order, and Report() answers CheckHWControl
+  from that table.  Drain stops at a command for a control whose previous value game has not seen yet, so a quick
+  press/release pair posted within a frame still reaches the game as a press followed by a release.  Game might never
+  ask for a control (misspelled name), so drain waits for it at most MAX_REPORT_WAIT_DRAINS frames.
+*/
+#pragma once
+
+#include <atomic>
+#include <string.h>
+#include "Platform.h"
+
+template <typename InputT, typename CommandT>
+class MappedControlInput
+{
+  // See DependentPlugin.
+  typedef typename DependentPlugin<InputT>::Type SharedMemoryPlugin;
+
+public:
+  static int const MAX_OVERRIDES = 16;
+  static int const MAX_REPORT_WAIT_DRAINS = 4;
+
+  MappedControlInput(char const* mmFileName)
+    : MM_FILE_NAME(mmFileName)
+  {}
+
+  ~MappedControlInput()
+  {
+    ReleaseResources();
+  }
+
+  bool Initialize()
+  {
+    assert(!mMapped);
+
+    void* pView = nullptr;
+    mhMap = Platform::MapMemoryFile(MM_FILE_NAME, sizeof(InputT), pView);
+    if (mhMap == nullptr) {
+      DEBUG_MSG(DebugLevel::Errors, "Failed to map control input file");
+      return false;
+    }
+
+    mpInput = static_cast<InputT*>(pView);
+
+    // File might be mapped by producers already, so keep positions moving forward.  Anything posted while plugin was
+    // not running is dropped.
+    mReadPosition = *static_cast<long const volatile*>(&mpInput->mEnqueuePosition);
+    for (auto position = mReadPosition; position != mReadPosition + InputT::MAX_COMMANDS; ++position)
+      SlotAt(position).mTicket = position;
+
+    mpInput->mMaxCommands = InputT::MAX_COMMANDS;
+    std::atomic_thread_fence(std::memory_order_release);
+
+    mNumOverrides = 0;
+    mMapped = true;
+
+    return true;
+  }
+
+  // Applies posted commands to the override table.  Returns number of commands applied.
+  int Drain()
+  {
+    assert(mMapped);
+
+    auto numApplied = 0;
+    for (;;) {
+      auto& slot = SlotAt(mReadPosition);
+      if (*static_cast<long const volatile*>(&slot.mTicket) != mReadPosition + 1L)
+        return numApplied;  // Empty, or producer is still filling the slot.
+
+      // Command contents have to be read after the ticket.
+      std::atomic_thread_fence(std::memory_order_acquire);
+
+      char controlName[CommandT::CONTROL_NAME_CHARS] = {};
+      memcpy(controlName, slot.mControlName, sizeof(controlName) - 1);
+
+      auto const overrideIndex = FindOverride(controlName);
+      if (overrideIndex != -1
+        && !mOverrides[overrideIndex].mReported
+        && ++mOverrides[overrideIndex].mDrainsWaited <= MAX_REPORT_WAIT_DRAINS)
+        return numApplied;  // Let the game see the previous value first.
+
+      Apply(overrideIndex, controlName, slot.mValue, slot.mFrames);
+
+      // Done with the slot, hand it back to producers for the position one lap ahead.
+      std::atomic_thread_fence(std::memory_order_release);
+      *static_cast<long volatile*>(&slot.mTicket) = mReadPosition + InputT::MAX_COMMANDS;
+
+      ++mReadPosition;
+      ++numApplied;
+    }
+  }
+
+  // Returns true and sets value if control is overridden.
+  bool Report(char const* const controlName, double& value)
+  {
+    if (mNumOverrides == 0)
+      return false;
+
+    auto const overrideIndex = FindOverride(controlName);
+    if (overrideIndex == -1)
+      return false;
+
+    auto& controlOverride = mOverrides[overrideIndex];
+    value = controlOverride.mValue;
+    controlOverride.mReported = true;
+
+    if (controlOverride.mCallsLeft > 0L && --controlOverride.mCallsLeft == 0L)
+      RemoveOverride(overrideIndex);
+
+    return true;
+  }
+
+  void ReleaseResources()
+  {
+    // Unmap view and close the handle.
+    if (!Platform::UnmapMemoryFile(mhMap, mpInput))
+      DEBUG_MSG(DebugLevel::Errors, "Failed to unmap control input");
+
+    mpInput = nullptr;
+    mhMap = nullptr;
+    mNumOverrides = 0;
+    mMapped = false;
+  }
+
+  bool IsMapped() const { return mMapped; }
+
+private:
+  MappedControlInput(MappedControlInput const& rhs) = delete;
+  MappedControlInput& operator =(MappedControlInput const& rhs) = delete;
+
+  struct ControlOverride
+  {
+    char mControlName[CommandT::CONTROL_NAME_CHARS];
+    double mValue;
+    long mCallsLeft;               // 0 means until the next command for the control.
+    bool mReported;                // Game has seen mValue at least once.
+    int mDrainsWaited;             // Drains that stopped at the next command for the control, because mValue was not reported.
+  };
+
+  CommandT& SlotAt(long position)
+  {
+    return mpInput->mCommands[static_cast<unsigned long>(position) % InputT::MAX_COMMANDS];
+  }
+
+  int FindOverride(char const* controlName) const
+  {
+    for (int i = 0; i < mNumOverrides; ++i) {
+      if (_stricmp(mOverrides[i].mControlName, controlName) == 0)
+        return i;
+    }
+
+    return -1;
+  }
+
+  void RemoveOverride(int overrideIndex)
+  {
+    mOverrides[overrideIndex] = mOverrides[mNumOverrides - 1];
+    --mNumOverrides;
+  }
+
+  void Apply(int overrideIndex, char const* controlName, double value, long frames)
+  {
+    if (frames < 0L) {
+      if (overrideIndex != -1)
+        RemoveOverride(overrideIndex);
+
+      return;
+    }
+
+    if (overrideIndex == -1) {
+      if (mNumOverrides == MAX_OVERRIDES) {
+        DEBUG_MSG2(DebugLevel::Warnings, "WARNING: Too many controls overridden, command dropped for:", controlName);
+        return;
+      }
+
+      overrideIndex = mNumOverrides++;
+      strcpy_s(mOverrides[overrideIndex].mControlName, controlName);
+    }
+
+    auto& controlOverride = mOverrides[overrideIndex];
+    controlOverride.mValue = value;
+    controlOverride.mCallsLeft = frames;
+    controlOverride.mReported = false;
+    controlOverride.mDrainsWaited = 0;
+  }
+
+  char const* const MM_FILE_NAME;
+
+  Platform::MapHandle mhMap = nullptr;
+  InputT* mpInput = nullptr;
+
+  // Position of the next command to consume.
+  long mReadPosition = 0L;
+
+  ControlOverride mOverrides[MAX_OVERRIDES] = {};
+  int mNumOverrides = 0;
+  bool mMapped = false;
+};
@@ -13,23 +13,53 @@ Description:
 
   Flip operation also supports retry mode, where flip is cancelled if mutex is signaled
   (to avoid blocking the thread).
+
+  Regardless of the synchronization mode, each buffer's mSequence counter is maintained (see Seqlock.h):
+  write buffer always has odd counter, and it is made even when buffer is published by the flip.  In
+  SyncMode::Seqlock mode, mutex is not created at all, flips never wait, and clients are expected
+  to validate their copies using the sequence counter.
+
+  In SyncMode::MultiBuffer mode, instead of two files, single file containing rF2MultiBufferControl
+  block followed by N (3 or more) buffers is mapped.  Index of the newest complete buffer is published
+  via rF2MultiBufferControl::mLatest, and clients register in mReaders while copying a buffer.  On flip,
+  the least recently published buffer that nobody reads becomes the write buffer, so the writer never
+  waits and never retries.  Only if all buffers except the latest one are held by readers, the least
+  recently published buffer is overwritten (sequence counter lets readers detect that).
+
+  If flip notification is enabled (SharedMemoryPlugin::msFlipNotification), named auto reset event is signaled
+  after each flip, so that a client can block on it instead of polling mCurrentRead/mLatest.  Event is signaled
+  after mutex is released, so the woken client does not immediately block on the mutex.
+
+  Flips, retries, overwrites and mutex wait times are counted in rF2BufferStats (see Stats()), which plugin
+  publishes in the statistics buffer.
 */
 #pragma once
 
+#include "Seqlock.h"
+#include "Platform.h"
+#include "StatsHistogram.h"
+
 template <typename BuffT>
 class MappedDoubleBuffer
 {
+  // See DependentPlugin.
+  typedef typename DependentPlugin<BuffT>::Type SharedMemoryPlugin;
+
 public:
 
   MappedDoubleBuffer(
     int maxRetries
     , char const* mmFileName1
     , char const* mmFileName2
-    , char const* mmMutexName) 
+    , char const* mmMutexName
+    , char const* mmMultiBufferFileName
+    , char const* mmFlipEventName)
     : MAX_RETRIES(maxRetries)
     , MM_FILE_NAME1(mmFileName1)
     , MM_FILE_NAME2(mmFileName2)
     , MM_FILE_ACCESS_MUTEX(mmMutexName)
+    , MM_MULTI_BUFFER_FILE_NAME(mmMultiBufferFileName)
+    , MM_FLIP_EVENT_NAME(mmFlipEventName)
   {}
 
   ~MappedDoubleBuffer()
@@ -37,25 +67,47 @@ public:
     ReleaseResources();
   }
 
-  bool Initialize()
+  // Buffer types ending in a variable length part can map less than sizeof(BuffT), see rF2LiteTelemetry.
+  bool Initialize(int bufferBytes = static_cast<int>(sizeof(BuffT)))
   {
     assert(!mMapped);
-    mhMap1 = MapMemoryFile(MM_FILE_NAME1, mpBuf1);
+    assert(bufferBytes > 0 && bufferBytes <= static_cast<int>(sizeof(BuffT)));
+    mBufferBytes = bufferBytes;
+
+    if (SharedMemoryPlugin::msFlipNotification) {
+      // Notification is optional, buffer works without it (NotifyFlip skips null event).
+      mhFlipEvent = Platform::CreateNamedEvent(MM_FLIP_EVENT_NAME);
+      if (mhFlipEvent == nullptr)
+        DEBUG_MSG(DebugLevel::Warnings, "WARNING: Failed to create flip event, flips will not be signaled");
+    }
+
+    if (SharedMemoryPlugin::msSyncMode == SyncMode::MultiBuffer)
+      return InitializeMultiBuffer();
+
+    void* pView = nullptr;
+    mhMap1 = Platform::MapMemoryFile(MM_FILE_NAME1, mBufferBytes, pView);
     if (mhMap1 == nullptr) {
       DEBUG_MSG(DebugLevel::Errors, "Failed to map file 1");
       return false;
     }
 
-    mhMap2 = MapMemoryFile(MM_FILE_NAME2, mpBuf2);
+    mpBuf1 = static_cast<BuffT*>(pView);
+
+    mhMap2 = Platform::MapMemoryFile(MM_FILE_NAME2, mBufferBytes, pView);
     if (mhMap2 == nullptr) {
       DEBUG_MSG(DebugLevel::Errors, "Failed to map file 2");
       return false;
     }
 
-    mhMutex = CreateMutex(nullptr, FALSE, MM_FILE_ACCESS_MUTEX);
-    if (mhMutex == nullptr) {
-      DEBUG_MSG(DebugLevel::Errors, "Failed to create mutex");
-      return false;
+    mpBuf2 = static_cast<BuffT*>(pView);
+
+    mUseMutex = SharedMemoryPlugin::msSyncMode == SyncMode::Mutex;
+    if (mUseMutex) {
+      mhMutex = Platform::CreateNamedLock(MM_FILE_ACCESS_MUTEX);
+      if (mhMutex == nullptr) {
+        DEBUG_MSG(DebugLevel::Errors, "Failed to create mutex");
+        return false;
+      }
     }
 
     mMapped = true;
@@ -64,6 +116,12 @@ public:
   }
 
   void ClearState(BuffT const* pInitialContents)
+  {
+    ClearState(pInitialContents, pInitialContents != nullptr ? mBufferBytes : 0);
+  }
+
+  // Copies first initialContentsBytes of pInitialContents into each buffer, and zeroes the rest.
+  void ClearState(void const* pInitialContents, int initialContentsBytes)
   {
     if (!mMapped) {
       assert(mMapped);
@@ -74,28 +132,44 @@ public:
     mRetryPending = false;
     mAsyncRetriesLeft = MAX_RETRIES;
 
-    auto ret = WaitForSingleObject(mhMutex, SharedMemoryPlugin::msMillisMutexWait);
-
-    if (pInitialContents != nullptr) {
-      memcpy(mpBuf1, pInitialContents, sizeof(BuffT));
-      memcpy(mpBuf2, pInitialContents, sizeof(BuffT));
-    }
-    else {
-      memset(mpBuf1, 0, sizeof(BuffT));
-      memset(mpBuf2, 0, sizeof(BuffT));
+    if (mMultiBuffer) {
+      ClearMultiBufferState(pInitialContents, initialContentsBytes);
+      return;
     }
 
+    auto const ret = mUseMutex ? Platform::AcquireLock(mhMutex, SharedMemoryPlugin::msMillisMutexWait) : Platform::WaitResult::Signaled;
+
+    // Buffers might be mapped by clients already, so keep sequence counters moving forward
+    // in case someone is in the middle of a copy.
+    Seqlock::BeginWrite(mpBuf1);
+    Seqlock::BeginWrite(mpBuf2);
+    auto const sequence = max(Seqlock::LoadSequence(mpBuf1), Seqlock::LoadSequence(mpBuf2));
+
+    ResetContents(mpBuf1, pInitialContents, initialContentsBytes);
+    ResetContents(mpBuf2, pInitialContents, initialContentsBytes);
+
+    // Restore counters clobbered above.  Buffer 1 is published, buffer 2 is the write buffer.
+    Seqlock::StoreSequence(mpBuf1, sequence);
+    Seqlock::StoreSequence(mpBuf2, sequence + 2u);
+
     mpBuf1->mCurrentRead = true;
     mpBuf2->mCurrentRead = false;
 
+    Seqlock::EndWrite(mpBuf1);
+
     mpCurReadBuf = mpBuf1;
     mpCurWriteBuf = mpBuf2;
     assert(mpCurReadBuf->mCurrentRead);
     assert(!mpCurWriteBuf->mCurrentRead);
+    assert(!Seqlock::IsWriteInProgress(Seqlock::LoadSequence(mpCurReadBuf)));
+    assert(Seqlock::IsWriteInProgress(Seqlock::LoadSequence(mpCurWriteBuf)));
+
+    if (!mUseMutex)
+      return;
 
-    if (ret == WAIT_OBJECT_0)
-      ReleaseMutex(mhMutex);
-    else if (ret == WAIT_TIMEOUT)
+    if (Platform::IsLockAcquired(ret))
+      Platform::ReleaseLock(mhMutex);
+    else if (ret == Platform::WaitResult::TimedOut)
       DEBUG_MSG(DebugLevel::Warnings, "WARNING: - Timed out while waiting on mutex.");
     else
       DEBUG_MSG(DebugLevel::Errors, "ERROR: - wait on mutex failed.");
@@ -103,30 +177,41 @@ public:
 
   void ReleaseResources()
   {
+    if (mMultiBuffer) {
+      // Buffers are views into the multi buffer mapping, and are unmapped with it below.
+      mpBuf1 = nullptr;
+      mpBuf2 = nullptr;
+    }
+
     // Unmap views and close all handles.
-    BOOL ret = TRUE;
-    if (mpBuf1 != nullptr) ret = UnmapViewOfFile(mpBuf1);
-    if (!ret) DEBUG_MSG(DebugLevel::Errors, "Failed to unmap buffer1");
+    if (!Platform::UnmapMemoryFile(mhMap1, mpBuf1))
+      DEBUG_MSG(DebugLevel::Errors, "Failed to unmap buffer1");
 
-    if (mpBuf2 != nullptr) ret = UnmapViewOfFile(mpBuf2);
-    if (!ret) DEBUG_MSG(DebugLevel::Errors, "Failed to unmap buffer2");
+    if (!Platform::UnmapMemoryFile(mhMap2, mpBuf2))
+      DEBUG_MSG(DebugLevel::Errors, "Failed to unmap buffer2");
 
-    if (mhMap1 != nullptr) ret = CloseHandle(mhMap1);
-    if (!ret) DEBUG_MSG(DebugLevel::Errors, "Failed to close map1 handle");
+    if (mhMutex != nullptr && !Platform::CloseLock(mhMutex))
+      DEBUG_MSG(DebugLevel::Errors, "Failed to close mutex handle");
 
-    if (mhMap2 != nullptr) ret = CloseHandle(mhMap2);
-    if (!ret) DEBUG_MSG(DebugLevel::Errors, "Failed to close map2 handle");
+    if (mhFlipEvent != nullptr && !Platform::CloseEvent(mhFlipEvent))
+      DEBUG_MSG(DebugLevel::Errors, "Failed to close flip event handle");
 
-    if (mhMutex != nullptr) ret = CloseHandle(mhMutex);
-    if (!ret) DEBUG_MSG(DebugLevel::Errors, "Failed to close mutex handle");
+    if (!Platform::UnmapMemoryFile(mhMultiMap, mpControl))
+      DEBUG_MSG(DebugLevel::Errors, "Failed to unmap multi buffer");
 
     mpBuf1 = nullptr;
     mpBuf2 = nullptr;
     mhMap1 = nullptr;
     mhMap2 = nullptr;
     mhMutex = nullptr;
+    mhFlipEvent = nullptr;
+    mpControl = nullptr;
+    mhMultiMap = nullptr;
+    memset(mpBufs, 0, sizeof(mpBufs));
     mpCurWriteBuf = nullptr;
     mpCurReadBuf = nullptr;
+    mMapped = false;
+    mMultiBuffer = false;
   }
 
   void FlipBuffersHelper()
@@ -137,6 +222,13 @@ public:
       return;
     }
 
+    ++mStats.mFlips;
+
+    if (mMultiBuffer) {
+      FlipMultiBufferHelper();
+      return;
+    }
+
     // Handle fucked up case:
     if (mpBuf1->mCurrentRead == mpBuf2->mCurrentRead) {
       mpBuf1->mCurrentRead = true;
@@ -152,10 +244,16 @@ public:
     // Pick previous read buffer.
     mpCurWriteBuf = mpBuf1->mCurrentRead ? mpBuf1 : mpBuf2;
 
+    // Publish contents of the new read buffer.
+    Seqlock::EndWrite(mpCurReadBuf);
+
     // Switch the read and write buffers.
     mpBuf1->mCurrentRead = !mpBuf1->mCurrentRead;
     mpBuf2->mCurrentRead = !mpBuf2->mCurrentRead;
 
+    // Previous read buffer will be written to from now on.
+    Seqlock::BeginWrite(mpCurWriteBuf);
+
     assert(!mpCurWriteBuf->mCurrentRead);
     assert(mpCurReadBuf->mCurrentRead);
   }
@@ -173,16 +271,30 @@ public:
     mRetryPending = false;
     mAsyncRetriesLeft = MAX_RETRIES;
 
-    auto const ret = WaitForSingleObject(mhMutex, SharedMemoryPlugin::msMillisMutexWait);
+    if (!mUseMutex) {
+      FlipBuffersHelper();
+      NotifyFlip();
+      return;
+    }
+
+    ++mStats.mForcedFlips;
+
+    auto const ret = AcquireLockTimed(SharedMemoryPlugin::msMillisMutexWait);
 
     FlipBuffersHelper();
 
-    if (ret == WAIT_OBJECT_0)
-      ReleaseMutex(mhMutex);
-    else if (ret == WAIT_TIMEOUT)
+    if (Platform::IsLockAcquired(ret))
+      Platform::ReleaseLock(mhMutex);
+    else if (ret == Platform::WaitResult::TimedOut) {
+      ++mStats.mOverwrites;
       DEBUG_MSG(DebugLevel::Warnings, "WARNING: - Timed out while waiting on mutex.");
-    else
+    }
+    else {
+      ++mStats.mOverwrites;
       DEBUG_MSG(DebugLevel::Errors, "ERROR: - wait on mutex failed.");
+    }
+
+    NotifyFlip();
   }
 
   void TryFlipBuffers()
@@ -194,10 +306,11 @@ public:
     }
 
     // Do not wait on mutex if it is held.
-    auto const ret = WaitForSingleObject(mhMutex, 0);
-    if (ret == WAIT_TIMEOUT) {
+    auto const ret = mUseMutex ? AcquireLockTimed(0) : Platform::WaitResult::Signaled;
+    if (ret == Platform::WaitResult::TimedOut) {
       mRetryPending = true;
       --mAsyncRetriesLeft;
+      ++mStats.mRetries;
       return;
     }
 
@@ -208,56 +321,167 @@ public:
     // Do the actual flip.
     FlipBuffersHelper();
 
-    if (ret == WAIT_OBJECT_0)
-      ReleaseMutex(mhMutex);
+    if (mUseMutex && Platform::IsLockAcquired(ret))
+      Platform::ReleaseLock(mhMutex);
+
+    NotifyFlip();
   }
 
   int AsyncRetriesLeft() const { return mAsyncRetriesLeft; }
   int RetryPending() const { return mRetryPending; }
+  bool IsMapped() const { return mMapped; }
+
+  // Counters since construction, not reset by ClearState.
+  rF2BufferStats const& Stats() const { return mStats; }
 
 private:
   MappedDoubleBuffer(MappedDoubleBuffer const&) = delete;
   MappedDoubleBuffer& operator=(MappedDoubleBuffer const&) = delete;
 
-  HANDLE MapMemoryFile(char const* const fileName, BuffT*& pBuf) const
+  Platform::WaitResult AcquireLockTimed(DWORD millis)
   {
-    char tag[256] = {};
-    strcpy_s(tag, fileName);
-
-    char exe[1024] = {};
-    GetModuleFileName(nullptr, exe, sizeof(exe));
-
-    char pid[8] = {};
-    sprintf(pid, "%d", GetCurrentProcessId());
-
-    // Append processId for dedicated server to allow multiple instances
-    // TODO: Verify for rF2.
-    if (strstr(exe, "Dedicated.exe") != nullptr)
-      strcat(tag, pid);
-
-    // Init handle and try to create, read if existing
-    HANDLE hMap = INVALID_HANDLE_VALUE;
-    hMap = CreateFileMapping(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, sizeof(BuffT), TEXT(tag));
-    if (hMap == nullptr) {
-      if (GetLastError() == ERROR_ALREADY_EXISTS) {
-        hMap = OpenFileMapping(FILE_MAP_ALL_ACCESS, FALSE, TEXT(tag));
-        if (hMap == nullptr) {
-          return nullptr;
-        }
-      }
+    auto const waitStartTicks = Platform::TicksMicroseconds();
+    auto const ret = Platform::AcquireLock(mhMutex, millis);
+
+    ++mStats.mMutexWaits;
+    StatsHistogram::AddLog2(mStats.mMutexWaitHistogram, StatsHistogram::MicrosecondsToNanoseconds(Platform::TicksMicroseconds() - waitStartTicks));
+
+    return ret;
+  }
+
+  void NotifyFlip()
+  {
+    if (mhFlipEvent != nullptr)
+      Platform::SignalEvent(mhFlipEvent);
+  }
+
+  bool InitializeMultiBuffer()
+  {
+    mMultiBuffer = true;
+    mUseMutex = false;
+
+    mNumBuffers = max(3, min(SharedMemoryPlugin::msMultiBufferCount, static_cast<int>(rF2MultiBufferControl::MAX_BUFFERS)));
+
+    // Keep each buffer cache line aligned, so that writes to one never touch lines of the other.
+    auto const bufferStride = (mBufferBytes + CACHE_LINE_BYTES - 1) & ~(CACHE_LINE_BYTES - 1);
+    auto const firstBufferOffset = (static_cast<int>(sizeof(rF2MultiBufferControl)) + CACHE_LINE_BYTES - 1) & ~(CACHE_LINE_BYTES - 1);
+
+    void* pView = nullptr;
+    mhMultiMap = Platform::MapMemoryFile(MM_MULTI_BUFFER_FILE_NAME, firstBufferOffset + mNumBuffers * bufferStride, pView);
+    if (mhMultiMap == nullptr) {
+      DEBUG_MSG(DebugLevel::Errors, "Failed to map multi buffer file");
+      return false;
     }
 
-    pBuf = static_cast<BuffT*>(MapViewOfFile(hMap, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(BuffT)));
-    if (pBuf == nullptr) {
-      // Failed to map memory buffer
-      CloseHandle(hMap);
-      return nullptr;
+    mpControl = static_cast<rF2MultiBufferControl*>(pView);
+    memset(mpControl, 0, sizeof(rF2MultiBufferControl));
+    mpControl->mNumBuffers = mNumBuffers;
+    mpControl->mBufferBytes = mBufferBytes;
+    mpControl->mBufferStride = bufferStride;
+    mpControl->mFirstBufferOffset = firstBufferOffset;
+
+    for (int i = 0; i < mNumBuffers; ++i)
+      mpBufs[i] = reinterpret_cast<BuffT*>(static_cast<char*>(pView) + firstBufferOffset + i * bufferStride);
+
+    // Keep those pointing somewhere valid, they're used by tracing code.
+    mpBuf1 = mpBufs[0];
+    mpBuf2 = mpBufs[1];
+
+    mMapped = true;
+
+    return true;
+  }
+
+  void ResetContents(BuffT* pBuf, void const* pInitialContents, int initialContentsBytes)
+  {
+    if (pInitialContents != nullptr)
+      memcpy(pBuf, pInitialContents, initialContentsBytes);
+    else
+      initialContentsBytes = 0;
+
+    memset(reinterpret_cast<char*>(pBuf) + initialContentsBytes, 0, mBufferBytes - initialContentsBytes);
+  }
+
+  void ClearMultiBufferState(void const* pInitialContents, int initialContentsBytes)
+  {
+    auto sequence = 0u;
+    for (int i = 0; i < mNumBuffers; ++i) {
+      Seqlock::BeginWrite(mpBufs[i]);
+      sequence = max(sequence, Seqlock::LoadSequence(mpBufs[i]));
+    }
+
+    for (int i = 0; i < mNumBuffers; ++i) {
+      ResetContents(mpBufs[i], pInitialContents, initialContentsBytes);
+
+      // Restore counters clobbered above.  Buffer 0 is published, the rest are not.
+      Seqlock::StoreSequence(mpBufs[i], i == 0 ? sequence : sequence + 2u);
+      mpBufs[i]->mCurrentRead = i == 0;
+      mLastPublished[i] = 0uLL;
+    }
+
+    Seqlock::EndWrite(mpBufs[0]);
+    InterlockedExchange(&mpControl->mLatest, 0L);
+
+    mLatestIndex = 0;
+    mWriteIndex = 1;
+    mpCurReadBuf = mpBufs[mLatestIndex];
+    mpCurWriteBuf = mpBufs[mWriteIndex];
+  }
+
+  void FlipMultiBufferHelper()
+  {
+    auto const newLatestIndex = mWriteIndex;
+
+    // Publish contents of the write buffer.
+    Seqlock::EndWrite(mpBufs[newLatestIndex]);
+    mpBufs[mLatestIndex]->mCurrentRead = false;
+    mpBufs[newLatestIndex]->mCurrentRead = true;
+
+    // Interlocked operation is a full barrier: new mLatest is visible before reader counts are
+    // checked below.  Together with readers re-checking mLatest after registering, this guarantees
+    // that a buffer registered by a reader is never picked for writing.
+    InterlockedExchange(&mpControl->mLatest, static_cast<long>(newLatestIndex));
+
+    mLatestIndex = newLatestIndex;
+    mLastPublished[newLatestIndex] = ++mPublishCount;
+
+    // Pick least recently published buffer that nobody reads.
+    auto freeIndex = -1;
+    auto oldestIndex = -1;
+    for (int i = 0; i < mNumBuffers; ++i) {
+      if (i == newLatestIndex)
+        continue;
+
+      if (oldestIndex == -1 || mLastPublished[i] < mLastPublished[oldestIndex])
+        oldestIndex = i;
+
+      auto const numReaders = *static_cast<long const volatile*>(&mpControl->mReaders[i]);
+      if (numReaders <= 0L
+        && (freeIndex == -1 || mLastPublished[i] < mLastPublished[freeIndex]))
+        freeIndex = i;
+    }
+
+    if (freeIndex == -1) {
+      // All buffers are held by readers (or reader died while holding one).  Overwrite, readers
+      // will see sequence counter change.
+      DEBUG_MSG(DebugLevel::Synchronization, "All buffers are being read, overwriting least recently published one.");
+      freeIndex = oldestIndex;
+      ++mStats.mOverwrites;
     }
 
-    return hMap;
+    mWriteIndex = freeIndex;
+    mpCurReadBuf = mpBufs[mLatestIndex];
+    mpCurWriteBuf = mpBufs[mWriteIndex];
+
+    Seqlock::BeginWrite(mpCurWriteBuf);
+
+    assert(mpCurReadBuf->mCurrentRead);
+    assert(!mpCurWriteBuf->mCurrentRead);
   }
 
   public:
+    static int const CACHE_LINE_BYTES = 64;
+
     // Flip between 2 buffers.  Clients should read the one with mCurrentRead == true.
     BuffT* mpBuf1 = nullptr;
     BuffT* mpBuf2 = nullptr;
@@ -270,13 +494,33 @@ private:
     char const* const MM_FILE_NAME1;
     char const* const MM_FILE_NAME2;
     char const* const MM_FILE_ACCESS_MUTEX;
-
-    HANDLE mhMutex = nullptr;
-    HANDLE mhMap1 = nullptr;
-    HANDLE mhMap2 = nullptr;
+    char const* const MM_MULTI_BUFFER_FILE_NAME;
+    char const* const MM_FLIP_EVENT_NAME;
+
+    Platform::LockHandle mhMutex = nullptr;
+    Platform::EventHandle mhFlipEvent = nullptr;
+    Platform::MapHandle mhMap1 = nullptr;
+    Platform::MapHandle mhMap2 = nullptr;
+
+    // SyncMode::MultiBuffer state.
+    bool mMultiBuffer = false;
+    Platform::MapHandle mhMultiMap = nullptr;
+    rF2MultiBufferControl* mpControl = nullptr;
+    BuffT* mpBufs[rF2MultiBufferControl::MAX_BUFFERS] = {};
+    unsigned long long mLastPublished[rF2MultiBufferControl::MAX_BUFFERS] = {};
+    unsigned long long mPublishCount = 0uLL;
+    int mNumBuffers = 2;
+    int mLatestIndex = 0;
+    int mWriteIndex = 1;
+
+    // Bytes mapped per buffer.
+    int mBufferBytes = static_cast<int>(sizeof(BuffT));
 
     bool mRetryPending = false;
     int mAsyncRetriesLeft = 0;
 
+    rF2BufferStats mStats = {};
+
+    bool mUseMutex = true;
     bool mMapped = false;
 };
\ No newline at end of file
@@ -0,0 +1,136 @@
+/*
+Definition of MappedHistoryRing<> class.
+
+Author: The Iron Wolf (vleonavicius@hotmail.com)
+Website: thecrewchief.org
+
+Description:
+  MappedHistoryRing<> keeps last N complete frames in a memory mapped ring, so that clients polling
+  slower than the update rate can catch up on frames they missed.
+
+  Mapped file starts with HeaderT (see rF2TelemetryHistory), followed by N SlotT slots (see
+  rF2TelemetryHistorySlot).  Frame number F is stored in slot F % N.  Both header and slots are
+  published using sequence counters (see Seqlock.h), so plugin never waits for clients.
+
+  Client drain protocol:
+    1. Read mLastFrameNumber from the header (validate with header's mSequence).
+    2. For each frame F after the last frame client has seen (but no older than mLastFrameNumber - N + 1),
+       copy slot F % N, validating with slot's mSequence.  If slot's mFrameNumber != F, the frame got
+       overwritten (client fell more than N frames behind), skip it.
+*/
+#pragma once
+
+#include "Seqlock.h"
+#include "Platform.h"
+
+template <typename HeaderT, typename SlotT>
+class MappedHistoryRing
+{
+  // See DependentPlugin.
+  typedef typename DependentPlugin<SlotT>::Type SharedMemoryPlugin;
+
+public:
+  static int const MAX_FRAMES = 512;
+  static int const CACHE_LINE_BYTES = 64;
+
+  MappedHistoryRing(char const* mmFileName)
+    : MM_FILE_NAME(mmFileName)
+  {}
+
+  ~MappedHistoryRing()
+  {
+    ReleaseResources();
+  }
+
+  bool Initialize(int numFrames)
+  {
+    assert(!mMapped);
+    assert(numFrames > 0 && numFrames <= MappedHistoryRing::MAX_FRAMES);
+
+    mNumSlots = numFrames;
+
+    // Keep slots cache line aligned.
+    mSlotStride = (static_cast<int>(sizeof(SlotT)) + CACHE_LINE_BYTES - 1) & ~(CACHE_LINE_BYTES - 1);
+    auto const firstSlotOffset = (static_cast<int>(sizeof(HeaderT)) + CACHE_LINE_BYTES - 1) & ~(CACHE_LINE_BYTES - 1);
+
+    void* pView = nullptr;
+    mhMap = Platform::MapMemoryFile(MM_FILE_NAME, firstSlotOffset + mNumSlots * mSlotStride, pView);
+    if (mhMap == nullptr) {
+      DEBUG_MSG(DebugLevel::Errors, "Failed to map history file");
+      return false;
+    }
+
+    mpHeader = static_cast<HeaderT*>(pView);
+    mpFirstSlot = static_cast<char*>(pView) + firstSlotOffset;
+
+    // File might be mapped by clients already, so keep counters moving forward.
+    Seqlock::BeginWrite(mpHeader);
+    mFrameNumber = mpHeader->mLastFrameNumber;
+    mpHeader->mNumSlots = mNumSlots;
+    mpHeader->mSlotStride = mSlotStride;
+    mpHeader->mFirstSlotOffset = firstSlotOffset;
+    Seqlock::EndWrite(mpHeader);
+
+    mMapped = true;
+
+    return true;
+  }
+
+  // Returns slot for the next frame, frame number and ET are already set.  Caller fills the rest, and calls EndFrame.
+  SlotT* BeginFrame(double elapsedTime)
+  {
+    assert(mMapped);
+
+    ++mFrameNumber;
+
+    auto const pSlot = reinterpret_cast<SlotT*>(mpFirstSlot + static_cast<int>(mFrameNumber % mNumSlots) * mSlotStride);
+
+    Seqlock::BeginWrite(pSlot);
+
+    pSlot->mFrameNumber = mFrameNumber;
+    pSlot->mElapsedTime = elapsedTime;
+
+    return pSlot;
+  }
+
+  void EndFrame(SlotT* pSlot)
+  {
+    assert(mMapped);
+    assert(pSlot->mFrameNumber == mFrameNumber);
+
+    Seqlock::EndWrite(pSlot);
+
+    Seqlock::BeginWrite(mpHeader);
+    mpHeader->mLastFrameNumber = mFrameNumber;
+    Seqlock::EndWrite(mpHeader);
+  }
+
+  void ReleaseResources()
+  {
+    // Unmap view and close the handle.
+    if (!Platform::UnmapMemoryFile(mhMap, mpHeader))
+      DEBUG_MSG(DebugLevel::Errors, "Failed to unmap history buffer");
+
+    mpHeader = nullptr;
+    mpFirstSlot = nullptr;
+    mhMap = nullptr;
+    mMapped = false;
+  }
+
+  bool IsMapped() const { return mMapped; }
+
+private:
+  MappedHistoryRing(MappedHistoryRing const& rhs) = delete;
+  MappedHistoryRing& operator =(MappedHistoryRing const& rhs) = delete;
+
+  char const* const MM_FILE_NAME;
+
+  Platform::MapHandle mhMap = nullptr;
+  HeaderT* mpHeader = nullptr;
+  char* mpFirstSlot = nullptr;
+
+  int mNumSlots = 0;
+  int mSlotStride = 0;
+  unsigned long long mFrameNumber = 0uLL;
+  bool mMapped = false;
+};
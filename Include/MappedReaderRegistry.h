@@ -0,0 +1,140 @@
+/*
+Definition of MappedReaderRegistry<> class.
+
+Author: The Iron Wolf (vleonavicius@hotmail.com)
+Website: thecrewchief.org
+
+Description:
+  MappedReaderRegistry<> maps registry of clients (see rF2ReaderRegistry for the reader protocol) and tells
+  plugin which buffers have a live reader, so that work nobody consumes can be skipped.
+
+  Reader is live while its heartbeat keeps changing.  Plugin does not trust wall clock of other processes:
+  it remembers the last heartbeat value it saw in each slot and when it changed.  If a heartbeat does not change
+  for HEARTBEAT_TIMEOUT_MS, the slot is freed, so crashed readers do not keep buffers alive forever.  Newly
+  claimed slots are live immediately.
+
+  Poll() reads a few words per slot and writes nothing unless liveness changed, so it is cheap enough to be
+  called on every telemetry frame.
+*/
+#pragma once
+
+#include "Platform.h"
+
+template <typename RegistryT>
+class MappedReaderRegistry
+{
+  // See DependentPlugin.
+  typedef typename DependentPlugin<RegistryT>::Type SharedMemoryPlugin;
+
+public:
+  MappedReaderRegistry(char const* mmFileName)
+    : MM_FILE_NAME(mmFileName)
+  {}
+
+  ~MappedReaderRegistry()
+  {
+    ReleaseResources();
+  }
+
+  bool Initialize()
+  {
+    assert(!mMapped);
+
+    void* pView = nullptr;
+    mhMap = Platform::MapMemoryFile(MM_FILE_NAME, sizeof(RegistryT), pView);
+    if (mhMap == nullptr) {
+      DEBUG_MSG(DebugLevel::Errors, "Failed to map reader registry file");
+      return false;
+    }
+
+    // Do not clear slots, readers might have registered already.  Whoever is not alive will time out.
+    mpRegistry = static_cast<RegistryT*>(pView);
+
+    memset(mLastOwner, 0, sizeof(mLastOwner));
+    memset(mLastHeartbeat, 0, sizeof(mLastHeartbeat));
+    memset(mLastHeartbeatMillis, 0, sizeof(mLastHeartbeatMillis));
+    mLiveBufferMask = 0u;
+    mLiveReaders = 0u;
+
+    mMapped = true;
+
+    return true;
+  }
+
+  // Returns rF2ReaderBuffer bits of buffers that have a live reader.  Frees slots of readers that stopped heartbeating.
+  unsigned int Poll(unsigned long long nowMillis)
+  {
+    assert(mMapped);
+
+    auto liveBufferMask = 0u;
+    auto liveReaders = 0u;
+    for (int i = 0; i < RegistryT::MAX_READERS; ++i) {
+      auto& slot = mpRegistry->mSlots[i];
+      auto const owner = *static_cast<int const volatile*>(&slot.mOwner);
+      if (owner == 0) {
+        mLastOwner[i] = 0;
+        continue;
+      }
+
+      auto const heartbeat = *static_cast<unsigned int const volatile*>(&slot.mHeartbeat);
+      if (owner != mLastOwner[i] || heartbeat != mLastHeartbeat[i]) {
+        mLastOwner[i] = owner;
+        mLastHeartbeat[i] = heartbeat;
+        mLastHeartbeatMillis[i] = nowMillis;
+      }
+      else if (nowMillis - mLastHeartbeatMillis[i] > RegistryT::HEARTBEAT_TIMEOUT_MS) {
+        // Reader died or hung.  Free the slot, unless it got reclaimed in the meantime.
+        if (Platform::CompareExchange32(&slot.mOwner, 0, owner) == owner)
+          DEBUG_INT2(DebugLevel::Warnings, "READER REGISTRY - Freed slot of a reader with no heartbeat, process id:", owner);
+
+        mLastOwner[i] = 0;
+        continue;
+      }
+
+      liveBufferMask |= *static_cast<unsigned int const volatile*>(&slot.mBufferMask);
+      ++liveReaders;
+    }
+
+    // Only touch shared cache line when something changed.
+    if (liveBufferMask != mLiveBufferMask || liveReaders != mLiveReaders) {
+      mLiveBufferMask = liveBufferMask;
+      mLiveReaders = liveReaders;
+      mpRegistry->mLiveBufferMask = liveBufferMask;
+      mpRegistry->mLiveReaders = liveReaders;
+    }
+
+    return liveBufferMask;
+  }
+
+  void ReleaseResources()
+  {
+    // Unmap view and close the handle.
+    if (!Platform::UnmapMemoryFile(mhMap, mpRegistry))
+      DEBUG_MSG(DebugLevel::Errors, "Failed to unmap reader registry");
+
+    mpRegistry = nullptr;
+    mhMap = nullptr;
+    mMapped = false;
+  }
+
+  bool IsMapped() const { return mMapped; }
+  unsigned int LiveReaders() const { return mLiveReaders; }
+
+private:
+  MappedReaderRegistry(MappedReaderRegistry const& rhs) = delete;
+  MappedReaderRegistry& operator =(MappedReaderRegistry const& rhs) = delete;
+
+  char const* const MM_FILE_NAME;
+
+  Platform::MapHandle mhMap = nullptr;
+  RegistryT* mpRegistry = nullptr;
+
+  // Last observed state of each slot.
+  int mLastOwner[RegistryT::MAX_READERS] = {};
+  unsigned int mLastHeartbeat[RegistryT::MAX_READERS] = {};
+  unsigned long long mLastHeartbeatMillis[RegistryT::MAX_READERS] = {};
+
+  unsigned int mLiveBufferMask = 0u;
+  unsigned int mLiveReaders = 0u;
+  bool mMapped = false;
+};
@@ -0,0 +1,93 @@
+/*
+Definition of MappedSampleRing<> class.
+
+Author: The Iron Wolf (vleonavicius@hotmail.com)
+Website: thecrewchief.org
+
+Description:
+  MappedSampleRing<> appends small fixed size samples to a memory mapped ring (see rF2ForceFeedback for the layout
+  and client protocol).  It is meant for callbacks invoked far more often than telemetry, so appending is a slot
+  write and two sequence counter increments (see Seqlock.h): no allocation, no kernel calls, and plugin never waits
+  for clients.  Ring is bounded: oldest samples are overwritten.
+
+  BuffT has to provide MAX_SAMPLES, mSequence, mMaxSamples, mNumSamples and mSamples (array of SampleT).
+*/
+#pragma once
+
+#include "Seqlock.h"
+#include "Platform.h"
+
+template <typename BuffT, typename SampleT>
+class MappedSampleRing
+{
+  // See DependentPlugin.
+  typedef typename DependentPlugin<BuffT>::Type SharedMemoryPlugin;
+
+public:
+  MappedSampleRing(char const* mmFileName)
+    : MM_FILE_NAME(mmFileName)
+  {}
+
+  ~MappedSampleRing()
+  {
+    ReleaseResources();
+  }
+
+  bool Initialize()
+  {
+    assert(!mMapped);
+
+    void* pView = nullptr;
+    mhMap = Platform::MapMemoryFile(MM_FILE_NAME, sizeof(BuffT), pView);
+    if (mhMap == nullptr) {
+      DEBUG_MSG(DebugLevel::Errors, "Failed to map sample ring file");
+      return false;
+    }
+
+    mpBuf = static_cast<BuffT*>(pView);
+
+    // File might be mapped by clients already, so keep sample numbers moving forward.
+    Seqlock::BeginWrite(mpBuf);
+    mpBuf->mMaxSamples = BuffT::MAX_SAMPLES;
+    Seqlock::EndWrite(mpBuf);
+
+    mMapped = true;
+
+    return true;
+  }
+
+  void Append(SampleT const& sample)
+  {
+    assert(mMapped);
+
+    Seqlock::BeginWrite(mpBuf);
+
+    mpBuf->mSamples[mpBuf->mNumSamples % BuffT::MAX_SAMPLES] = sample;
+    ++mpBuf->mNumSamples;
+
+    Seqlock::EndWrite(mpBuf);
+  }
+
+  void ReleaseResources()
+  {
+    // Unmap view and close the handle.
+    if (!Platform::UnmapMemoryFile(mhMap, mpBuf))
+      DEBUG_MSG(DebugLevel::Errors, "Failed to unmap sample ring");
+
+    mpBuf = nullptr;
+    mhMap = nullptr;
+    mMapped = false;
+  }
+
+  bool IsMapped() const { return mMapped; }
+
+private:
+  MappedSampleRing(MappedSampleRing const& rhs) = delete;
+  MappedSampleRing& operator =(MappedSampleRing const& rhs) = delete;
+
+  char const* const MM_FILE_NAME;
+
+  Platform::MapHandle mhMap = nullptr;
+  BuffT* mpBuf = nullptr;
+  bool mMapped = false;
+};
@@ -0,0 +1,110 @@
+/*
+Definition of MappedSeqlockBuffer<> class.
+
+Author: The Iron Wolf (vleonavicius@hotmail.com)
+Website: thecrewchief.org
+
+Description:
+  MappedSeqlockBuffer<> maps a single buffer that is updated in place and published using its sequence counter
+  (see Seqlock.h).  It is meant for small buffers with no consumers that need a mutex (statistics), where double
+  buffering would only add complexity.  Plugin never waits for clients; clients retry torn copies.
+
+  BuffT has to start with unsigned int mSequence.
+*/
+#pragma once
+
+#include <stddef.h>                             // offsetof
+#include "Seqlock.h"
+#include "Platform.h"
+
+template <typename BuffT>
+class MappedSeqlockBuffer
+{
+  // See DependentPlugin.
+  typedef typename DependentPlugin<BuffT>::Type SharedMemoryPlugin;
+
+public:
+  MappedSeqlockBuffer(char const* mmFileName)
+    : MM_FILE_NAME(mmFileName)
+  {}
+
+  ~MappedSeqlockBuffer()
+  {
+    ReleaseResources();
+  }
+
+  // Maps the file and clears its contents.
+  bool Initialize()
+  {
+    assert(!mMapped);
+    assert(offsetof(BuffT, mSequence) == 0);
+
+    void* pView = nullptr;
+    mhMap = Platform::MapMemoryFile(MM_FILE_NAME, sizeof(BuffT), pView);
+    if (mhMap == nullptr) {
+      DEBUG_MSG(DebugLevel::Errors, "Failed to map seqlock buffer file");
+      return false;
+    }
+
+    mpBuf = static_cast<BuffT*>(pView);
+
+    // File might be mapped by clients already, so keep counter moving forward.
+    Seqlock::BeginWrite(mpBuf);
+    memset(reinterpret_cast<char*>(mpBuf) + HEADER_BYTES, 0, sizeof(BuffT) - HEADER_BYTES);
+    Seqlock::EndWrite(mpBuf);
+
+    mMapped = true;
+
+    return true;
+  }
+
+  // Copies everything except mSequence from source, and publishes it.
+  void Publish(BuffT const& source)
+  {
+    assert(mMapped);
+
+    Seqlock::BeginWrite(mpBuf);
+    memcpy(reinterpret_cast<char*>(mpBuf) + HEADER_BYTES, reinterpret_cast<char const*>(&source) + HEADER_BYTES, sizeof(BuffT) - HEADER_BYTES);
+    Seqlock::EndWrite(mpBuf);
+  }
+
+  // Updates mapped buffer in place, saving the copy of Publish on hot paths.  Returned buffer is only valid until
+  // EndUpdate, which publishes it.
+  BuffT* BeginUpdate()
+  {
+    assert(mMapped);
+
+    Seqlock::BeginWrite(mpBuf);
+    return mpBuf;
+  }
+
+  void EndUpdate()
+  {
+    Seqlock::EndWrite(mpBuf);
+  }
+
+  void ReleaseResources()
+  {
+    // Unmap view and close the handle.
+    if (!Platform::UnmapMemoryFile(mhMap, mpBuf))
+      DEBUG_MSG(DebugLevel::Errors, "Failed to unmap seqlock buffer");
+
+    mpBuf = nullptr;
+    mhMap = nullptr;
+    mMapped = false;
+  }
+
+  bool IsMapped() const { return mMapped; }
+
+private:
+  MappedSeqlockBuffer(MappedSeqlockBuffer const& rhs) = delete;
+  MappedSeqlockBuffer& operator =(MappedSeqlockBuffer const& rhs) = delete;
+
+  static size_t const HEADER_BYTES = sizeof(unsigned int);
+
+  char const* const MM_FILE_NAME;
+
+  Platform::MapHandle mhMap = nullptr;
+  BuffT* mpBuf = nullptr;
+  bool mMapped = false;
+};
@@ -0,0 +1,112 @@
+/*
+Definition of MappedTextRing<> class.
+
+Author: The Iron Wolf (vleonavicius@hotmail.com)
+Website: thecrewchief.org
+
+Description:
+  MappedTextRing<> appends variable length text chunks to a memory mapped byte ring (see rF2ResultsStream for the
+  layout and client protocol).  Ring is bounded: oldest text is overwritten, and chunk that does not fit into the ring
+  is truncated.  Appends are published with the sequence counter (see Seqlock.h), so plugin never waits for clients.
+
+  BuffT has to provide RING_BYTES, MAX_CHUNKS, mSequence, mRingBytes, mMaxChunks, mWriteOffset, mNumChunks,
+  mChunks and mText.
+*/
+#pragma once
+
+#include <string.h>
+#include "Seqlock.h"
+#include "Platform.h"
+
+template <typename BuffT>
+class MappedTextRing
+{
+  // See DependentPlugin.
+  typedef typename DependentPlugin<BuffT>::Type SharedMemoryPlugin;
+
+public:
+  MappedTextRing(char const* mmFileName)
+    : MM_FILE_NAME(mmFileName)
+  {}
+
+  ~MappedTextRing()
+  {
+    ReleaseResources();
+  }
+
+  bool Initialize()
+  {
+    assert(!mMapped);
+
+    void* pView = nullptr;
+    mhMap = Platform::MapMemoryFile(MM_FILE_NAME, sizeof(BuffT), pView);
+    if (mhMap == nullptr) {
+      DEBUG_MSG(DebugLevel::Errors, "Failed to map text ring file");
+      return false;
+    }
+
+    mpBuf = static_cast<BuffT*>(pView);
+
+    // File might be mapped by clients already, so keep offsets moving forward.
+    Seqlock::BeginWrite(mpBuf);
+    mpBuf->mRingBytes = BuffT::RING_BYTES;
+    mpBuf->mMaxChunks = BuffT::MAX_CHUNKS;
+    Seqlock::EndWrite(mpBuf);
+
+    mMapped = true;
+
+    return true;
+  }
+
+  // Appends bytes of text as a new chunk.  Returns number of bytes dropped because they did not fit.
+  unsigned int Append(char const* text, unsigned int bytes, double elapsedTime)
+  {
+    assert(mMapped);
+
+    auto const bytesStored = bytes < static_cast<unsigned int>(BuffT::RING_BYTES) ? bytes : static_cast<unsigned int>(BuffT::RING_BYTES);
+
+    Seqlock::BeginWrite(mpBuf);
+
+    auto const offset = mpBuf->mWriteOffset;
+    auto const ringPos = static_cast<unsigned int>(offset % BuffT::RING_BYTES);
+    auto const firstPart = min(bytesStored, static_cast<unsigned int>(BuffT::RING_BYTES) - ringPos);
+    memcpy(mpBuf->mText + ringPos, text, firstPart);
+    memcpy(mpBuf->mText, text + firstPart, bytesStored - firstPart);
+
+    auto& chunk = mpBuf->mChunks[mpBuf->mNumChunks % BuffT::MAX_CHUNKS];
+    chunk.mOffset = offset;
+    chunk.mBytes = bytesStored;
+    chunk.mBytesDropped = bytes - bytesStored;
+    chunk.mElapsedTime = elapsedTime;
+
+    mpBuf->mWriteOffset = offset + bytesStored;
+    ++mpBuf->mNumChunks;
+
+    Seqlock::EndWrite(mpBuf);
+
+    return bytes - bytesStored;
+  }
+
+  void ReleaseResources()
+  {
+    // Unmap view and close the handle.
+    if (!Platform::UnmapMemoryFile(mhMap, mpBuf))
+      DEBUG_MSG(DebugLevel::Errors, "Failed to unmap text ring");
+
+    mpBuf = nullptr;
+    mhMap = nullptr;
+    mMapped = false;
+  }
+
+  bool IsMapped() const { return mMapped; }
+
+private:
+  MappedTextRing(MappedTextRing const& rhs) = delete;
+  MappedTextRing& operator =(MappedTextRing const& rhs) = delete;
+
+  char const* const MM_FILE_NAME;
+
+  Platform::MapHandle mhMap = nullptr;
+  BuffT* mpBuf = nullptr;
+  bool mMapped = false;
+};
@@ -0,0 +1,149 @@
+/*
+Definition of MpscRing class.
+
+Author: The Iron Wolf (vleonavicius@hotmail.com)
+Website: thecrewchief.org
+
+Description:
+  MpscRing is a bounded lock-free multiple producer/single consumer queue of preallocated slots (Vyukov's bounded
+  queue, with the dequeue side reduced to a single consumer).
+
+  Like SpscRing, slots are filled and consumed in place:
+    producer: BeginPush(position) -> fill the slot -> EndPush(position)
+    consumer: Front() -> read the slot -> Pop()
+
+  Each slot carries a sequence number that says whose turn it is: producers claim a position with a single
+  compare-exchange and publish the slot by storing its sequence, consumer hands the slot back to producers for the
+  position one lap ahead.  Producer never blocks or makes kernel calls; BeginPush returns nullptr if the ring is full
+  and it is up to the caller to drop or retry.  Slots are published in position order, so consumer waits for a
+  producer that claimed a position but has not finished filling it yet, even if later positions are ready.
+*/
+#pragma once
+
+#include <atomic>
+#include <new>                                  // std::nothrow
+
+template <typename SlotT>
+class MpscRing
+{
+public:
+  MpscRing()
+    : mEnqueuePosition(0u)
+  {}
+
+  ~MpscRing()
+  {
+    ReleaseResources();
+  }
+
+  // Capacity is rounded up to a power of two.
+  bool Initialize(unsigned int capacity)
+  {
+    assert(mpCells == nullptr);
+
+    mCapacity = 1u;
+    while (mCapacity < capacity)
+      mCapacity <<= 1;
+
+    // Value initialization also commits slot pages up front, so producers do not page fault on first use.
+    mpCells = new (std::nothrow) Cell[mCapacity]();
+    if (mpCells == nullptr) {
+      mCapacity = 0u;
+      return false;
+    }
+
+    for (auto i = 0u; i < mCapacity; ++i)
+      mpCells[i].mSequence.store(i, std::memory_order_relaxed);
+
+    mEnqueuePosition.store(0u, std::memory_order_relaxed);
+    mDequeuePosition = 0u;
+
+    std::atomic_thread_fence(std::memory_order_release);
+
+    return true;
+  }
+
+  void ReleaseResources()
+  {
+    delete[] mpCells;
+    mpCells = nullptr;
+    mCapacity = 0u;
+  }
+
+  bool IsInitialized() const { return mpCells != nullptr; }
+  unsigned int Capacity() const { return mCapacity; }
+
+  // Producer side, any thread.  Returns slot to fill and its position, or nullptr if ring is full.
+  SlotT* BeginPush(unsigned int& position)
+  {
+    auto pos = mEnqueuePosition.load(std::memory_order_relaxed);
+    for (;;) {
+      auto& cell = mpCells[pos & (mCapacity - 1u)];
+      auto const diff = static_cast<int>(cell.mSequence.load(std::memory_order_acquire) - pos);
+      if (diff == 0) {
+        // Slot is free for this lap, try to claim it.  On failure pos is reloaded.
+        if (mEnqueuePosition.compare_exchange_weak(pos, pos + 1u, std::memory_order_relaxed)) {
+          position = pos;
+          return &cell.mSlot;
+        }
+      }
+      else if (diff < 0)
+        return nullptr;  // Consumer has not released the slot from the previous lap yet.
+      else
+        pos = mEnqueuePosition.load(std::memory_order_relaxed);  // Another producer claimed it.
+    }
+  }
+
+  // Producer side.  Publishes slot returned by BeginPush for the position to the consumer.
+  void EndPush(unsigned int position)
+  {
+    mpCells[position & (mCapacity - 1u)].mSequence.store(position + 1u, std::memory_order_release);
+  }
+
+  // Consumer side.  Returns oldest published slot and its position, or nullptr if ring is empty.
+  SlotT* Front(unsigned int& position)
+  {
+    auto& cell = mpCells[mDequeuePosition & (mCapacity - 1u)];
+    if (cell.mSequence.load(std::memory_order_acquire) != mDequeuePosition + 1u)
+      return nullptr;
+
+    position = mDequeuePosition;
+    return &cell.mSlot;
+  }
+
+  SlotT* Front()
+  {
+    auto position = 0u;
+    return Front(position);
+  }
+
+  // Consumer side.  Returns slot returned by the last Front to producers.
+  void Pop()
+  {
+    mpCells[mDequeuePosition & (mCapacity - 1u)].mSequence.store(mDequeuePosition + mCapacity, std::memory_order_release);
+    ++mDequeuePosition;
+  }
+
+private:
+  MpscRing(MpscRing const&) = delete;
+  MpscRing& operator=(MpscRing const&) = delete;
+
+  static int const CACHE_LINE_BYTES = 64;
+
+  struct Cell
+  {
+    std::atomic<unsigned int> mSequence;
+    SlotT mSlot;
+  };
+
+  // Shared by producers.
+  std::atomic<unsigned int> mEnqueuePosition;
+  char mEnqueuePadding[CACHE_LINE_BYTES - sizeof(std::atomic<unsigned int>)];
+
+  // Written by consumer only.
+  unsigned int mDequeuePosition = 0u;
+  char mDequeuePadding[CACHE_LINE_BYTES - sizeof(unsigned int)];
+
+  Cell* mpCells = nullptr;
+  unsigned int mCapacity = 0u;
+};
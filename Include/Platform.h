@@ -0,0 +1,46 @@
+/*
+Platform layer used by the shared memory publication engine.
+
+Author: The Iron Wolf (vleonavicius@hotmail.com)
+Website: thecrewchief.org
+
+Description:
+  Thin layer over the OS services plugin depends on:
+    - named memory mapping (Platform::MapMemoryFile/UnmapMemoryFile)
+    - named lock (Platform::CreateNamedLock/AcquireLock/ReleaseLock/CloseLock)
+    - named or unnamed auto reset event (Platform::CreateNamedEvent/SignalEvent/WaitEvent/CloseEvent)
+    - clock (Platform::InitializeClock/TicksMicroseconds/TickCountMillis/CycleCounter)
+    - 32 bit compare exchange on mapped memory (Platform::CompareExchange32)
+    - worker threads (Platform::StartThread/JoinThread/SleepMillis, PLATFORM_THREAD_LOCAL)
+    - thread exit notification (Platform::CreateThreadExitKey/SetThreadExitValue/DeleteThreadExitKey)
+
+  PlatformWin32.h implements it over Win32 API.  PlatformPosix.h implements it over shm_open/mmap and
+  process shared robust pthread primitives placed into shared memory.  PlatformPosix.h also provides
+  minimal shims for the handful of Win32/CRT calls plugin makes directly (types, GetPrivateProfileInt/String,
+  Interlocked*, _fsopen etc.), so that plugin sources build unchanged on Linux.  This allows running
+  perf tooling, valgrind and sanitizers against the real hot path.
+*/
+#pragma once
+
+namespace Platform
+{
+  enum class WaitResult
+  {
+    Signaled = 0,          // Lock acquired or event signaled.
+    Abandoned = 1,         // Lock acquired, but previous owner died while holding it.
+    TimedOut = 2,
+    Failed = 3
+  };
+
+  // Lock has to be released in both cases.
+  inline bool IsLockAcquired(WaitResult result)
+  {
+    return result == WaitResult::Signaled || result == WaitResult::Abandoned;
+  }
+}
+
+#ifdef _WIN32
+#include "PlatformWin32.h"
+#else
+#include "PlatformPosix.h"
+#endif
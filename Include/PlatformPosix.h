@@ -0,0 +1,680 @@
+/*
+POSIX implementation of the platform layer (see Platform.h).
+
+Author: The Iron Wolf (vleonavicius@hotmail.com)
+Website: thecrewchief.org
+
+Description:
+  Named objects live in POSIX shared memory (shm_open).  Win32 object names are converted by prefixing
+  them with '/' and replacing path separators with '_' (Global\$rFactor2SMMP_TelemeteryMutex becomes
+  /Global_$rFactor2SMMP_TelemeteryMutex).  Shared memory object is unlinked when the process that created
+  it closes it, which mirrors Win32 named object lifetime closely enough for the plugin.
+
+  Named lock and event are process shared robust pthread objects placed in their own shared memory
+  objects.  Robust mutex reports EOWNERDEAD if the owner died, which maps to WAIT_ABANDONED semantics.
+
+  Second half of this file is Win32 compatibility shims used by the plugin sources.
+*/
+#pragma once
+
+#include <atomic>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>                            // strcasecmp
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>                          // __rdtsc
+#endif
+
+////////////////////////////////////
+// Win32 types and constants.
+////////////////////////////////////
+typedef uint32_t DWORD;
+typedef unsigned int UINT;
+typedef int BOOL;
+typedef void* HWND;
+typedef unsigned long long ULONGLONG;
+
+#ifndef TRUE
+#define TRUE 1
+#endif
+
+#ifndef FALSE
+#define FALSE 0
+#endif
+
+#define MAX_PATH 260
+#define INFINITE 0xFFFFFFFF
+
+#if defined(__x86_64__) && !defined(_AMD64_)
+#define _AMD64_                                 // Pointer size in ISI structures.
+#endif
+
+#define __cdecl
+#define __declspec(x) __attribute__((visibility("default")))
+
+// Thread local storage for POD variables (__declspec(thread) is taken by the shim above).
+#define PLATFORM_THREAD_LOCAL __thread
+
+// Calling convention of callbacks passed to the OS (thread exit callback).
+#define PLATFORM_CALLBACK
+
+// Same as windows.h, define NOMINMAX to suppress.
+#ifndef NOMINMAX
+#ifndef min
+#define min(a, b) (((a) < (b)) ? (a) : (b))
+#endif
+
+#ifndef max
+#define max(a, b) (((a) > (b)) ? (a) : (b))
+#endif
+#endif
+
+namespace Platform
+{
+  struct PosixMapping
+  {
+    int mFd;
+    int mSize;
+    bool mCreated;
+    char mName[256];
+  };
+
+  struct PosixLockShared
+  {
+    std::atomic<int> mInitialized;
+    pthread_mutex_t mMutex;
+  };
+
+  struct PosixLock
+  {
+    PosixMapping* mhMap;
+    PosixLockShared* mpShared;
+  };
+
+  struct PosixEventShared
+  {
+    std::atomic<int> mInitialized;
+    pthread_mutex_t mMutex;
+    pthread_cond_t mCond;
+    int mSignaled;
+  };
+
+  struct PosixEvent
+  {
+    PosixMapping* mhMap;
+    PosixEventShared* mpShared;
+  };
+
+  typedef PosixMapping* MapHandle;
+  typedef PosixLock* LockHandle;
+  typedef PosixEvent* EventHandle;
+
+  inline void ToShmName(char const* const name, char* shmName, size_t shmNameSize)
+  {
+    snprintf(shmName, shmNameSize, "/%s", name);
+    for (auto p = shmName + 1; *p != '\0'; ++p) {
+      if (*p == '\\' || *p == '/')
+        *p = '_';
+    }
+  }
+
+  ////////////////////////////////////
+  // Named memory mapping.
+  ////////////////////////////////////
+
+  // Creates (or opens, if it already exists) named shared memory object of size bytes, and maps it into pView.
+  // Returns mapping handle, or nullptr on failure.  Newly created memory is zero initialized.
+  inline MapHandle MapMemoryFile(char const* const fileName, int size, void*& pView)
+  {
+    char tag[256] = {};
+    snprintf(tag, sizeof(tag), "%s", fileName);
+
+    char exe[1024] = {};
+    if (readlink("/proc/self/exe", exe, sizeof(exe) - 1) < 0)
+      exe[0] = '\0';
+
+    // Append processId for dedicated server to allow multiple instances
+    if (strstr(exe, "Dedicated") != nullptr)
+      snprintf(tag + strlen(tag), sizeof(tag) - strlen(tag), "%d", static_cast<int>(getpid()));
+
+    auto const hMap = new PosixMapping();
+    ToShmName(tag, hMap->mName, sizeof(hMap->mName));
+    hMap->mSize = size;
+
+    // Try to create, open if existing.
+    hMap->mFd = shm_open(hMap->mName, O_RDWR | O_CREAT | O_EXCL, 0666);
+    hMap->mCreated = hMap->mFd != -1;
+    if (hMap->mFd == -1 && errno == EEXIST)
+      hMap->mFd = shm_open(hMap->mName, O_RDWR, 0666);
+
+    if (hMap->mFd == -1) {
+      delete hMap;
+      return nullptr;
+    }
+
+    // Grow the object if needed (never shrink, someone might have it mapped).
+    struct stat st = {};
+    if (fstat(hMap->mFd, &st) != 0
+      || (st.st_size < size && ftruncate(hMap->mFd, size) != 0)) {
+      close(hMap->mFd);
+      delete hMap;
+      return nullptr;
+    }
+
+    pView = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, hMap->mFd, 0);
+    if (pView == MAP_FAILED) {
+      // Failed to map memory buffer
+      pView = nullptr;
+      close(hMap->mFd);
+      if (hMap->mCreated)
+        shm_unlink(hMap->mName);
+
+      delete hMap;
+      return nullptr;
+    }
+
+    return hMap;
+  }
+
+  // Unmaps view and closes the mapping.  Either can be nullptr.
+  inline bool UnmapMemoryFile(MapHandle hMap, void* pView)
+  {
+    auto ret = true;
+    if (hMap == nullptr)
+      return pView == nullptr;
+
+    if (pView != nullptr) ret = munmap(pView, hMap->mSize) == 0;
+
+    ret = close(hMap->mFd) == 0 && ret;
+    if (hMap->mCreated)
+      shm_unlink(hMap->mName);
+
+    delete hMap;
+    return ret;
+  }
+
+  ////////////////////////////////////
+  // Shared object helpers.
+  ////////////////////////////////////
+
+  // Maps SharedT named object.  Creator of the object initializes it and publishes mInitialized, others wait for it.
+  template <typename SharedT, typename InitT>
+  inline SharedT* OpenSharedObject(char const* const name, MapHandle& hMap, InitT init)
+  {
+    void* pView = nullptr;
+    hMap = MapMemoryFile(name, sizeof(SharedT), pView);
+    if (hMap == nullptr)
+      return nullptr;
+
+    auto const pShared = static_cast<SharedT*>(pView);
+    if (hMap->mCreated) {
+      init(pShared);
+      pShared->mInitialized.store(1, std::memory_order_release);
+      return pShared;
+    }
+
+    // Wait up to 1s for the creator to finish initialization.
+    for (int i = 0; i < 1000 && pShared->mInitialized.load(std::memory_order_acquire) == 0; ++i)
+      usleep(1000);
+
+    if (pShared->mInitialized.load(std::memory_order_acquire) == 0) {
+      UnmapMemoryFile(hMap, pView);
+      hMap = nullptr;
+      return nullptr;
+    }
+
+    return pShared;
+  }
+
+  inline void InitRobustMutex(pthread_mutex_t* pMutex)
+  {
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+    pthread_mutex_init(pMutex, &attr);
+    pthread_mutexattr_destroy(&attr);
+  }
+
+  inline timespec DeadlineFromNow(clockid_t clock, DWORD millis)
+  {
+    timespec deadline = {};
+    clock_gettime(clock, &deadline);
+    deadline.tv_sec += millis / 1000u;
+    deadline.tv_nsec += static_cast<long>(millis % 1000u) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+      ++deadline.tv_sec;
+      deadline.tv_nsec -= 1000000000L;
+    }
+
+    return deadline;
+  }
+
+  // Locks robust mutex, making it consistent if the owner died.
+  inline WaitResult LockRobustMutex(pthread_mutex_t* pMutex, DWORD millis)
+  {
+    int ret = 0;
+    if (millis == 0u)
+      ret = pthread_mutex_trylock(pMutex);
+    else if (millis == INFINITE)
+      ret = pthread_mutex_lock(pMutex);
+    else {
+      auto const deadline = DeadlineFromNow(CLOCK_REALTIME, millis);
+      ret = pthread_mutex_timedlock(pMutex, &deadline);
+    }
+
+    if (ret == 0)
+      return WaitResult::Signaled;
+
+    if (ret == EOWNERDEAD) {
+      pthread_mutex_consistent(pMutex);
+      return WaitResult::Abandoned;
+    }
+
+    if (ret == EBUSY || ret == ETIMEDOUT)
+      return WaitResult::TimedOut;
+
+    return WaitResult::Failed;
+  }
+
+  ////////////////////////////////////
+  // Named lock.
+  ////////////////////////////////////
+
+  inline LockHandle CreateNamedLock(char const* const name)
+  {
+    MapHandle hMap = nullptr;
+    auto const pShared = OpenSharedObject<PosixLockShared>(name, hMap, [](PosixLockShared* pLock) {
+      InitRobustMutex(&pLock->mMutex);
+    });
+
+    if (pShared == nullptr)
+      return nullptr;
+
+    auto const hLock = new PosixLock();
+    hLock->mhMap = hMap;
+    hLock->mpShared = pShared;
+
+    return hLock;
+  }
+
+  // millis == 0 means try lock.
+  inline WaitResult AcquireLock(LockHandle hLock, DWORD millis)
+  {
+    return LockRobustMutex(&hLock->mpShared->mMutex, millis);
+  }
+
+  inline void ReleaseLock(LockHandle hLock)
+  {
+    pthread_mutex_unlock(&hLock->mpShared->mMutex);
+  }
+
+  inline bool CloseLock(LockHandle hLock)
+  {
+    auto const ret = UnmapMemoryFile(hLock->mhMap, hLock->mpShared);
+    delete hLock;
+
+    return ret;
+  }
+
+  ////////////////////////////////////
+  // Named auto reset event.
+  ////////////////////////////////////
+
+  inline void InitEventShared(PosixEventShared* pEvent)
+  {
+    InitRobustMutex(&pEvent->mMutex);
+
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&pEvent->mCond, &attr);
+    pthread_condattr_destroy(&attr);
+
+    pEvent->mSignaled = 0;
+  }
+
+  // name == nullptr creates unnamed event, private to the process.
+  inline EventHandle CreateNamedEvent(char const* const name)
+  {
+    MapHandle hMap = nullptr;
+    PosixEventShared* pShared = nullptr;
+    if (name != nullptr)
+      pShared = OpenSharedObject<PosixEventShared>(name, hMap, InitEventShared);
+    else {
+      pShared = new PosixEventShared();
+      InitEventShared(pShared);
+    }
+
+    if (pShared == nullptr)
+      return nullptr;
+
+    auto const hEvent = new PosixEvent();
+    hEvent->mhMap = hMap;
+    hEvent->mpShared = pShared;
+
+    return hEvent;
+  }
+
+  inline void SignalEvent(EventHandle hEvent)
+  {
+    auto const pShared = hEvent->mpShared;
+    if (LockRobustMutex(&pShared->mMutex, INFINITE) == WaitResult::Failed)
+      return;
+
+    pShared->mSignaled = 1;
+    pthread_cond_signal(&pShared->mCond);
+    pthread_mutex_unlock(&pShared->mMutex);
+  }
+
+  inline WaitResult WaitEvent(EventHandle hEvent, DWORD millis)
+  {
+    auto const pShared = hEvent->mpShared;
+    if (LockRobustMutex(&pShared->mMutex, INFINITE) == WaitResult::Failed)
+      return WaitResult::Failed;
+
+    auto const deadline = DeadlineFromNow(CLOCK_MONOTONIC, millis);
+    auto ret = 0;
+    while (pShared->mSignaled == 0 && ret != ETIMEDOUT && millis != 0u) {
+      ret = millis == INFINITE
+        ? pthread_cond_wait(&pShared->mCond, &pShared->mMutex)
+        : pthread_cond_timedwait(&pShared->mCond, &pShared->mMutex, &deadline);
+
+      if (ret == EOWNERDEAD)
+        pthread_mutex_consistent(&pShared->mMutex);
+    }
+
+    // Auto reset.
+    auto const signaled = pShared->mSignaled != 0;
+    pShared->mSignaled = 0;
+    pthread_mutex_unlock(&pShared->mMutex);
+
+    return signaled ? WaitResult::Signaled : WaitResult::TimedOut;
+  }
+
+  inline bool CloseEvent(EventHandle hEvent)
+  {
+    auto ret = true;
+    if (hEvent->mhMap != nullptr)
+      ret = UnmapMemoryFile(hEvent->mhMap, hEvent->mpShared);
+    else {
+      pthread_cond_destroy(&hEvent->mpShared->mCond);
+      pthread_mutex_destroy(&hEvent->mpShared->mMutex);
+      delete hEvent->mpShared;
+    }
+
+    delete hEvent;
+
+    return ret;
+  }
+
+  ////////////////////////////////////
+  // Clock.
+  ////////////////////////////////////
+
+  // Nothing to initialize, CLOCK_MONOTONIC is in nanoseconds.
+  inline void InitializeClock()
+  {
+  }
+
+  // High resolution monotonic clock.
+  inline double TicksMicroseconds()
+  {
+    timespec now = {};
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<double>(now.tv_sec) * 1000000.0 + static_cast<double>(now.tv_nsec) / 1000.0;
+  }
+
+  // Cheap low resolution monotonic clock.
+  inline unsigned long long TickCountMillis()
+  {
+    timespec now = {};
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &now);
+    return static_cast<unsigned long long>(now.tv_sec) * 1000uLL + static_cast<unsigned long long>(now.tv_nsec) / 1000000uLL;
+  }
+
+  // Raw CPU timestamp counter.  Cheapest clock available, but rate has to be calibrated against TicksMicroseconds.
+  inline unsigned long long CycleCounter()
+  {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    timespec now = {};
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<unsigned long long>(now.tv_sec) * 1000000000uLL + static_cast<unsigned long long>(now.tv_nsec);
+#endif
+  }
+
+  ////////////////////////////////////
+  // Atomics on mapped memory.
+  ////////////////////////////////////
+
+  // Returns initial *pDestination, exchange is stored only if it was comparand.  Unlike the InterlockedCompareExchange
+  // shim, always 32 bit, so it can be used on fields shared with Windows clients.
+  inline int CompareExchange32(int volatile* pDestination, int exchange, int comparand)
+  {
+    return __sync_val_compare_and_swap(pDestination, comparand, exchange);
+  }
+
+  ////////////////////////////////////
+  // Threads.
+  ////////////////////////////////////
+  typedef pthread_t* ThreadHandle;
+  typedef void (*ThreadProc)(void* pContext);
+
+  namespace Detail
+  {
+    struct ThreadStart
+    {
+      ThreadProc mpProc;
+      void* mpContext;
+    };
+
+    inline void* ThreadTrampoline(void* pParam)
+    {
+      auto const start = *static_cast<ThreadStart*>(pParam);
+      delete static_cast<ThreadStart*>(pParam);
+
+      start.mpProc(start.mpContext);
+      return nullptr;
+    }
+  }
+
+  // Returns nullptr on failure.
+  inline ThreadHandle StartThread(ThreadProc proc, void* pContext)
+  {
+    auto const pStart = new Detail::ThreadStart{ proc, pContext };
+    auto const pThread = new pthread_t;
+    if (pthread_create(pThread, nullptr, Detail::ThreadTrampoline, pStart) != 0) {
+      delete pStart;
+      delete pThread;
+      return nullptr;
+    }
+
+    return pThread;
+  }
+
+  inline void JoinThread(ThreadHandle hThread)
+  {
+    pthread_join(*hThread, nullptr);
+    delete hThread;
+  }
+
+  inline void SleepMillis(unsigned long millis)
+  {
+    timespec const delay = { static_cast<time_t>(millis / 1000uL), static_cast<long>(millis % 1000uL) * 1000000L };
+    nanosleep(&delay, nullptr);
+  }
+
+  ////////////////////////////////////
+  // Thread exit notification.
+  ////////////////////////////////////
+  typedef pthread_key_t ThreadExitKey;
+  typedef void (PLATFORM_CALLBACK *ThreadExitCallback)(void* pValue);
+
+  // Callback is called on the exiting thread, for threads that set non null value.
+  inline bool CreateThreadExitKey(ThreadExitKey& key, ThreadExitCallback callback)
+  {
+    return pthread_key_create(&key, callback) == 0;
+  }
+
+  inline bool SetThreadExitValue(ThreadExitKey key, void* pValue)
+  {
+    return pthread_setspecific(key, pValue) == 0;
+  }
+
+  // Might call the callback for threads still holding a value.
+  inline void DeleteThreadExitKey(ThreadExitKey key)
+  {
+    pthread_key_delete(key);
+  }
+
+  inline void ToPosixPath(char const* const path, char* posixPath, size_t posixPathSize)
+  {
+    snprintf(posixPath, posixPathSize, "%s", path);
+    for (auto p = posixPath; *p != '\0'; ++p) {
+      if (*p == '\\')
+        *p = '/';
+    }
+  }
+}
+
+////////////////////////////////////
+// Win32 and CRT compatibility shims.
+////////////////////////////////////
+
+#define _SH_DENYNO 0x40
+
+template <size_t destSize>
+inline int strcpy_s(char(&dest)[destSize], char const* src)
+{
+  snprintf(dest, destSize, "%s", src);
+  return 0;
+}
+
+template <size_t bufSize>
+inline int _itoa_s(int value, char(&buf)[bufSize], int radix)
+{
+  snprintf(buf, bufSize, radix == 16 ? "%x" : "%d", value);
+  return 0;
+}
+
+inline FILE* _fsopen(char const* fileName, char const* mode, int /*shflag*/)
+{
+  char path[MAX_PATH] = {};
+  Platform::ToPosixPath(fileName, path, sizeof(path));
+  return fopen(path, mode);
+}
+
+inline DWORD GetCurrentDirectory(DWORD bufferLength, char* buffer)
+{
+  return getcwd(buffer, bufferLength) != nullptr ? static_cast<DWORD>(strlen(buffer)) : 0u;
+}
+
+inline char* lstrcatA(char* dest, char const* src)
+{
+  return strcat(dest, src);
+}
+
+inline int _stricmp(char const* lhs, char const* rhs)
+{
+  return strcasecmp(lhs, rhs);
+}
+
+inline DWORD GetCurrentThreadId()
+{
+  return static_cast<DWORD>(syscall(SYS_gettid));
+}
+
+namespace Platform
+{
+  // Minimal ini reader: [section] lines and key=value pairs, ';' comments.  Copies value (trimmed) into value buffer.
+  inline bool ReadIniValue(char const* section, char const* key, char const* fileName, char* value, size_t valueSize)
+  {
+    char path[MAX_PATH] = {};
+    Platform::ToPosixPath(fileName, path, sizeof(path));
+
+    auto const f = fopen(path, "r");
+    if (f == nullptr)
+      return false;
+
+    auto found = false;
+    auto inSection = false;
+    char line[2048] = {};
+    while (fgets(line, sizeof(line), f) != nullptr) {
+      auto p = line;
+      while (*p == ' ' || *p == '\t')
+        ++p;
+
+      if (*p == ';' || *p == '\0' || *p == '\r' || *p == '\n')
+        continue;
+
+      if (*p == '[') {
+        auto const end = strchr(p, ']');
+        inSection = end != nullptr
+          && static_cast<size_t>(end - p - 1) == strlen(section)
+          && strncasecmp(p + 1, section, strlen(section)) == 0;
+        continue;
+      }
+
+      auto const keyLength = strlen(key);
+      if (inSection && strncasecmp(p, key, keyLength) == 0) {
+        p += keyLength;
+        while (*p == ' ' || *p == '\t')
+          ++p;
+
+        if (*p == '=') {
+          ++p;
+          while (*p == ' ' || *p == '\t')
+            ++p;
+
+          auto length = strcspn(p, "\r\n");
+          while (length > 0 && (p[length - 1] == ' ' || p[length - 1] == '\t'))
+            --length;
+
+          snprintf(value, valueSize, "%.*s", static_cast<int>(length), p);
+          found = true;
+          break;
+        }
+      }
+    }
+
+    fclose(f);
+    return found;
+  }
+}
+
+inline UINT GetPrivateProfileInt(char const* section, char const* key, int defaultValue, char const* fileName)
+{
+  char value[64] = {};
+  if (!Platform::ReadIniValue(section, key, fileName, value, sizeof(value)))
+    return static_cast<UINT>(defaultValue);
+
+  return static_cast<UINT>(atoi(value));
+}
+
+inline DWORD GetPrivateProfileString(char const* section, char const* key, char const* defaultValue, char* value, DWORD valueSize, char const* fileName)
+{
+  if (!Platform::ReadIniValue(section, key, fileName, value, valueSize))
+    snprintf(value, valueSize, "%s", defaultValue != nullptr ? defaultValue : "");
+
+  return static_cast<DWORD>(strlen(value));
+}
+
+inline long InterlockedIncrement(long volatile* addend) { return __sync_add_and_fetch(addend, 1L); }
+inline long InterlockedDecrement(long volatile* addend) { return __sync_sub_and_fetch(addend, 1L); }
+inline long InterlockedExchange(long volatile* target, long value) { return __atomic_exchange_n(target, value, __ATOMIC_SEQ_CST); }
+inline long InterlockedCompareExchange(long volatile* destination, long exchange, long comparand) { return __sync_val_compare_and_swap(destination, comparand, exchange); }
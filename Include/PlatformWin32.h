@@ -0,0 +1,278 @@
+/*
+Win32 implementation of the platform layer (see Platform.h).
+
+Author: The Iron Wolf (vleonavicius@hotmail.com)
+Website: thecrewchief.org
+*/
+#pragma once
+
+#include <windows.h>
+#include <assert.h>
+#include <intrin.h>                             // __rdtsc
+#include <share.h>                              // _fsopen share flags
+#include <stdio.h>
+#include <string.h>
+
+// Thread local storage for POD variables.
+#define PLATFORM_THREAD_LOCAL __declspec(thread)
+
+// Calling convention of callbacks passed to the OS (thread exit callback).
+#define PLATFORM_CALLBACK WINAPI
+
+namespace Platform
+{
+  typedef HANDLE MapHandle;
+  typedef HANDLE LockHandle;
+  typedef HANDLE EventHandle;
+
+  inline WaitResult ToWaitResult(DWORD ret)
+  {
+    switch (ret) {
+    case WAIT_OBJECT_0:
+      return WaitResult::Signaled;
+    case WAIT_ABANDONED:
+      return WaitResult::Abandoned;
+    case WAIT_TIMEOUT:
+      return WaitResult::TimedOut;
+    default:
+      return WaitResult::Failed;
+    }
+  }
+
+  ////////////////////////////////////
+  // Named memory mapping.
+  ////////////////////////////////////
+
+  // Creates (or opens, if it already exists) named file mapping of size bytes, and maps it into pView.
+  // Returns mapping handle, or nullptr on failure.
+  inline MapHandle MapMemoryFile(char const* const fileName, int size, void*& pView)
+  {
+    char tag[256] = {};
+    strcpy_s(tag, fileName);
+
+    char exe[1024] = {};
+    GetModuleFileName(nullptr, exe, sizeof(exe));
+
+    char pid[8] = {};
+    sprintf(pid, "%d", GetCurrentProcessId());
+
+    // Append processId for dedicated server to allow multiple instances
+    // TODO: Verify for rF2.
+    if (strstr(exe, "Dedicated.exe") != nullptr)
+      strcat(tag, pid);
+
+    // Init handle and try to create, read if existing
+    HANDLE hMap = INVALID_HANDLE_VALUE;
+    hMap = CreateFileMapping(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, size, TEXT(tag));
+    if (hMap == nullptr) {
+      if (GetLastError() == ERROR_ALREADY_EXISTS) {
+        hMap = OpenFileMapping(FILE_MAP_ALL_ACCESS, FALSE, TEXT(tag));
+        if (hMap == nullptr) {
+          return nullptr;
+        }
+      }
+    }
+
+    pView = MapViewOfFile(hMap, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    if (pView == nullptr) {
+      // Failed to map memory buffer
+      CloseHandle(hMap);
+      return nullptr;
+    }
+
+    return hMap;
+  }
+
+  // Unmaps view and closes the mapping.  Either can be nullptr.
+  inline bool UnmapMemoryFile(MapHandle hMap, void* pView)
+  {
+    auto ret = TRUE;
+    if (pView != nullptr) ret = UnmapViewOfFile(pView);
+    if (hMap != nullptr) ret = CloseHandle(hMap) && ret;
+
+    return ret != FALSE;
+  }
+
+  ////////////////////////////////////
+  // Named lock.
+  ////////////////////////////////////
+
+  inline LockHandle CreateNamedLock(char const* const name)
+  {
+    return CreateMutex(nullptr, FALSE, name);
+  }
+
+  // millis == 0 means try lock.
+  inline WaitResult AcquireLock(LockHandle hLock, DWORD millis)
+  {
+    return ToWaitResult(WaitForSingleObject(hLock, millis));
+  }
+
+  inline void ReleaseLock(LockHandle hLock)
+  {
+    ReleaseMutex(hLock);
+  }
+
+  inline bool CloseLock(LockHandle hLock)
+  {
+    return CloseHandle(hLock) != FALSE;
+  }
+
+  ////////////////////////////////////
+  // Named auto reset event.
+  ////////////////////////////////////
+
+  // name == nullptr creates unnamed event, private to the process.
+  inline EventHandle CreateNamedEvent(char const* const name)
+  {
+    return CreateEvent(nullptr, FALSE /*bManualReset*/, FALSE /*bInitialState*/, name);
+  }
+
+  inline void SignalEvent(EventHandle hEvent)
+  {
+    SetEvent(hEvent);
+  }
+
+  inline WaitResult WaitEvent(EventHandle hEvent, DWORD millis)
+  {
+    return ToWaitResult(WaitForSingleObject(hEvent, millis));
+  }
+
+  inline bool CloseEvent(EventHandle hEvent)
+  {
+    return CloseHandle(hEvent) != FALSE;
+  }
+
+  ////////////////////////////////////
+  // Clock.
+  ////////////////////////////////////
+
+  namespace Detail
+  {
+    // Static data member of a class template: one definition shared by all translation units of the module.  It is
+    // constant initialized to zero, so there's no static initializer other translation units could race with.
+    template <typename T = void>
+    struct Clock
+    {
+      static double sFrequencyMicrosecond;
+    };
+
+    template <typename T>
+    double Clock<T>::sFrequencyMicrosecond = 0.0;
+  }
+
+  // Call before any thread uses TicksMicroseconds (plugin Startup).  Not done lazily, because function local statics
+  // are not initialized thread safely by VC12.
+  inline void InitializeClock()
+  {
+    if (Detail::Clock<>::sFrequencyMicrosecond != 0.0)
+      return;
+
+    LARGE_INTEGER qpcFrequency = {};
+    QueryPerformanceFrequency(&qpcFrequency);
+    Detail::Clock<>::sFrequencyMicrosecond = static_cast<double>(qpcFrequency.QuadPart) / 1000000.0;
+  }
+
+  // High resolution monotonic clock (QPC).
+  inline double TicksMicroseconds()
+  {
+    assert(Detail::Clock<>::sFrequencyMicrosecond != 0.0);
+
+    LARGE_INTEGER now = {};
+    QueryPerformanceCounter(&now);
+    return static_cast<double>(now.QuadPart) / Detail::Clock<>::sFrequencyMicrosecond;
+  }
+
+  // Cheap low resolution monotonic clock.
+  inline unsigned long long TickCountMillis()
+  {
+    return GetTickCount64();
+  }
+
+  // Raw CPU timestamp counter.  Cheapest clock available, but rate has to be calibrated against TicksMicroseconds.
+  inline unsigned long long CycleCounter()
+  {
+    return __rdtsc();
+  }
+
+  ////////////////////////////////////
+  // Atomics on mapped memory.
+  ////////////////////////////////////
+
+  // Returns initial *pDestination, exchange is stored only if it was comparand.
+  inline int CompareExchange32(int volatile* pDestination, int exchange, int comparand)
+  {
+    static_assert(sizeof(LONG) == sizeof(int), "LONG is not 32 bit");
+    return static_cast<int>(InterlockedCompareExchange(reinterpret_cast<LONG volatile*>(pDestination), exchange, comparand));
+  }
+
+  ////////////////////////////////////
+  // Threads.
+  ////////////////////////////////////
+  typedef HANDLE ThreadHandle;
+  typedef void (*ThreadProc)(void* pContext);
+
+  namespace Detail
+  {
+    struct ThreadStart
+    {
+      ThreadProc mpProc;
+      void* mpContext;
+    };
+
+    inline DWORD WINAPI ThreadTrampoline(LPVOID pParam)
+    {
+      auto const start = *static_cast<ThreadStart*>(pParam);
+      delete static_cast<ThreadStart*>(pParam);
+
+      start.mpProc(start.mpContext);
+      return 0uL;
+    }
+  }
+
+  // Returns nullptr on failure.
+  inline ThreadHandle StartThread(ThreadProc proc, void* pContext)
+  {
+    auto const pStart = new Detail::ThreadStart{ proc, pContext };
+    auto const hThread = CreateThread(nullptr, 0u, Detail::ThreadTrampoline, pStart, 0uL, nullptr);
+    if (hThread == nullptr)
+      delete pStart;
+
+    return hThread;
+  }
+
+  inline void JoinThread(ThreadHandle hThread)
+  {
+    WaitForSingleObject(hThread, INFINITE);
+    CloseHandle(hThread);
+  }
+
+  inline void SleepMillis(unsigned long millis)
+  {
+    ::Sleep(millis);
+  }
+
+  ////////////////////////////////////
+  // Thread exit notification.
+  ////////////////////////////////////
+  typedef DWORD ThreadExitKey;
+  typedef void (PLATFORM_CALLBACK *ThreadExitCallback)(void* pValue);
+
+  // Callback is called on the exiting thread, for threads that set non null value (fiber local storage).
+  inline bool CreateThreadExitKey(ThreadExitKey& key, ThreadExitCallback callback)
+  {
+    key = FlsAlloc(callback);
+    return key != FLS_OUT_OF_INDEXES;
+  }
+
+  inline bool SetThreadExitValue(ThreadExitKey key, void* pValue)
+  {
+    return FlsSetValue(key, pValue) != FALSE;
+  }
+
+  // Might call the callback for threads still holding a value.
+  inline void DeleteThreadExitKey(ThreadExitKey key)
+  {
+    FlsFree(key);
+  }
+}
@@ -0,0 +1,140 @@
+/*
+Definition of RaceEventTracker class.
+
+Author: The Iron Wolf (vleonavicius@hotmail.com)
+Website: thecrewchief.org
+
+Description:
+  RaceEventTracker turns scoring updates into discrete race events (see rF2RaceEventType), so that clients
+  do not have to diff whole scoring snapshots to find pit entries, completed laps, phase changes etc.
+
+  Tracker keeps the last seen values of the tracked fields per vehicle mID, and appends an event to the
+  ring (MappedHistoryRing<rF2RaceEvents, rF2RaceEvent>) for each field that changed.  First scoring update
+  after Reset only establishes the baseline: it reports every vehicle as joined, but no transitions.
+  Vehicles are tracked in slot mID, so vehicles with mID outside of [0, MAX_MAPPED_IDS) are skipped rather than
+  sharing a slot, which would report their changes against each other.
+
+  Impacts are detected by ExtendedStateTracker during telemetry processing, and lifecycle events are added
+  by the plugin callbacks directly, via Add.
+*/
+#pragma once
+
+#include <string.h>
+
+class RaceEventTracker
+{
+public:
+  void Reset()
+  {
+    memset(mVehicles, 0, sizeof(mVehicles));
+    mHaveBaseline = false;
+  }
+
+  template <typename RingT>
+  static void Add(RingT& ring, rF2RaceEventType type, double elapsedTime, long id, long oldValue, long newValue, double value)
+  {
+    if (!ring.IsMapped())
+      return;
+
+    auto const pEvent = ring.BeginFrame(elapsedTime);
+    pEvent->mType = type;
+    pEvent->mID = id;
+    pEvent->mOldValue = oldValue;
+    pEvent->mNewValue = newValue;
+    pEvent->mValue = value;
+    ring.EndFrame(pEvent);
+  }
+
+  template <typename RingT>
+  void ProcessScoringUpdate(ScoringInfoV01 const& info, RingT& ring)
+  {
+    auto const et = info.mCurrentET;
+
+    if (mHaveBaseline) {
+      if (info.mGamePhase != mGamePhase)
+        Add(ring, rF2RaceEventType::GamePhaseChanged, et, -1L, mGamePhase, info.mGamePhase, 0.0);
+
+      if (info.mYellowFlagState != mYellowFlagState)
+        Add(ring, rF2RaceEventType::YellowFlagStateChanged, et, -1L, mYellowFlagState, info.mYellowFlagState, 0.0);
+    }
+
+    mGamePhase = info.mGamePhase;
+    mYellowFlagState = info.mYellowFlagState;
+    mHaveBaseline = true;
+
+    ++mUpdateNumber;
+    for (int i = 0; i < info.mNumVehicles; ++i) {
+      auto const& veh = info.mVehicle[i];
+      if (veh.mID < 0L || veh.mID >= rF2MappedBufferHeader::MAX_MAPPED_IDS)
+        continue;
+
+      auto& prev = mVehicles[veh.mID];
+
+      if (!prev.mPresent)
+        Add(ring, rF2RaceEventType::VehicleJoined, et, veh.mID, 0L, veh.mPlace, 0.0);
+      else {
+        if (veh.mTotalLaps > prev.mTotalLaps)
+          Add(ring, rF2RaceEventType::LapCompleted, et, veh.mID, prev.mTotalLaps, veh.mTotalLaps, veh.mLastLapTime);
+
+        if (veh.mInPits != prev.mInPits)
+          Add(ring, veh.mInPits ? rF2RaceEventType::PitEntered : rF2RaceEventType::PitExited, et, veh.mID, prev.mInPits, veh.mInPits, 0.0);
+
+        if (veh.mPitState != prev.mPitState)
+          Add(ring, rF2RaceEventType::PitStateChanged, et, veh.mID, prev.mPitState, veh.mPitState, 0.0);
+
+        if (veh.mPlace != prev.mPlace)
+          Add(ring, rF2RaceEventType::PlaceChanged, et, veh.mID, prev.mPlace, veh.mPlace, 0.0);
+
+        if (veh.mFinishStatus != prev.mFinishStatus)
+          Add(ring, rF2RaceEventType::FinishStatusChanged, et, veh.mID, prev.mFinishStatus, veh.mFinishStatus, 0.0);
+
+        if (veh.mControl != prev.mControl)
+          Add(ring, rF2RaceEventType::ControlChanged, et, veh.mID, prev.mControl, veh.mControl, 0.0);
+
+        if (veh.mNumPenalties != prev.mNumPenalties)
+          Add(ring, rF2RaceEventType::PenaltiesChanged, et, veh.mID, prev.mNumPenalties, veh.mNumPenalties, 0.0);
+      }
+
+      prev.mPresent = true;
+      prev.mID = veh.mID;
+      prev.mLastSeenUpdate = mUpdateNumber;
+      prev.mTotalLaps = veh.mTotalLaps;
+      prev.mInPits = veh.mInPits;
+      prev.mPitState = veh.mPitState;
+      prev.mPlace = veh.mPlace;
+      prev.mFinishStatus = veh.mFinishStatus;
+      prev.mControl = veh.mControl;
+      prev.mNumPenalties = veh.mNumPenalties;
+    }
+
+    // Vehicles not seen in this update left.
+    for (int id = 0; id < rF2MappedBufferHeader::MAX_MAPPED_IDS; ++id) {
+      auto& prev = mVehicles[id];
+      if (prev.mPresent && prev.mLastSeenUpdate != mUpdateNumber) {
+        Add(ring, rF2RaceEventType::VehicleLeft, et, prev.mID, prev.mPlace, 0L, 0.0);
+        prev.mPresent = false;
+      }
+    }
+  }
+
+private:
+  struct VehicleState
+  {
+    bool mPresent;
+    long mID;
+    unsigned int mLastSeenUpdate;
+    short mTotalLaps;
+    bool mInPits;
+    unsigned char mPitState;
+    unsigned char mPlace;
+    signed char mFinishStatus;
+    signed char mControl;
+    short mNumPenalties;
+  };
+
+  VehicleState mVehicles[rF2MappedBufferHeader::MAX_MAPPED_IDS] = {};
+  unsigned int mUpdateNumber = 0u;
+  unsigned char mGamePhase = 0;
+  signed char mYellowFlagState = 0;
+  bool mHaveBaseline = false;
+};
@@ -0,0 +1,104 @@
+/*
+Sequence counter (seqlock) helpers used to publish mapped buffers without locks.
+
+Author: The Iron Wolf (vleonavicius@hotmail.com)
+Website: thecrewchief.org
+
+Description:
+  Each mapped buffer header carries mSequence counter.  Writer increments it to an odd value
+  before touching the buffer, and increments it again (back to even) once buffer contents are
+  complete.  Readers read the counter, copy the buffer and read the counter again.  If the counter
+  was odd, or changed during the copy, the copy is torn and has to be retried.
+
+  Neither side makes kernel calls, and the writer never waits for readers.
+
+  Those helpers only depend on BuffT having mSequence member, so they can be used outside of the
+  plugin (clients, stress tools).
+*/
+#pragma once
+
+#include <atomic>
+#include <string.h>
+
+namespace Seqlock
+{
+  template <typename BuffT>
+  inline unsigned int LoadSequence(BuffT const* pBuf)
+  {
+    return *static_cast<unsigned int const volatile*>(&pBuf->mSequence);
+  }
+
+  template <typename BuffT>
+  inline void StoreSequence(BuffT* pBuf, unsigned int sequence)
+  {
+    *static_cast<unsigned int volatile*>(&pBuf->mSequence) = sequence;
+  }
+
+  inline bool IsWriteInProgress(unsigned int sequence) { return (sequence & 1u) != 0u; }
+
+  ////////////////////////////////////
+  // Writer side.
+  ////////////////////////////////////
+
+  // Marks buffer as being written to.  Must be called before any write to the buffer contents.
+  template <typename BuffT>
+  inline void BeginWrite(BuffT* pBuf)
+  {
+    auto const sequence = LoadSequence(pBuf);
+    StoreSequence(pBuf, IsWriteInProgress(sequence) ? sequence : sequence + 1u);
+
+    // Counter store has to be visible before any of the buffer writes.
+    std::atomic_thread_fence(std::memory_order_release);
+  }
+
+  // Marks buffer contents as complete.
+  template <typename BuffT>
+  inline void EndWrite(BuffT* pBuf)
+  {
+    // Buffer writes have to be visible before the counter store.
+    std::atomic_thread_fence(std::memory_order_release);
+
+    auto const sequence = LoadSequence(pBuf);
+    StoreSequence(pBuf, IsWriteInProgress(sequence) ? sequence + 1u : sequence + 2u);
+  }
+
+  ////////////////////////////////////
+  // Reader side.
+  ////////////////////////////////////
+
+  template <typename BuffT>
+  inline unsigned int ReadBegin(BuffT const* pBuf)
+  {
+    auto const sequence = LoadSequence(pBuf);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return sequence;
+  }
+
+  // Returns true if data read since ReadBegin returned sequenceBegin is consistent.
+  template <typename BuffT>
+  inline bool ReadValidate(BuffT const* pBuf, unsigned int sequenceBegin)
+  {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return !IsWriteInProgress(sequenceBegin) && LoadSequence(pBuf) == sequenceBegin;
+  }
+
+  // Copies current read buffer of the double buffered pair into pDest.  Gives up after maxAttempts torn copies.
+  template <typename BuffT>
+  inline bool ReadSnapshot(BuffT const* pBuf1, BuffT const* pBuf2, BuffT* pDest, int maxAttempts)
+  {
+    for (int attempt = 0; attempt < maxAttempts; ++attempt) {
+      auto const pBuf = *static_cast<bool const volatile*>(&pBuf1->mCurrentRead) ? pBuf1 : pBuf2;
+
+      auto const sequence = ReadBegin(pBuf);
+      if (IsWriteInProgress(sequence))
+        continue;  // Buffer got flipped to write since we checked mCurrentRead.
+
+      memcpy(pDest, pBuf, sizeof(BuffT));
+
+      if (ReadValidate(pBuf, sequence))
+        return true;
+    }
+
+    return false;
+  }
+}
@@ -0,0 +1,135 @@
+/*
+Definition of SpscRing class.
+
+Author: The Iron Wolf (vleonavicius@hotmail.com)
+Website: thecrewchief.org
+
+Description:
+  SpscRing is a bounded lock-free single producer/single consumer queue of preallocated slots.
+
+  Slots are filled and consumed in place, so large payloads (whole telemetry frames) are never copied
+  through the queue:
+    producer: BeginPush() -> fill the slot -> EndPush()
+    consumer: Front() -> read the slot -> Pop()
+
+  Producer never blocks or makes kernel calls; BeginPush returns nullptr if the ring is full and it is up
+  to the caller to drop or retry.  Head and tail live on separate cache lines so that producer and consumer
+  do not false share, and each side keeps a cached copy of the other's index.
+*/
+#pragma once
+
+#include <atomic>
+#include <new>                                  // std::nothrow
+
+template <typename SlotT>
+class SpscRing
+{
+public:
+  SpscRing()
+    : mHead(0u)
+    , mTail(0u)
+  {}
+
+  ~SpscRing()
+  {
+    ReleaseResources();
+  }
+
+  // Capacity is rounded up to a power of two.
+  bool Initialize(unsigned int capacity)
+  {
+    assert(mpSlots == nullptr);
+
+    mCapacity = 1u;
+    while (mCapacity < capacity)
+      mCapacity <<= 1;
+
+    // Value initialization also commits slot pages up front, so producer does not page fault on first use.
+    mpSlots = new (std::nothrow) SlotT[mCapacity]();
+    if (mpSlots == nullptr) {
+      mCapacity = 0u;
+      return false;
+    }
+
+    mHead.store(0u, std::memory_order_relaxed);
+    mTail.store(0u, std::memory_order_relaxed);
+    mTailCache = 0u;
+    mHeadCache = 0u;
+
+    return true;
+  }
+
+  void ReleaseResources()
+  {
+    delete[] mpSlots;
+    mpSlots = nullptr;
+    mCapacity = 0u;
+  }
+
+  bool IsInitialized() const { return mpSlots != nullptr; }
+  unsigned int Capacity() const { return mCapacity; }
+
+  // Producer side.  Returns slot to fill, or nullptr if ring is full.
+  SlotT* BeginPush()
+  {
+    auto const head = mHead.load(std::memory_order_relaxed);
+    if (head - mTailCache >= mCapacity) {
+      mTailCache = mTail.load(std::memory_order_acquire);
+      if (head - mTailCache >= mCapacity)
+        return nullptr;
+    }
+
+    return &mpSlots[head & (mCapacity - 1u)];
+  }
+
+  // Producer side.  Publishes slot returned by the last BeginPush to the consumer.
+  void EndPush()
+  {
+    mHead.store(mHead.load(std::memory_order_relaxed) + 1u, std::memory_order_release);
+  }
+
+  // Consumer side.  Returns oldest published slot, or nullptr if ring is empty.
+  SlotT* Front()
+  {
+    auto const tail = mTail.load(std::memory_order_relaxed);
+    if (tail == mHeadCache) {
+      mHeadCache = mHead.load(std::memory_order_acquire);
+      if (tail == mHeadCache)
+        return nullptr;
+    }
+
+    return &mpSlots[tail & (mCapacity - 1u)];
+  }
+
+  // Consumer side.  Returns slot returned by the last Front to the producer.
+  void Pop()
+  {
+    mTail.store(mTail.load(std::memory_order_relaxed) + 1u, std::memory_order_release);
+  }
+
+  // Approximate, can be called from either side.
+  unsigned int Size() const
+  {
+    return mHead.load(std::memory_order_acquire) - mTail.load(std::memory_order_acquire);
+  }
+
+private:
+  SpscRing(SpscRing const&) = delete;
+  SpscRing& operator=(SpscRing const&) = delete;
+
+  static int const CACHE_LINE_BYTES = 64;
+
+  // Written by producer only.  Producer re-reads mTail only when ring looks full, so it does not pull
+  // consumer's cache line on every push (and vice versa).
+  std::atomic<unsigned int> mHead;
+  unsigned int mTailCache = 0u;
+  char mHeadPadding[CACHE_LINE_BYTES - sizeof(std::atomic<unsigned int>) - sizeof(unsigned int)];
+
+  // Written by consumer only.
+  std::atomic<unsigned int> mTail;
+  unsigned int mHeadCache = 0u;
+  char mTailPadding[CACHE_LINE_BYTES - sizeof(std::atomic<unsigned int>) - sizeof(unsigned int)];
+
+  SlotT* mpSlots = nullptr;
+  unsigned int mCapacity = 0u;
+};
@@ -0,0 +1,37 @@
+/*
+Log2 histogram helpers used by the statistics buffer (see rF2Stats).
+
+Author: The Iron Wolf (vleonavicius@hotmail.com)
+Website: thecrewchief.org
+
+Description:
+  Bucket i counts values in [2^i, 2^(i+1)).  Bucket 0 also counts 0, and the last bucket counts everything that
+  does not fit.  Adding a value is a handful of shifts, so it can be done on every flip.
+*/
+#pragma once
+
+namespace StatsHistogram
+{
+  inline int Log2Bucket(unsigned long long value, int numBuckets)
+  {
+    auto bucket = 0;
+    while (value > 1uLL && bucket < numBuckets - 1) {
+      value >>= 1;
+      ++bucket;
+    }
+
+    return bucket;
+  }
+
+  template <int NumBuckets>
+  inline void AddLog2(unsigned long long (&buckets)[NumBuckets], unsigned long long value)
+  {
+    ++buckets[Log2Bucket(value, NumBuckets)];
+  }
+
+  // Microsecond interval to nanoseconds, negative (clock went backwards) counts as 0.
+  inline unsigned long long MicrosecondsToNanoseconds(double microseconds)
+  {
+    return microseconds > 0.0 ? static_cast<unsigned long long>(microseconds * 1000.0) : 0uLL;
+  }
+}
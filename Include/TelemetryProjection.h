@@ -0,0 +1,192 @@
+/*
+Definition of TelemetryProjection class.
+
+Author: The Iron Wolf (vleonavicius@hotmail.com)
+Website: thecrewchief.org
+
+Description:
+  TelemetryProjection copies a configured subset of rF2VehicleTelemetry members into a tightly packed
+  record (see rF2LiteTelemetry).
+
+  Fields are added by name, in the order they should appear in the record.  Fields that are adjacent
+  in rF2VehicleTelemetry and in the record are merged into a single copy run, so selecting neighbouring
+  members (mPos, mLocalVel, mLocalAccel) costs a single memcpy.
+*/
+#pragma once
+
+#include <cstddef>                              // offsetof
+#include <string.h>
+
+class TelemetryProjection
+{
+public:
+  struct FieldInfo
+  {
+    char const* mName;
+    int mOffset;
+    int mSize;
+  };
+
+  // Adds field to the end of the record.  Returns false if field is unknown, already added, or record is full.
+  bool AddField(char const* name)
+  {
+    auto const pField = FindField(name);
+    if (pField == nullptr
+      || mNumFields >= rF2LiteTelemetry::MAX_FIELDS
+      || mRecordBytes + pField->mSize > rF2LiteTelemetry::MAX_RECORD_BYTES)
+      return false;
+
+    for (int i = 0; i < mNumFields; ++i) {
+      if (mFields[i] == pField)
+        return false;
+    }
+
+    mFields[mNumFields++] = pField;
+
+    // Extend the last run if the field directly follows it in the source.
+    if (mNumRuns > 0 && mRuns[mNumRuns - 1].mSourceOffset + mRuns[mNumRuns - 1].mSize == pField->mOffset)
+      mRuns[mNumRuns - 1].mSize += pField->mSize;
+    else {
+      mRuns[mNumRuns].mSourceOffset = pField->mOffset;
+      mRuns[mNumRuns].mRecordOffset = mRecordBytes;
+      mRuns[mNumRuns].mSize = pField->mSize;
+      ++mNumRuns;
+    }
+
+    mRecordBytes += pField->mSize;
+
+    return true;
+  }
+
+  void Clear()
+  {
+    mNumFields = 0;
+    mNumRuns = 0;
+    mRecordBytes = 0;
+  }
+
+  int NumFields() const { return mNumFields; }
+  int NumCopyRuns() const { return mNumRuns; }
+  int RecordBytes() const { return mRecordBytes; }
+
+  // Writes the self describing part of the header.  Layout does not change while plugin runs, so this is done once,
+  // and the header is passed to the mapped buffer as its initial contents.
+  void WriteLayout(rF2LiteTelemetryHeader* pBuf) const
+  {
+    pBuf->mNumFields = mNumFields;
+    pBuf->mRecordBytes = mRecordBytes;
+
+    auto recordOffset = 0;
+    for (int i = 0; i < mNumFields; ++i) {
+      auto& field = pBuf->mFields[i];
+      strcpy_s(field.mName, mFields[i]->mName);
+      field.mOffset = recordOffset;
+      field.mSize = mFields[i]->mSize;
+
+      recordOffset += field.mSize;
+    }
+  }
+
+  void Project(TelemInfoV01 const& info, unsigned char* pRecord) const
+  {
+    auto const pSource = reinterpret_cast<unsigned char const*>(&info);
+    for (int i = 0; i < mNumRuns; ++i)
+      memcpy(pRecord + mRuns[i].mRecordOffset, pSource + mRuns[i].mSourceOffset, mRuns[i].mSize);
+  }
+
+private:
+  struct CopyRun
+  {
+    int mSourceOffset;
+    int mRecordOffset;
+    int mSize;
+  };
+
+  static FieldInfo const* FindField(char const* name)
+  {
+#define RF2_TELEMETRY_FIELD(field) { #field, static_cast<int>(offsetof(rF2VehicleTelemetry, field)), static_cast<int>(sizeof(rF2VehicleTelemetry::field)) }
+    static FieldInfo const fields[] =
+    {
+      RF2_TELEMETRY_FIELD(mID),
+      RF2_TELEMETRY_FIELD(mDeltaTime),
+      RF2_TELEMETRY_FIELD(mElapsedTime),
+      RF2_TELEMETRY_FIELD(mLapNumber),
+      RF2_TELEMETRY_FIELD(mLapStartET),
+      RF2_TELEMETRY_FIELD(mVehicleName),
+      RF2_TELEMETRY_FIELD(mTrackName),
+      RF2_TELEMETRY_FIELD(mPos),
+      RF2_TELEMETRY_FIELD(mLocalVel),
+      RF2_TELEMETRY_FIELD(mLocalAccel),
+      RF2_TELEMETRY_FIELD(mOri),
+      RF2_TELEMETRY_FIELD(mLocalRot),
+      RF2_TELEMETRY_FIELD(mLocalRotAccel),
+      RF2_TELEMETRY_FIELD(mGear),
+      RF2_TELEMETRY_FIELD(mEngineRPM),
+      RF2_TELEMETRY_FIELD(mEngineWaterTemp),
+      RF2_TELEMETRY_FIELD(mEngineOilTemp),
+      RF2_TELEMETRY_FIELD(mClutchRPM),
+      RF2_TELEMETRY_FIELD(mUnfilteredThrottle),
+      RF2_TELEMETRY_FIELD(mUnfilteredBrake),
+      RF2_TELEMETRY_FIELD(mUnfilteredSteering),
+      RF2_TELEMETRY_FIELD(mUnfilteredClutch),
+      RF2_TELEMETRY_FIELD(mFilteredThrottle),
+      RF2_TELEMETRY_FIELD(mFilteredBrake),
+      RF2_TELEMETRY_FIELD(mFilteredSteering),
+      RF2_TELEMETRY_FIELD(mFilteredClutch),
+      RF2_TELEMETRY_FIELD(mSteeringShaftTorque),
+      RF2_TELEMETRY_FIELD(mFront3rdDeflection),
+      RF2_TELEMETRY_FIELD(mRear3rdDeflection),
+      RF2_TELEMETRY_FIELD(mFrontWingHeight),
+      RF2_TELEMETRY_FIELD(mFrontRideHeight),
+      RF2_TELEMETRY_FIELD(mRearRideHeight),
+      RF2_TELEMETRY_FIELD(mDrag),
+      RF2_TELEMETRY_FIELD(mFrontDownforce),
+      RF2_TELEMETRY_FIELD(mRearDownforce),
+      RF2_TELEMETRY_FIELD(mFuel),
+      RF2_TELEMETRY_FIELD(mEngineMaxRPM),
+      RF2_TELEMETRY_FIELD(mScheduledStops),
+      RF2_TELEMETRY_FIELD(mOverheating),
+      RF2_TELEMETRY_FIELD(mDetached),
+      RF2_TELEMETRY_FIELD(mHeadlights),
+      RF2_TELEMETRY_FIELD(mDentSeverity),
+      RF2_TELEMETRY_FIELD(mLastImpactET),
+      RF2_TELEMETRY_FIELD(mLastImpactMagnitude),
+      RF2_TELEMETRY_FIELD(mLastImpactPos),
+      RF2_TELEMETRY_FIELD(mEngineTorque),
+      RF2_TELEMETRY_FIELD(mCurrentSector),
+      RF2_TELEMETRY_FIELD(mSpeedLimiter),
+      RF2_TELEMETRY_FIELD(mMaxGears),
+      RF2_TELEMETRY_FIELD(mFrontTireCompoundIndex),
+      RF2_TELEMETRY_FIELD(mRearTireCompoundIndex),
+      RF2_TELEMETRY_FIELD(mFuelCapacity),
+      RF2_TELEMETRY_FIELD(mFrontFlapActivated),
+      RF2_TELEMETRY_FIELD(mRearFlapActivated),
+      RF2_TELEMETRY_FIELD(mRearFlapLegalStatus),
+      RF2_TELEMETRY_FIELD(mIgnitionStarter),
+      RF2_TELEMETRY_FIELD(mFrontTireCompoundName),
+      RF2_TELEMETRY_FIELD(mRearTireCompoundName),
+      RF2_TELEMETRY_FIELD(mSpeedLimiterAvailable),
+      RF2_TELEMETRY_FIELD(mAntiStallActivated),
+      RF2_TELEMETRY_FIELD(mVisualSteeringWheelRange),
+      RF2_TELEMETRY_FIELD(mRearBrakeBias),
+      RF2_TELEMETRY_FIELD(mTurboBoostPressure),
+      RF2_TELEMETRY_FIELD(mPhysicsToGraphicsOffset),
+      RF2_TELEMETRY_FIELD(mPhysicalSteeringWheelRange),
+      RF2_TELEMETRY_FIELD(mWheels)
+    };
+#undef RF2_TELEMETRY_FIELD
+
+    for (auto const& field : fields) {
+      if (strcmp(field.mName, name) == 0)
+        return &field;
+    }
+
+    return nullptr;
+  }
+
+  FieldInfo const* mFields[rF2LiteTelemetry::MAX_FIELDS] = {};
+  CopyRun mRuns[rF2LiteTelemetry::MAX_FIELDS] = {};
+  int mNumFields = 0;
+  int mNumRuns = 0;
+  int mRecordBytes = 0;
+};
@@ -0,0 +1,288 @@
+/*
+Definition of TelemetryRecorder class.
+
+Author: The Iron Wolf (vleonavicius@hotmail.com)
+Website: thecrewchief.org
+
+Description:
+  TelemetryRecorder writes complete telemetry frames to a compressed recording file (see TelemetryRecording.h)
+  off the simulation thread.
+
+  Simulation thread copies each completed frame into a preallocated slot of SpscRing and returns; it never
+  waits, allocates or makes kernel calls.  If the writer thread falls behind and the ring is full, the frame
+  is dropped and counted (chunk frame numbers show the gap).  Writer thread polls the ring, encodes frames
+  and appends chunks to the current recording file.
+
+  New file is started on the first frame after Start or EndSession:
+    RF2SMMP_TelemetryRecording_<YYYYMMDD>_<HHMMSS>.rf2tr
+
+  Sizing: 128 vehicles at 50Hz is about 12MB/s of raw records, ~85GB for a 2 hour race.  XOR encoding of
+  PluginHost sessions comes out at ~5% of raw (~4.5GB per 2 hours); real sessions compress less, since more
+  channels change every frame.  Writer encodes several hundred 128 vehicle frames per second, so there is
+  plenty of headroom at 50Hz.  Cost on the simulation thread is one copy of the completed frame.
+*/
+#pragma once
+
+#include <atomic>
+#include <stdio.h>
+#include <time.h>
+
+class TelemetryRecorder
+{
+public:
+  // About 0.6 seconds of frames at 50Hz, ~7.5MB.
+  static unsigned int const QUEUE_FRAMES = 32u;
+  static unsigned int const KEYFRAME_INTERVAL_FRAMES = 100u;
+  static unsigned long const WRITER_IDLE_SLEEP_MS = 5uL;
+  static unsigned long const END_SESSION_WAIT_MS = 100uL;
+  static int const FILE_IO_BUFFER_BYTES = 1024 * 1024;
+
+  TelemetryRecorder()
+    : mStopRequested(false)
+    , mFramesDropped(0uLL)
+    , mFramesWritten(0uLL)
+    , mBytesWritten(0uLL)
+    , mFileErrors(0u)
+  {}
+
+  ~TelemetryRecorder()
+  {
+    Stop();
+  }
+
+  // Simulation thread.  Allocates queue and encoder state, starts the writer thread.
+  bool Start()
+  {
+    if (IsRunning())
+      return true;
+
+    if (!mQueue.Initialize(QUEUE_FRAMES)
+      || !mEncoder.Initialize()
+      || (mpPayload == nullptr && (mpPayload = new (std::nothrow) unsigned char[TelemetryRecording::ReferenceRecords::MAX_PAYLOAD_BYTES]) == nullptr)) {
+      ReleaseResources();
+      return false;
+    }
+
+    mStopRequested.store(false);
+    mhWriterThread = Platform::StartThread(TelemetryRecorder::WriterThreadProc, this);
+    if (mhWriterThread == nullptr) {
+      ReleaseResources();
+      return false;
+    }
+
+    return true;
+  }
+
+  // Simulation thread.  Writes out queued frames, closes the file and stops the writer thread.
+  void Stop()
+  {
+    if (mhWriterThread != nullptr) {
+      mStopRequested.store(true);
+      Platform::JoinThread(mhWriterThread);
+      mhWriterThread = nullptr;
+    }
+
+    ReleaseResources();
+  }
+
+  bool IsRunning() const { return mhWriterThread != nullptr; }
+
+  // Simulation thread.  Never blocks: returns false if frame was dropped because writer is behind.
+  bool SubmitFrame(rF2VehicleTelemetry const* pVehicles, int numVehicles)
+  {
+    auto const frameNumber = mFramesSubmitted++;
+
+    auto const pSlot = mQueue.BeginPush();
+    if (pSlot == nullptr) {
+      mFramesDropped.fetch_add(1uLL, std::memory_order_relaxed);
+      return false;
+    }
+
+    pSlot->mKind = QueuedFrame::Kind::Frame;
+    pSlot->mFrameNumber = frameNumber;
+    pSlot->mNumVehicles = numVehicles;
+    memcpy(pSlot->mVehicles, pVehicles, numVehicles * sizeof(rF2VehicleTelemetry));
+
+    mQueue.EndPush();
+    return true;
+  }
+
+  // Simulation thread.  Queues end of session marker, current file is closed once frames before it are written.
+  // Waits up to END_SESSION_WAIT_MS if the queue is full.
+  bool EndSession()
+  {
+    if (!IsRunning())
+      return false;
+
+    auto const waitStartTicks = Platform::TickCountMillis();
+    QueuedFrame* pSlot = nullptr;
+    while ((pSlot = mQueue.BeginPush()) == nullptr) {
+      if (Platform::TickCountMillis() - waitStartTicks > END_SESSION_WAIT_MS)
+        return false;
+
+      Platform::SleepMillis(1uL);
+    }
+
+    pSlot->mKind = QueuedFrame::Kind::EndOfSession;
+    mQueue.EndPush();
+
+    return true;
+  }
+
+  // Simulation thread.
+  unsigned long long FramesSubmitted() const { return mFramesSubmitted; }
+
+  // Safe to read from any thread.
+  unsigned long long FramesDropped() const { return mFramesDropped.load(std::memory_order_relaxed); }
+  unsigned long long FramesWritten() const { return mFramesWritten.load(std::memory_order_relaxed); }
+  unsigned long long BytesWritten() const { return mBytesWritten.load(std::memory_order_relaxed); }
+  unsigned int FileErrors() const { return mFileErrors.load(std::memory_order_relaxed); }
+
+private:
+  TelemetryRecorder(TelemetryRecorder const&) = delete;
+  TelemetryRecorder& operator=(TelemetryRecorder const&) = delete;
+
+  struct QueuedFrame
+  {
+    enum class Kind
+    {
+      Frame,
+      EndOfSession
+    };
+
+    Kind mKind;
+    unsigned long long mFrameNumber;
+    int mNumVehicles;
+    rF2VehicleTelemetry mVehicles[rF2MappedBufferHeader::MAX_MAPPED_VEHICLES];
+  };
+
+  static void WriterThreadProc(void* pContext)
+  {
+    static_cast<TelemetryRecorder*>(pContext)->WriterLoop();
+  }
+
+  // Writer thread.
+  void WriterLoop()
+  {
+    for (;;) {
+      auto const pFrame = mQueue.Front();
+      if (pFrame == nullptr) {
+        // Stop is only honoured once queue is drained.
+        if (mStopRequested.load())
+          break;
+
+        Platform::SleepMillis(WRITER_IDLE_SLEEP_MS);
+        continue;
+      }
+
+      if (pFrame->mKind == QueuedFrame::Kind::EndOfSession)
+        CloseFile();
+      else
+        WriteFrame(*pFrame);
+
+      mQueue.Pop();
+    }
+
+    CloseFile();
+  }
+
+  // Writer thread.
+  void WriteFrame(QueuedFrame const& frame)
+  {
+    if (mpFile == nullptr && !OpenFile())
+      return;
+
+    auto const type = mFramesInFile % KEYFRAME_INTERVAL_FRAMES == 0uLL
+      ? TelemetryRecording::ChunkType::Keyframe
+      : TelemetryRecording::ChunkType::Delta;
+
+    TelemetryRecording::rF2TelemetryRecordingChunkHeader chunk = {};
+    chunk.mMagic = TelemetryRecording::CHUNK_MAGIC;
+    chunk.mType = type;
+    chunk.mFrameNumber = frame.mFrameNumber;
+    chunk.mElapsedTime = frame.mNumVehicles > 0 ? frame.mVehicles[0].mElapsedTime : 0.0;
+    chunk.mNumVehicles = frame.mNumVehicles;
+    chunk.mPayloadBytes = mEncoder.Encode(frame.mVehicles, frame.mNumVehicles, type, mpPayload);
+    chunk.mFrameCrc = TelemetryRecording::Crc32(frame.mVehicles, frame.mNumVehicles * sizeof(rF2VehicleTelemetry));
+
+    if (fwrite(&chunk, sizeof(chunk), 1, mpFile) != 1
+      || fwrite(mpPayload, 1, chunk.mPayloadBytes, mpFile) != chunk.mPayloadBytes) {
+      mFileErrors.fetch_add(1u, std::memory_order_relaxed);
+      CloseFile();
+      return;
+    }
+
+    ++mFramesInFile;
+    mFramesWritten.fetch_add(1uLL, std::memory_order_relaxed);
+    mBytesWritten.fetch_add(sizeof(chunk) + chunk.mPayloadBytes, std::memory_order_relaxed);
+  }
+
+  // Writer thread.
+  bool OpenFile()
+  {
+    auto const now = time(nullptr);
+    char fileName[MAX_PATH] = {};
+    strftime(fileName, sizeof(fileName), "RF2SMMP_TelemetryRecording_%Y%m%d_%H%M%S.rf2tr", localtime(&now));
+
+    mpFile = fopen(fileName, "wb");
+    if (mpFile == nullptr) {
+      mFileErrors.fetch_add(1u, std::memory_order_relaxed);
+      return false;
+    }
+
+    setvbuf(mpFile, nullptr, _IOFBF, FILE_IO_BUFFER_BYTES);
+
+    TelemetryRecording::rF2TelemetryRecordingFileHeader header = {};
+    memcpy(header.mMagic, TelemetryRecording::FILE_MAGIC, sizeof(header.mMagic));
+    header.mVersion = TelemetryRecording::FORMAT_VERSION;
+    header.mVehicleRecordBytes = sizeof(rF2VehicleTelemetry);
+    header.mKeyframeInterval = KEYFRAME_INTERVAL_FRAMES;
+    header.mMaxVehicles = rF2MappedBufferHeader::MAX_MAPPED_VEHICLES;
+
+    if (fwrite(&header, sizeof(header), 1, mpFile) != 1) {
+      mFileErrors.fetch_add(1u, std::memory_order_relaxed);
+      CloseFile();
+      return false;
+    }
+
+    mFramesInFile = 0uLL;
+    return true;
+  }
+
+  // Writer thread.
+  void CloseFile()
+  {
+    if (mpFile != nullptr) {
+      fclose(mpFile);
+      mpFile = nullptr;
+    }
+  }
+
+  void ReleaseResources()
+  {
+    assert(mhWriterThread == nullptr);
+
+    mQueue.ReleaseResources();
+
+    delete[] mpPayload;
+    mpPayload = nullptr;
+  }
+
+  // Shared between simulation and writer threads.
+  SpscRing<QueuedFrame> mQueue;
+  Platform::ThreadHandle mhWriterThread = nullptr;
+  std::atomic<bool> mStopRequested;
+  std::atomic<unsigned long long> mFramesDropped;
+  std::atomic<unsigned long long> mFramesWritten;
+  std::atomic<unsigned long long> mBytesWritten;
+  std::atomic<unsigned int> mFileErrors;
+
+  // Simulation thread only.
+  unsigned long long mFramesSubmitted = 0uLL;
+
+  // Writer thread only.
+  TelemetryRecording::FrameEncoder mEncoder;
+  unsigned char* mpPayload = nullptr;
+  FILE* mpFile = nullptr;
+  unsigned long long mFramesInFile = 0uLL;
+};
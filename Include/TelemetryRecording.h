@@ -0,0 +1,282 @@
+/*
+Telemetry recording file format, frame encoder and decoder.
+
+Author: The Iron Wolf (vleonavicius@hotmail.com)
+Website: thecrewchief.org
+
+Description:
+  Recording is a file header followed by one chunk per telemetry frame:
+    rF2TelemetryRecordingFileHeader
+    rF2TelemetryRecordingChunkHeader, payload
+    rF2TelemetryRecordingChunkHeader, payload
+    ...
+
+  Payload holds mNumVehicles encoded vehicle records.  Each rF2VehicleTelemetry is treated as an array
+  of 32bit words (channels) and XORed against the record of the same mID in the previously encoded frame.
+  Unchanged channels XOR to zero, slowly changing doubles XOR to words with zero high bytes.
+  Encoded vehicle record:
+    int mID
+    bitmap, one bit per word, set if XORed word is non zero
+    one nibble per non zero word, bit b set if byte b of the XORed word is non zero
+    non zero bytes of the non zero words
+
+  Keyframe chunks are XORed against zeroes, so decoding can start at any keyframe.  Every chunk carries
+  CRC32 of the source vehicle records, which lets the decoder verify the round trip.
+
+  Encoder and decoder only depend on rF2State.h, so they are shared by the plugin and the decoder tool.
+  Note that the record layout depends on the ABI the plugin was built for (mVehicleRecordBytes).
+*/
+#pragma once
+
+#include <new>                                  // std::nothrow
+#include <stddef.h>
+#include <string.h>
+
+namespace TelemetryRecording
+{
+  unsigned int const FORMAT_VERSION = 1u;
+  unsigned int const CHUNK_MAGIC = 0x4b4e4843u;  // "CHNK"
+  char const FILE_MAGIC[8] = { 'R', 'F', '2', 'S', 'M', 'T', 'R', '\0' };
+
+  enum class ChunkType : unsigned int
+  {
+    Keyframe = 1,
+    Delta = 2
+  };
+
+#pragma pack(push, 4)
+  struct rF2TelemetryRecordingFileHeader
+  {
+    char mMagic[8];                      // FILE_MAGIC
+    unsigned int mVersion;               // FORMAT_VERSION
+    unsigned int mVehicleRecordBytes;    // sizeof(rF2VehicleTelemetry) of the writer
+    unsigned int mKeyframeInterval;      // Frames between keyframes
+    unsigned int mMaxVehicles;           // rF2MappedBufferHeader::MAX_MAPPED_VEHICLES of the writer
+  };
+
+  struct rF2TelemetryRecordingChunkHeader
+  {
+    unsigned int mMagic;                 // CHUNK_MAGIC
+    ChunkType mType;
+    unsigned long long mFrameNumber;     // Frames submitted since recorder start.  Gaps mean frames were dropped.
+    double mElapsedTime;                 // ET of the first vehicle in frame
+    int mNumVehicles;
+    unsigned int mPayloadBytes;
+    unsigned int mFrameCrc;              // CRC32 of mNumVehicles source rF2VehicleTelemetry records
+  };
+#pragma pack(pop)
+
+  inline unsigned int Crc32(void const* pData, size_t bytes)
+  {
+    static unsigned int table[256] = {};
+    if (table[1] == 0u) {
+      for (unsigned int i = 0u; i < 256u; ++i) {
+        auto c = i;
+        for (int bit = 0; bit < 8; ++bit)
+          c = (c & 1u) != 0u ? 0xedb88320u ^ (c >> 1) : c >> 1;
+
+        table[i] = c;
+      }
+    }
+
+    auto crc = 0xffffffffu;
+    auto const pBytes = static_cast<unsigned char const*>(pData);
+    for (size_t i = 0; i < bytes; ++i)
+      crc = table[(crc ^ pBytes[i]) & 0xffu] ^ (crc >> 8);
+
+    return crc ^ 0xffffffffu;
+  }
+
+  // Last record encoded/decoded for each mID.  Encoder and decoder have to update it identically.
+  class ReferenceRecords
+  {
+  public:
+    static unsigned int const RECORD_BYTES = sizeof(rF2VehicleTelemetry);
+    static unsigned int const RECORD_WORDS = RECORD_BYTES / sizeof(unsigned int);
+    static unsigned int const BITMAP_BYTES = (RECORD_WORDS + 7u) / 8u;
+    static unsigned int const MAX_NIBBLE_BYTES = (RECORD_WORDS + 1u) / 2u;
+
+    // Worst case size of an encoded vehicle record and of a frame payload.
+    static unsigned int const MAX_ENCODED_RECORD_BYTES = sizeof(int) + BITMAP_BYTES + MAX_NIBBLE_BYTES + RECORD_BYTES;
+    static unsigned int const MAX_PAYLOAD_BYTES = MAX_ENCODED_RECORD_BYTES * rF2MappedBufferHeader::MAX_MAPPED_VEHICLES;
+
+    static_assert(RECORD_BYTES % sizeof(unsigned int) == 0u, "rF2VehicleTelemetry is expected to be a whole number of words.");
+
+    ReferenceRecords() {}
+
+    ~ReferenceRecords()
+    {
+      delete[] mpWords;
+    }
+
+    bool Initialize()
+    {
+      if (mpWords == nullptr)
+        mpWords = new (std::nothrow) unsigned int[rF2MappedBufferHeader::MAX_MAPPED_IDS * RECORD_WORDS];
+
+      if (mpWords == nullptr)
+        return false;
+
+      Reset();
+      return true;
+    }
+
+    void Reset()
+    {
+      memset(mpWords, 0, sizeof(unsigned int) * rF2MappedBufferHeader::MAX_MAPPED_IDS * RECORD_WORDS);
+    }
+
+  protected:
+    unsigned int* Reference(int id)
+    {
+      // IDs outside of the range share references, which only costs compression.
+      return mpWords + (static_cast<unsigned int>(id) % rF2MappedBufferHeader::MAX_MAPPED_IDS) * RECORD_WORDS;
+    }
+
+    unsigned int* mpWords = nullptr;
+
+  private:
+    ReferenceRecords(ReferenceRecords const&) = delete;
+    ReferenceRecords& operator=(ReferenceRecords const&) = delete;
+  };
+
+  class FrameEncoder : public ReferenceRecords
+  {
+  public:
+    // Encodes numVehicles records into pPayload (at least MAX_PAYLOAD_BYTES).  Returns payload size.
+    unsigned int Encode(rF2VehicleTelemetry const* pVehicles, int numVehicles, ChunkType type, unsigned char* pPayload)
+    {
+      if (type == ChunkType::Keyframe)
+        Reset();
+
+      auto p = pPayload;
+      for (int i = 0; i < numVehicles; ++i)
+        p = EncodeRecord(pVehicles[i], p);
+
+      return static_cast<unsigned int>(p - pPayload);
+    }
+
+  private:
+    unsigned char* EncodeRecord(rF2VehicleTelemetry const& vehicle, unsigned char* p)
+    {
+      int const id = static_cast<int>(vehicle.mID);
+      memcpy(p, &id, sizeof(id));
+      p += sizeof(id);
+
+      auto const pBitmap = p;
+      memset(pBitmap, 0, BITMAP_BYTES);
+      p += BITMAP_BYTES;
+
+      auto const pReference = Reference(id);
+      unsigned int numChanged = 0u;
+      for (unsigned int w = 0u; w < RECORD_WORDS; ++w) {
+        unsigned int word = 0u;
+        memcpy(&word, reinterpret_cast<unsigned char const*>(&vehicle) + w * sizeof(unsigned int), sizeof(word));
+
+        mXorWords[w] = word ^ pReference[w];
+        pReference[w] = word;
+
+        if (mXorWords[w] != 0u) {
+          pBitmap[w / 8u] |= static_cast<unsigned char>(1u << (w % 8u));
+          mChangedWords[numChanged++] = w;
+        }
+      }
+
+      auto const pNibbles = p;
+      memset(pNibbles, 0, (numChanged + 1u) / 2u);
+      p += (numChanged + 1u) / 2u;
+
+      for (unsigned int i = 0u; i < numChanged; ++i) {
+        auto const word = mXorWords[mChangedWords[i]];
+
+        unsigned int nibble = 0u;
+        for (unsigned int b = 0u; b < sizeof(unsigned int); ++b) {
+          auto const byte = static_cast<unsigned char>(word >> (b * 8u));
+          if (byte != 0u) {
+            nibble |= 1u << b;
+            *p++ = byte;
+          }
+        }
+
+        pNibbles[i / 2u] |= static_cast<unsigned char>(nibble << ((i % 2u) * 4u));
+      }
+
+      return p;
+    }
+
+    unsigned int mXorWords[RECORD_WORDS];
+    unsigned int mChangedWords[RECORD_WORDS];
+  };
+
+  class FrameDecoder : public ReferenceRecords
+  {
+  public:
+    // Decodes numVehicles records from payload.  Returns false if payload is malformed.
+    bool Decode(unsigned char const* pPayload, unsigned int payloadBytes, int numVehicles, ChunkType type, rF2VehicleTelemetry* pVehicles)
+    {
+      if (type == ChunkType::Keyframe)
+        Reset();
+
+      auto p = pPayload;
+      auto const pEnd = pPayload + payloadBytes;
+      for (int i = 0; i < numVehicles; ++i) {
+        p = DecodeRecord(p, pEnd, pVehicles[i]);
+        if (p == nullptr)
+          return false;
+      }
+
+      return p == pEnd;
+    }
+
+  private:
+    unsigned char const* DecodeRecord(unsigned char const* p, unsigned char const* pEnd, rF2VehicleTelemetry& vehicle)
+    {
+      int id = 0;
+      if (pEnd - p < static_cast<ptrdiff_t>(sizeof(id) + BITMAP_BYTES))
+        return nullptr;
+
+      memcpy(&id, p, sizeof(id));
+      p += sizeof(id);
+
+      auto const pBitmap = p;
+      p += BITMAP_BYTES;
+
+      unsigned int numChanged = 0u;
+      for (unsigned int w = 0u; w < RECORD_WORDS; ++w) {
+        if ((pBitmap[w / 8u] & (1u << (w % 8u))) != 0u)
+          ++numChanged;
+      }
+
+      auto const pNibbles = p;
+      if (pEnd - p < static_cast<ptrdiff_t>((numChanged + 1u) / 2u))
+        return nullptr;
+
+      p += (numChanged + 1u) / 2u;
+
+      auto const pReference = Reference(id);
+      unsigned int changed = 0u;
+      for (unsigned int w = 0u; w < RECORD_WORDS; ++w) {
+        if ((pBitmap[w / 8u] & (1u << (w % 8u))) == 0u)
+          continue;
+
+        auto const nibble = (pNibbles[changed / 2u] >> ((changed % 2u) * 4u)) & 0xfu;
+        ++changed;
+
+        unsigned int word = 0u;
+        for (unsigned int b = 0u; b < sizeof(unsigned int); ++b) {
+          if ((nibble & (1u << b)) != 0u) {
+            if (p == pEnd)
+              return nullptr;
+
+            word |= static_cast<unsigned int>(*p++) << (b * 8u);
+          }
+        }
+
+        pReference[w] ^= word;
+      }
+
+      memcpy(&vehicle, pReference, RECORD_BYTES);
+      return p;
+    }
+  };
+}
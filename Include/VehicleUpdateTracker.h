@@ -0,0 +1,114 @@
+/*
+Definition of VehicleUpdateTracker class.
+
+Author: The Iron Wolf (vleonavicius@hotmail.com)
+Website: thecrewchief.org
+
+Description:
+  VehicleUpdateTracker maintains rF2MappedVehicleBufferHeader change tracking fields for a buffer
+  with per vehicle array (telemetry, scoring).
+
+  While buffer is being filled, TrackVehicle is called for every vehicle slot written, before the
+  slot is overwritten.  New contents are compared to the contents of the same slot in the last
+  published buffer, which is what clients currently see.  Fields that change on every update
+  regardless of vehicle state (per frame time stamps) can be excluded from the comparison.
+
+  Publish writes the next generation, changed slots mask and per slot generations into the write
+  buffer, right before the flip.  Commit makes them current once the flip succeeded.  If the flip
+  failed (retry pending), changes keep accumulating and the next Publish rewrites the same
+  generation, so clients never see generations that were not published.
+
+  Slots not written during the update keep their previous generation.
+*/
+#pragma once
+
+#include <string.h>
+
+class VehicleUpdateTracker
+{
+public:
+  // Marks every slot written during the next update as changed, regardless of contents.
+  // Used after buffers are cleared, since last published contents are not what clients might have copied.
+  void Reset()
+  {
+    mAllChanged = true;
+    memset(mUpdatedMask, 0, sizeof(mUpdatedMask));
+  }
+
+  // Bytes [skipOffset, skipOffset + skipBytes) are not compared.
+  void TrackVehicle(int slot, void const* pNewContents, void const* pLastPublishedContents, size_t bytes,
+    size_t skipOffset = 0u, size_t skipBytes = 0u)
+  {
+    assert(slot >= 0 && slot < rF2MappedBufferHeader::MAX_MAPPED_VEHICLES);
+    assert(skipOffset + skipBytes <= bytes);
+
+    if (mAllChanged || ContentsDiffer(pNewContents, pLastPublishedContents, bytes, skipOffset, skipBytes))
+      mUpdatedMask[slot / 32] |= 1u << (slot % 32);
+  }
+
+  void Publish(rF2MappedVehicleBufferHeader* pBuf) const
+  {
+    auto const generation = mGeneration + 1u;
+
+    memcpy(pBuf->mVehicleUpdateGeneration, mSlotGeneration, sizeof(mSlotGeneration));
+    ForEachUpdatedSlot([pBuf, generation](int slot) { pBuf->mVehicleUpdateGeneration[slot] = generation; });
+
+    pBuf->mUpdateGeneration = generation;
+    memcpy(pBuf->mVehiclesUpdatedMask, mUpdatedMask, sizeof(mUpdatedMask));
+  }
+
+  // Call after the buffer written by Publish was flipped.
+  void Commit()
+  {
+    ++mGeneration;
+
+    auto const generation = mGeneration;
+    auto const pSlotGeneration = mSlotGeneration;
+    ForEachUpdatedSlot([pSlotGeneration, generation](int slot) { pSlotGeneration[slot] = generation; });
+
+    memset(mUpdatedMask, 0, sizeof(mUpdatedMask));
+    mAllChanged = false;
+  }
+
+private:
+  static bool ContentsDiffer(void const* pNewContents, void const* pLastPublishedContents, size_t bytes,
+    size_t skipOffset, size_t skipBytes)
+  {
+    auto const pNew = static_cast<unsigned char const*>(pNewContents);
+    auto const pLast = static_cast<unsigned char const*>(pLastPublishedContents);
+    auto const tailOffset = skipOffset + skipBytes;
+
+    return memcmp(pNew, pLast, skipOffset) != 0
+      || memcmp(pNew + tailOffset, pLast + tailOffset, bytes - tailOffset) != 0;
+  }
+
+  template <typename FuncT>
+  void ForEachUpdatedSlot(FuncT func) const
+  {
+    for (int word = 0; word < rF2MappedVehicleBufferHeader::VEHICLE_MASK_WORDS; ++word) {
+      auto mask = mUpdatedMask[word];
+      while (mask != 0u) {
+        func(word * 32 + LowestSetBit(mask));
+        mask &= mask - 1u;
+      }
+    }
+  }
+
+  static int LowestSetBit(unsigned int mask)
+  {
+    assert(mask != 0u);
+#ifdef _MSC_VER
+    unsigned long index = 0uL;
+    _BitScanForward(&index, mask);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctz(mask);
+#endif
+  }
+
+  // Generation keeps moving forward between sessions, so that clients holding per slot generations never miss changes.
+  unsigned int mGeneration = 0u;
+  unsigned int mUpdatedMask[rF2MappedVehicleBufferHeader::VEHICLE_MASK_WORDS] = {};
+  unsigned int mSlotGeneration[rF2MappedBufferHeader::MAX_MAPPED_VEHICLES] = {};
+  bool mAllChanged = true;
+};
@@ -139,6 +139,52 @@ enum class rF2CountLapFlag {
   CountLapAndTime = 2
 };
 
+// Mirror of TrackRulesCommandV01.
+enum class rF2TrackRulesCommand
+{
+  AddFromTrack = 0,             // crossed s/f line for first time after full-course yellow was called
+  AddFromPit,                   // exited pit during full-course yellow
+  AddFromUndq,                  // during a full-course yellow, the admin reversed a disqualification
+  RemoveToPit,                  // entered pit during full-course yellow
+  RemoveToDnf,                  // vehicle DNF'd during full-course yellow
+  RemoveToDq,                   // vehicle DQ'd during full-course yellow
+  RemoveToUnloaded,             // vehicle unloaded (possibly kicked out or banned) during full-course yellow
+  MoveToBack,                   // misbehavior during full-course yellow, resulting in the penalty of being moved to the back of their current line
+  LongestLine,                  // misbehavior during full-course yellow, resulting in the penalty of being moved to the back of the longest line
+  //------------------
+  Maximum                       // should be last
+};
+
+// Mirror of TrackRulesColumnV01.
+enum class rF2TrackRulesColumn
+{
+  LeftLane = 0,                 // left (inside)
+  MidLeftLane,                  // mid-left
+  MiddleLane,                   // middle
+  MidRightLane,                 // mid-right
+  RightLane,                    // right (outside)
+  //------------------
+  MaxLanes,                     // should be after the valid static lane choices
+  //------------------
+  Invalid = MaxLanes,           // currently invalid (hasn't crossed line or in pits/garage)
+  FreeChoice,                   // free choice (dynamically chosen by driver)
+  Pending,                      // depends on another participant's free choice (dynamically set after another driver chooses)
+  //------------------
+  Maximum                       // should be last
+};
+
+// Mirror of TrackRulesStageV01.
+enum class rF2TrackRulesStage
+{
+  FormationInit = 0,            // initialization of the formation lap
+  FormationUpdate,              // update of the formation lap
+  Normal,                       // normal (non-yellow) update
+  CautionInit,                  // initialization of a full-course yellow
+  CautionUpdate,                // update of a full-course yellow
+  //------------------
+  Maximum                       // should be last
+};
+
 // 0=disallowed, 1=criteria detected but not allowed quite yet, 2=allowed
 enum class rF2RearFlapLegalStatus {
   Disallowed = 0,
@@ -505,6 +551,224 @@ struct rF2PhysicsOptions
 static_assert(sizeof(rF2PhysicsOptions) == sizeof(PhysicsOptionsV01), "rF2PhysicsOptions and PhysicsOptionsV01 structures are out of sync");
 
 
+//////////////////////////////////////////////////////////////////////////////////////////
+// Identical to WeatherControlInfoV01, except where noted by MM_NEW/MM_NOT_USED comments.
+//////////////////////////////////////////////////////////////////////////////////////////
+struct rF2WeatherControlInfo
+{
+  // The current conditions are passed in with the API call. The following ET (Elapsed Time) value should typically be far
+  // enough in the future that it can be interpolated smoothly, and allow clouds time to roll in before rain starts. In
+  // other words you probably shouldn't have mCloudiness and mRaining suddenly change from 0.0 to 1.0 and expect that
+  // to happen in a few seconds without looking crazy.
+  double mET;                           // when you want this weather to take effect
+
+  // mRaining[1][1] is at the origin (2013.12.19 - and currently the only implemented node), while the others
+  // are spaced at <trackNodeSize> meters where <trackNodeSize> is the maximum absolute value of a track vertex
+  // coordinate (and is passed into the API call).
+  double mRaining[3][3];                // rain (0.0-1.0) at different nodes
+
+  double mCloudiness;                   // general cloudiness (0.0=clear to 1.0=dark), will be automatically overridden to help ensure clouds exist over rainy areas
+  double mAmbientTempK;                 // ambient temperature (Kelvin)
+  double mWindMaxSpeed;                 // maximum speed of wind (ground speed, but it affects how fast the clouds move, too)
+
+  bool mApplyCloudinessInstantly;       // preferably we roll the new clouds in, but you can instantly change them now
+  bool mUnused1;                        //
+  bool mUnused2;                        //
+  bool mUnused3;                        //
+
+  unsigned char mExpansion[508];        // future use (humidity, pressure, air density, etc.)
+};
+static_assert(sizeof(rF2WeatherControlInfo) == sizeof(WeatherControlInfoV01), "rF2WeatherControlInfo and WeatherControlInfoV01 structures are out of sync");
+
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// Identical to TrackRulesActionV01, except where noted by MM_NEW/MM_NOT_USED comments.
+//////////////////////////////////////////////////////////////////////////////////////////
+struct rF2TrackRulesAction
+{
+  // input only
+  rF2TrackRulesCommand mCommand;        // recommended action
+  long mID;                             // slot ID if applicable
+  double mET;                           // elapsed time that event occurred, if applicable
+};
+static_assert(sizeof(rF2TrackRulesAction) == sizeof(TrackRulesActionV01), "rF2TrackRulesAction and TrackRulesActionV01 structures are out of sync");
+
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// Identical to TrackRulesParticipantV01, except where noted by MM_NEW/MM_NOT_USED comments.
+//////////////////////////////////////////////////////////////////////////////////////////
+struct rF2TrackRulesParticipant
+{
+  // input only
+  long mID;                             // slot ID
+  short mFrozenOrder;                   // 0-based place when caution came out (not valid for formation laps)
+  short mPlace;                         // 1-based place (typically used for the initialization of the formation lap track order)
+  float mYellowSeverity;                // a rating of how much this vehicle is contributing to a yellow flag (the sum of all vehicles is compared to TrackRulesV01::mSafetyCarThreshold)
+  double mCurrentRelativeDistance;      // equal to ( ( ScoringInfoV01::mLapDist * this->mRelativeLaps ) + VehicleScoringInfoV01::mLapDist )
+
+  // input/output
+  long mRelativeLaps;                   // current formation/caution laps relative to safety car (should generally be zero except when safety car crosses s/f line); this can be decremented to implement 'wave around' or 'beneficiary rule' (a.k.a. 'lucky dog' or 'free pass')
+  rF2TrackRulesColumn mColumnAssignment;// which column (line/lane) that participant is supposed to be in
+  long mPositionAssignment;             // 0-based position within column (line/lane) that participant is supposed to be located at (-1 is invalid)
+  bool mAllowedToPit;                   // whether the rules allow this particular vehicle to enter pits right now
+  bool mUnused[3];                      //
+  double mGoalRelativeDistance;         // calculated based on where the leader is, and adjusted by the desired column spacing and the column/position assignments
+  char mMessage[96];                    // a message for this participant to explain what is going on (untranslated; it will get run through translator on client machines)
+
+  // future expansion
+  unsigned char mExpansion[192];
+};
+static_assert(sizeof(rF2TrackRulesParticipant) == sizeof(TrackRulesParticipantV01), "rF2TrackRulesParticipant and TrackRulesParticipantV01 structures are out of sync");
+
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// Identical to TrackRulesV01, except where noted by MM_NEW/MM_NOT_USED comments.
+//////////////////////////////////////////////////////////////////////////////////////////
+struct rF2TrackRules
+{
+  // input only
+  double mCurrentET;                    // current time
+  rF2TrackRulesStage mStage;            // current stage
+  rF2TrackRulesColumn mPoleColumn;      // column assignment where pole position seems to be located
+  long mNumActions;                     // number of recent actions
+  // MM_NOT_USED
+  //TrackRulesActionV01 *mAction;         // array of recent actions
+  // MM_NEW
+#ifdef _AMD64_
+  unsigned char pointer1[8];
+#else
+  unsigned char pointer1[4];
+#endif
+
+  long mNumParticipants;                // number of participants (vehicles)
+
+  bool mYellowFlagDetected;             // whether yellow flag was requested or sum of participant mYellowSeverity's exceeds mSafetyCarThreshold
+  bool mYellowFlagLapsWasOverridden;    // whether mYellowFlagLaps (below) is an admin request
+
+  bool mSafetyCarExists;                // whether safety car even exists
+  bool mSafetyCarActive;                // whether safety car is active
+  long mSafetyCarLaps;                  // number of laps
+  float mSafetyCarThreshold;            // the threshold at which a safety car is called out (compared to the sum of TrackRulesParticipantV01::mYellowSeverity for each vehicle)
+  double mSafetyCarLapDist;             // safety car lap distance
+  float mSafetyCarLapDistAtStart;       // where the safety car starts from
+
+  float mPitLaneStartDist;              // where the waypoint branch to the pits breaks off (this may not be perfectly accurate)
+  float mTeleportLapDist;               // the front of the teleport locations (a useful first guess as to where to throw the green flag)
+
+  // future input expansion
+  unsigned char mInputExpansion[256];
+
+  // input/output
+  signed char mYellowFlagState;         // see ScoringInfoV01 for values
+  short mYellowFlagLaps;                // suggested number of laps to run under yellow (may be passed in with admin command)
+
+  long mSafetyCarInstruction;           // 0=no change, 1=go active, 2=head for pits
+  float mSafetyCarSpeed;                // maximum speed at which to drive
+  float mSafetyCarMinimumSpacing;       // minimum spacing behind safety car (-1 to indicate no limit)
+  float mSafetyCarMaximumSpacing;       // maximum spacing behind safety car (-1 to indicate no limit)
+
+  float mMinimumColumnSpacing;          // minimum desired spacing between vehicles in a column (-1 to indicate indeterminate/unenforced)
+  float mMaximumColumnSpacing;          // maximum desired spacing between vehicles in a column (-1 to indicate indeterminate/unenforced)
+
+  float mMinimumSpeed;                  // minimum speed that anybody should be driving (-1 to indicate no limit)
+  float mMaximumSpeed;                  // maximum speed that anybody should be driving (-1 to indicate no limit)
+
+  char mMessage[96];                    // a message for everybody to explain what is going on (which will get run through translator on client machines)
+
+  // MM_NOT_USED
+  //TrackRulesParticipantV01 *mParticipant;         // array of partipants (vehicles)
+  // MM_NEW
+#ifdef _AMD64_
+  unsigned char pointer2[8];
+#else
+  unsigned char pointer2[4];
+#endif
+
+  // future input/output expansion
+  unsigned char mInputOutputExpansion[256];
+};
+static_assert(sizeof(rF2TrackRules) == sizeof(TrackRulesV01), "rF2TrackRules and TrackRulesV01 structures are out of sync");
+
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// Identical to MultiSessionParticipantV01, except where noted by MM_NEW/MM_NOT_USED comments.
+//////////////////////////////////////////////////////////////////////////////////////////
+struct rF2MultiSessionParticipant
+{
+  // input only
+  long mID;                             // slot ID (if loaded) or -1 (if currently disconnected)
+  char mDriverName[32];                 // driver name
+  char mVehicleName[64];                // vehicle name
+  unsigned char mUpgradePack[16];       // coded upgrades
+
+  float mBestPracticeTime;              // best practice time
+  long mQualParticipantIndex;           // once qualifying begins, this becomes valid and ranks participants according to practice time if possible
+  float mQualificationTime[4];          // best qualification time in up to 4 qual sessions
+  float mFinalRacePlace[4];             // final race place in up to 4 race sessions
+  float mFinalRaceTime[4];              // final race time in up to 4 race sessions
+
+  // input/output
+  bool mServerScored;                   // whether vehicle is allowed to participate in current session
+  long mGridPosition;                   // 1-based grid position for current race session (or upcoming race session if it is currently warmup), or -1 if currently disconnected
+  // long mPitIndex;
+  // long mGarageIndex;
+
+  // future expansion
+  unsigned char mExpansion[128];
+};
+static_assert(sizeof(rF2MultiSessionParticipant) == sizeof(MultiSessionParticipantV01), "rF2MultiSessionParticipant and MultiSessionParticipantV01 structures are out of sync");
+
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// Identical to MultiSessionRulesV01, except where noted by MM_NEW/MM_NOT_USED comments.
+//////////////////////////////////////////////////////////////////////////////////////////
+struct rF2MultiSessionRules
+{
+  // input only
+  long mSession;                        // current session (0=testday 1-4=practice 5-8=qual 9=warmup 10-13=race)
+  long mSpecialSlotID;                  // slot ID of someone who just joined, or -2 requesting to update qual order, or -1 (default/general)
+  char mTrackType[32];                  // track type from GDB
+  long mNumParticipants;                // number of participants (vehicles)
+
+  // input/output
+  // MM_NOT_USED
+  //MultiSessionParticipantV01 *mParticipant;       // array of partipants (vehicles)
+  // MM_NEW
+#ifdef _AMD64_
+  unsigned char pointer1[8];
+#else
+  unsigned char pointer1[4];
+#endif
+
+  long mNumQualSessions;                // number of qualifying sessions configured
+  long mNumRaceSessions;                // number of race sessions configured
+  long mMaxLaps;                        // maximum laps allowed in current session (LONG_MAX = unlimited) (note: cannot currently edit in *race* sessions)
+  long mMaxSeconds;                     // maximum time allowed in current session (LONG_MAX = unlimited) (note: cannot currently edit in *race* sessions)
+  char mName[32];                       // untranslated name override for session (please use mixed case here, it should get uppercased if necessary)
+
+  // future expansion
+  unsigned char mExpansion[256];
+};
+static_assert(sizeof(rF2MultiSessionRules) == sizeof(MultiSessionRulesV01), "rF2MultiSessionRules and MultiSessionRulesV01 structures are out of sync");
+
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// Identical to PitMenuV01, except where noted by MM_NEW/MM_NOT_USED comments.
+//////////////////////////////////////////////////////////////////////////////////////////
+struct rF2PitMenu
+{
+  long mCategoryIndex;                  // index of the current category
+  char mCategoryName[32];               // name of the current category (untranslated)
+
+  long mChoiceIndex;                    // index of the current choice (within the current category)
+  char mChoiceString[32];               // name of the current choice (may have some translated words)
+  long mNumChoices;                     // total number of choices (0 <= mChoiceIndex < mNumChoices)
+
+  unsigned char mExpansion[256];        // for future use
+};
+static_assert(sizeof(rF2PitMenu) == sizeof(PitMenuV01), "rF2PitMenu and PitMenuV01 structures are out of sync");
+
+
 ///////////////////////////////////////////
 // Mapped wrapper structures
 ///////////////////////////////////////////
@@ -515,6 +779,8 @@ struct rF2MappedBufferHeader
   static int const MAX_MAPPED_IDS = 256;
 
   bool mCurrentRead;               // True indicates buffer is safe to read under mutex.
+  unsigned int mSequence;          // Odd while buffer is being written to, incremented on every write and publish.
+                                   // Buffer copy is consistent if mSequence was even and did not change during the copy.
 };
 
 
@@ -525,7 +791,45 @@ struct rF2MappedBufferHeaderWithSize : public rF2MappedBufferHeader
 };
 
 
-struct rF2Telemetry : public rF2MappedBufferHeaderWithSize
+// Header of buffers with per vehicle arrays.  Lets clients copy only vehicles that changed (see VehicleUpdateTracker.h).
+// Clients that see every publish can use mVehiclesUpdatedMask.  Clients that might skip publishes should remember
+// mUpdateGeneration at which they copied each slot, and re-copy slots with greater mVehicleUpdateGeneration.
+// mUpdateGeneration going backwards means plugin restarted, and everything has to be re-copied.
+struct rF2MappedVehicleBufferHeader : public rF2MappedBufferHeaderWithSize
+{
+  static int const VEHICLE_MASK_WORDS = rF2MappedBufferHeader::MAX_MAPPED_VEHICLES / 32;
+
+  unsigned int mUpdateGeneration;     // Incremented on every publish of this buffer.
+  unsigned int mVehiclesUpdatedMask[rF2MappedVehicleBufferHeader::VEHICLE_MASK_WORDS];  // Bit (i % 32) of word (i / 32) is set if mVehicles[i]
+                                                                                         // changed since the previous publish.
+  unsigned int mVehicleUpdateGeneration[rF2MappedBufferHeader::MAX_MAPPED_VEHICLES];    // mUpdateGeneration of the publish in which mVehicles[i]
+                                                                                         // last changed.
+};
+
+
+// Control block at the beginning of the SyncMode::MultiBuffer mapped file.  Buffers follow it, buffer i
+// starts at mFirstBufferOffset + i * mBufferStride.
+//
+// Client read protocol:
+//   1. L = mLatest
+//   2. InterlockedIncrement(mReaders[L])
+//   3. If mLatest != L, InterlockedDecrement(mReaders[L]) and start over (writer might have picked L already).
+//   4. Copy buffer L, validating the copy with mSequence (see Seqlock.h).
+//   5. InterlockedDecrement(mReaders[L])
+struct rF2MultiBufferControl
+{
+  static int const MAX_BUFFERS = 8;
+
+  int mNumBuffers;                 // Number of buffers following this block.
+  int mBufferBytes;                // Size of a single buffer structure.
+  int mBufferStride;               // Distance between buffers (buffer size rounded up to the cache line).
+  int mFirstBufferOffset;          // Offset of the first buffer from the beginning of the file.
+  long mLatest;                    // Index of the most recently published buffer.
+  long mReaders[rF2MultiBufferControl::MAX_BUFFERS];  // Number of clients currently copying each buffer.
+};
+
+
+struct rF2Telemetry : public rF2MappedVehicleBufferHeader
 {
   long mNumVehicles;             // current number of vehicles
 
@@ -533,13 +837,113 @@ struct rF2Telemetry : public rF2MappedBufferHeaderWithSize
 };
 
 
-struct rF2Scoring : public rF2MappedBufferHeaderWithSize
+// Header of the telemetry history ring ($rFactor2SMMP_TelemetryHistory$).  Slots follow it, slot i starts at
+// mFirstSlotOffset + i * mSlotStride.  Frame number F is stored in slot F % mNumSlots.  See MappedHistoryRing.h.
+struct rF2TelemetryHistory
+{
+  unsigned int mSequence;          // Odd while header is being updated (see rF2MappedBufferHeader::mSequence).
+  int mNumSlots;                   // Number of frames kept.
+  int mSlotStride;                 // Distance between slots (slot size rounded up to the cache line).
+  int mFirstSlotOffset;            // Offset of the first slot from the beginning of the file.
+  unsigned long long mLastFrameNumber;  // Number of the most recently completed frame, 0 if none.
+};
+
+
+struct rF2TelemetryHistorySlot
+{
+  unsigned int mSequence;          // Odd while slot is being written to (see rF2MappedBufferHeader::mSequence).
+  unsigned long long mFrameNumber; // Monotonically increasing telemetry frame number.
+  double mElapsedTime;             // ET of the frame (mElapsedTime of the first vehicle update in the frame).
+  rF2Telemetry mTelemetry;         // Only mTelemetry.mBytesUpdatedHint bytes are written, rest is stale.
+};
+
+
+struct rF2Scoring : public rF2MappedVehicleBufferHeader
 {
   rF2ScoringInfo mScoringInfo;
   rF2VehicleScoring mVehicles[rF2MappedBufferHeader::MAX_MAPPED_VEHICLES];
 };
 
 
+// Track rules as passed to AccessTrackRules (formation and caution laps).  Game passes recent actions with each call,
+// plugin keeps them in mActions ring, so that clients polling slower than rules updates do not miss them: action
+// number N is in mActions[N % MAX_MAPPED_ACTIONS], mNumActionsAppended is the number of the next action.
+// mTrackRules.mNumActions is the number of actions passed with the latest call.  mParticipants are last, so
+// mBytesUpdatedHint covers mTrackRules.mNumParticipants entries.
+struct rF2RulesHeader : public rF2MappedBufferHeaderWithSize
+{
+  static int const MAX_MAPPED_ACTIONS = 64;
+
+  rF2TrackRules mTrackRules;
+  unsigned long long mNumActionsAppended;   // Total number of actions passed by the game since plugin started.
+  rF2TrackRulesAction mActions[rF2RulesHeader::MAX_MAPPED_ACTIONS];
+};
+
+
+struct rF2Rules : public rF2RulesHeader
+{
+  rF2TrackRulesParticipant mParticipants[rF2MappedBufferHeader::MAX_MAPPED_VEHICLES];
+};
+
+
+// Column-wise copy of the telemetry channels map and spotter type clients need, for all vehicles.  Written at the same
+// frame boundary as rF2Telemetry.  Entry i of each column belongs to rF2Telemetry::mVehicles[i].  Columns are 64 byte
+// aligned, so clients can vectorize over the whole field touching only a handful of cache lines.
+struct rF2Kinematics : public rF2MappedBufferHeader
+{
+  static int const CACHE_LINE_BYTES = 64;
+
+  int mNumVehicles;                // Number of valid entries in each column.
+  double mElapsedTime;             // ET of the telemetry frame.
+  unsigned char mAlignmentPadding[44];  // Aligns columns to the cache line.
+
+  int mID[rF2MappedBufferHeader::MAX_MAPPED_VEHICLES];                // slot ID (note that it can be re-used in multiplayer after someone leaves)
+  double mPosX[rF2MappedBufferHeader::MAX_MAPPED_VEHICLES];           // world position in meters
+  double mPosY[rF2MappedBufferHeader::MAX_MAPPED_VEHICLES];
+  double mPosZ[rF2MappedBufferHeader::MAX_MAPPED_VEHICLES];
+  double mLocalVelX[rF2MappedBufferHeader::MAX_MAPPED_VEHICLES];      // velocity (meters/sec) in local vehicle coordinates
+  double mLocalVelY[rF2MappedBufferHeader::MAX_MAPPED_VEHICLES];
+  double mLocalVelZ[rF2MappedBufferHeader::MAX_MAPPED_VEHICLES];
+  double mOri[9][rF2MappedBufferHeader::MAX_MAPPED_VEHICLES];         // orientation matrix, mOri[row * 3 + col] (rows as in rF2VehicleTelemetry::mOri, cols x, y, z)
+  double mLapDist[rF2MappedBufferHeader::MAX_MAPPED_VEHICLES];        // current distance around track, from the latest scoring update
+};
+
+static_assert(offsetof(rF2Kinematics, mID) % rF2Kinematics::CACHE_LINE_BYTES == 0, "rF2Kinematics::mAlignmentPadding is out of sync");
+static_assert(offsetof(rF2Kinematics, mPosX) % rF2Kinematics::CACHE_LINE_BYTES == 0, "rF2Kinematics columns are not cache line aligned");
+
+
+struct rF2LiteTelemetryField
+{
+  char mName[32];                  // rF2VehicleTelemetry member name, as listed in liteTelemetryFields.
+  int mOffset;                     // Offset of the field within the vehicle record.
+  int mSize;                       // Size of the field in bytes.
+};
+
+
+// Projection of rF2VehicleTelemetry onto members selected by liteTelemetryFields in rf2smmp.ini.  Vehicle records
+// are packed tightly (fields are not aligned), record i starts at mRecords + i * mRecordBytes.  Record layout is
+// described by mFields, and does not change while plugin is running.  Only mBytesUpdatedHint bytes are written.
+struct rF2LiteTelemetryHeader : public rF2MappedBufferHeaderWithSize
+{
+  static int const MAX_FIELDS = 64;
+  static int const MAX_RECORD_BYTES = 2048;
+
+  int mNumFields;                  // Number of valid entries in mFields.
+  int mRecordBytes;                // Size of a single vehicle record.
+  int mNumVehicles;                // Number of records written.
+  double mElapsedTime;             // ET of the telemetry frame.
+  rF2LiteTelemetryField mFields[rF2LiteTelemetryHeader::MAX_FIELDS];
+};
+
+
+// Only the header and MAX_MAPPED_VEHICLES records of mRecordBytes each are mapped, not the whole structure: mapping
+// size is offsetof(rF2LiteTelemetry, mRecords) + MAX_MAPPED_VEHICLES * mRecordBytes.
+struct rF2LiteTelemetry : public rF2LiteTelemetryHeader
+{
+  unsigned char mRecords[rF2MappedBufferHeader::MAX_MAPPED_VEHICLES * rF2LiteTelemetryHeader::MAX_RECORD_BYTES];
+};
+
+
 struct rF2TrackedDamage
 {
   double mMaxImpactMagnitude;                 // Max impact magnitude.  Tracked on every telemetry update, and reset on visit to pits or Session restart.
@@ -564,4 +968,319 @@ struct rF2Extended : public rF2MappedBufferHeader
   bool mSimulationThreadStarted;              // simulation thread started (reported via ThreadStarted/ThreadStopped calls).
 };
 
+
+// Indexes of rF2Stats::mBuffers.
+enum class rF2StatsBufferType {
+  Telemetry = 0,
+  Scoring = 1,
+  Extended = 2,
+  Kinematics = 3,
+  LiteTelemetry = 4,
+  Rules = 5
+};
+
+
+// Publication counters of a single buffer type (see rF2Stats).
+struct rF2BufferStats
+{
+  static int const HISTOGRAM_BUCKETS = 32;
+
+  unsigned long long mFlips;                  // Buffers published.
+  unsigned long long mForcedFlips;            // Flips that waited on the mutex instead of retrying later (telemetry force flips,
+                                              // every scoring and extended flip).  Mutex sync mode only.
+  unsigned long long mRetries;                // Flips postponed (or frames skipped, for buffers that never wait) because mutex was held.
+  unsigned long long mOverwrites;             // Flips that went ahead after mutex wait timed out or failed, or, in MultiBuffer mode,
+                                              // overwrote a buffer held by a reader.  Clients might have seen a torn buffer.
+  unsigned long long mMutexWaits;             // Mutex acquisition attempts timed in mMutexWaitHistogram (Mutex sync mode only).
+  unsigned long long mMutexWaitHistogram[rF2BufferStats::HISTOGRAM_BUCKETS];  // Bucket i counts attempts that took [2^i, 2^(i+1)) ns.
+                                                                             // Bucket 0 also counts < 1ns, last bucket everything longer.
+};
+
+
+// Plugin health statistics ($rFactor2SMMP_Stats$).  Single buffer, updated in place after every telemetry frame and
+// scoring update, so there's no mCurrentRead: copy is consistent if mSequence was even and did not change during the copy
+// (see Seqlock.h).  Counters start at 0 on plugin startup and only grow.
+struct rF2Stats
+{
+  static int const NUM_BUFFER_TYPES = 6;
+
+  unsigned int mSequence;                     // Odd while buffer is being written to (see rF2MappedBufferHeader::mSequence).
+  unsigned char mAlignmentPadding1[4];        // Keeps 8 byte fields below naturally aligned despite pack(4).
+  unsigned long long mPublishCount;           // Incremented on every update of this buffer.  Stops moving if game or plugin hangs.
+
+  rF2BufferStats mBuffers[rF2Stats::NUM_BUFFER_TYPES];  // Indexed by rF2StatsBufferType.
+
+  unsigned long long mTelemetryFrames;        // Complete telemetry frames assembled.
+  unsigned long long mSkippedDuplicateETUpdates;  // Telemetry updates skipped because ET did not change (game sends most frames twice).
+  unsigned long long mFrameAssemblyHistogram[rF2BufferStats::HISTOGRAM_BUCKETS];  // Time from the first vehicle update of a telemetry frame
+                                                                                 // until it is published, bucket i counts [2^i, 2^(i+1)) ns.
+  double mLastFrameAssemblyMicroseconds;      // Assembly time of the last telemetry frame.
+  double mMaxFrameAssemblyMicroseconds;       // Longest assembly time so far.
+  int mLastVehiclesPerFrame;                  // Number of vehicles in the last telemetry frame.
+  unsigned char mAlignmentPadding2[4];        //
+  unsigned long long mVehiclesPerFrameHistogram[rF2MappedBufferHeader::MAX_MAPPED_VEHICLES + 1];  // Entry n counts telemetry frames with n vehicles.
+};
+
+static_assert(sizeof(rF2BufferStats) % 8 == 0, "rF2BufferStats breaks rF2Stats alignment");
+static_assert(offsetof(rF2Stats, mPublishCount) % 8 == 0, "rF2Stats::mAlignmentPadding1 is out of sync");
+static_assert(offsetof(rF2Stats, mVehiclesPerFrameHistogram) % 8 == 0, "rF2Stats::mAlignmentPadding2 is out of sync");
+
+
+// Bits of rF2ReaderSlot::mBufferMask.
+enum class rF2ReaderBuffer : unsigned int {
+  Telemetry = 1u << 0,
+  Scoring = 1u << 1,
+  Extended = 1u << 2,
+  Kinematics = 1u << 3,
+  LiteTelemetry = 1u << 4,
+  TelemetryHistory = 1u << 5,
+  Rules = 1u << 6,
+  PlayerTelemetry = 1u << 7,
+  All = 0xFFFFFFFFu
+};
+
+
+// Registered client of the plugin (see rF2ReaderRegistry).  Written by the reader only, except that plugin frees
+// slots of readers whose heartbeat stopped.  Slot takes a cache line, so readers do not share lines.
+struct rF2ReaderSlot
+{
+  int mOwner;                      // Reader's process id while slot is claimed, 0 if slot is free.  4 bytes on every platform.
+  unsigned int mBufferMask;        // rF2ReaderBuffer bits of the buffers reader consumes.
+  unsigned int mHeartbeat;         // Incremented by the reader at least every HEARTBEAT_TIMEOUT_MS / 2.
+  char mName[16];                  // Optional zero terminated reader name, for debug output.
+  unsigned char mPad[36];
+};
+
+static_assert(sizeof(rF2ReaderSlot) == 64, "rF2ReaderSlot is not a cache line");
+
+
+// Registry of clients ($rFactor2SMMP_ReaderRegistry$), mapped only if readerRegistry=1 is set in the configuration
+// file.  In that mode plugin stops copying and flipping buffers nobody reads, and resumes with the next update once
+// a reader of the buffer registers.  Clients that do not register will see stale buffers in this mode.
+//
+// Reader protocol:
+//   1. Claim a free slot: InterlockedCompareExchange(&mSlots[i].mOwner, <process id>, 0) == 0
+//   2. Set mName, mBufferMask, then increment mHeartbeat.
+//   3. Keep incrementing mHeartbeat while running.  If mOwner no longer holds reader's process id, slot was freed
+//      by the plugin because heartbeat stopped for longer than HEARTBEAT_TIMEOUT_MS: claim a slot again.
+//   4. On exit, set mBufferMask to 0 and mOwner to 0.
+struct rF2ReaderRegistry
+{
+  static int const MAX_READERS = 16;
+  static unsigned int const HEARTBEAT_TIMEOUT_MS = 2000u;
+
+  unsigned int mLiveBufferMask;    // Set by plugin: rF2ReaderBuffer bits of buffers that currently have a live reader.
+  unsigned int mLiveReaders;       // Set by plugin: number of live readers.
+  unsigned char mPad[56];
+
+  rF2ReaderSlot mSlots[rF2ReaderRegistry::MAX_READERS];
+};
+
+
+// Discrete race events detected by the plugin (see rF2RaceEvent).
+enum class rF2RaceEventType {
+  SessionStarted = 0,          // StartSession callback.
+  SessionEnded = 1,            // EndSession callback.
+  RealtimeEntered = 2,         // EnterRealtime callback.
+  RealtimeExited = 3,          // ExitRealtime callback.
+  GamePhaseChanged = 4,        // mOldValue/mNewValue: rF2ScoringInfo::mGamePhase.
+  YellowFlagStateChanged = 5,  // mOldValue/mNewValue: rF2ScoringInfo::mYellowFlagState.
+  VehicleJoined = 6,           // Vehicle appeared in scoring.  mNewValue: mPlace.
+  VehicleLeft = 7,             // Vehicle no longer in scoring.  mOldValue: last mPlace.
+  LapCompleted = 8,            // mOldValue/mNewValue: mTotalLaps, mValue: mLastLapTime.
+  PitEntered = 9,              // mInPits became true.
+  PitExited = 10,              // mInPits became false.
+  PitStateChanged = 11,        // mOldValue/mNewValue: mPitState (see rF2PitState).
+  PlaceChanged = 12,           // mOldValue/mNewValue: mPlace.
+  FinishStatusChanged = 13,    // mOldValue/mNewValue: mFinishStatus (see rF2FinishStatus).
+  ControlChanged = 14,         // mOldValue/mNewValue: mControl (see rF2Control).
+  PenaltiesChanged = 15,       // mOldValue/mNewValue: mNumPenalties.
+  Impact = 16                  // New impact reported in telemetry.  mValue: mLastImpactMagnitude, mElapsedTime: mLastImpactET.
+};
+
+
+// Header of the race event ring ($rFactor2SMMP_RaceEvents$).  Same layout and protocol as rF2TelemetryHistory (see
+// MappedHistoryRing.h): event number N is stored in slot N % mNumSlots, and clients drain events numbered after the
+// last one they consumed up to mLastFrameNumber, validating each slot with its mSequence.
+struct rF2RaceEvents
+{
+  unsigned int mSequence;          // Odd while header is being updated (see rF2MappedBufferHeader::mSequence).
+  int mNumSlots;                   // Number of events kept.
+  int mSlotStride;                 // Distance between slots.
+  int mFirstSlotOffset;            // Offset of the first slot from the beginning of the file.
+  unsigned long long mLastFrameNumber;  // Number of the most recent event, 0 if none.  Keeps growing across sessions.
+};
+
+
+struct rF2RaceEvent
+{
+  unsigned int mSequence;          // Odd while slot is being written to (see rF2MappedBufferHeader::mSequence).
+  unsigned long long mFrameNumber; // Monotonically increasing event number.
+  double mElapsedTime;             // ET at which event was detected.
+  rF2RaceEventType mType;
+  long mID;                        // Vehicle slot ID, -1 for session wide events.
+  long mOldValue;                  // Value before the transition (see rF2RaceEventType).
+  long mNewValue;                  // Value after the transition.
+  double mValue;                   // Additional value (see rF2RaceEventType).
+  unsigned char mPad[20];
+};
+
+
+struct rF2ResultsStreamChunk
+{
+  unsigned long long mOffset;      // Stream offset of the first byte of the chunk (text byte at offset O is mText[O % RING_BYTES]).
+  unsigned int mBytes;             // Number of bytes stored.
+  unsigned int mBytesDropped;      // Bytes of the update that did not fit into the ring (tail of the update).
+  double mElapsedTime;             // ET of the scoring update the chunk came with.
+};
+
+
+// ScoringInfoV01::mResultsStream text captured from scoring updates ($rFactor2SMMP_ResultsStream$).  Each non empty
+// update is appended as a chunk: text goes into the mText byte ring and is described by mChunks[N % MAX_CHUNKS],
+// where N is the chunk number.  Stream offsets and chunk numbers keep growing, so text older than
+// mWriteOffset - RING_BYTES (and chunks older than mNumChunks - MAX_CHUNKS) are gone.
+//
+// Whole structure is protected by mSequence (see Seqlock.h): plugin keeps it odd while appending, clients copy the
+// chunks and text after their last seen chunk number, and retry if mSequence changed.  Plugin never waits.
+struct rF2ResultsStream
+{
+  static int const RING_BYTES = 256 * 1024;
+  static int const MAX_CHUNKS = 512;
+
+  unsigned int mSequence;          // Odd while being appended to (see rF2MappedBufferHeader::mSequence).
+  int mRingBytes;                  // RING_BYTES
+  int mMaxChunks;                  // MAX_CHUNKS
+  unsigned long long mWriteOffset; // Total bytes appended, stream offset of the next byte.
+  unsigned long long mNumChunks;   // Total chunks appended, chunk number of the next chunk.
+
+  rF2ResultsStreamChunk mChunks[rF2ResultsStream::MAX_CHUNKS];
+  char mText[rF2ResultsStream::RING_BYTES];
+};
+
+
+// Multi-session rules as last passed to AccessMultiSessionRules ($rFactor2SMMP_MultiRules$).  Single buffer, rewritten
+// only when rules or participants change and protected by mSequence (see Seqlock.h).  Clients can cache it and copy
+// it again only when mGeneration changes.  mMultiSessionRules.pointer1 is always 0.
+struct rF2MultiRules
+{
+  unsigned int mSequence;          // Odd while buffer is being written to (see rF2MappedBufferHeader::mSequence).
+  unsigned int mGeneration;        // Incremented each time rules change, 0 until AccessMultiSessionRules is first called.
+  rF2MultiSessionRules mMultiSessionRules;
+  rF2MultiSessionParticipant mParticipants[rF2MappedBufferHeader::MAX_MAPPED_VEHICLES];  // First mMultiSessionRules.mNumParticipants
+                                                                                          // entries are valid.
+};
+
+
+// Pit menu state as last passed to AccessPitMenu ($rFactor2SMMP_PitInfo$).  Same update and read rules as rF2MultiRules.
+struct rF2PitInfo
+{
+  unsigned int mSequence;          // Odd while buffer is being written to (see rF2MappedBufferHeader::mSequence).
+  unsigned int mGeneration;        // Incremented each time pit menu state changes, 0 until AccessPitMenu is first called.
+  rF2PitMenu mPitMenu;
+};
+
+
+// Weather as last passed to AccessWeather ($rFactor2SMMP_Weather$).  Single buffer, rewritten only when weather
+// changes and protected by mSequence (see Seqlock.h).  Clients can cache it and copy it again only when mGeneration
+// changes.
+struct rF2Weather
+{
+  unsigned int mSequence;          // Odd while buffer is being written to (see rF2MappedBufferHeader::mSequence).
+  unsigned int mGeneration;        // Incremented each time weather changes, 0 until AccessWeather is first called.
+  double mTrackNodeSize;           // Distance between mRaining nodes (see rF2WeatherControlInfo::mRaining).
+  rF2WeatherControlInfo mWeatherInfo;  // Changes to mET alone do not count, so mET is as of the latest change.
+};
+
+
+// Camera state as last passed to UpdateGraphics ($rFactor2SMMP_Graphics$).  Single buffer, rewritten on every graphics
+// update from the render thread and protected by mSequence (see Seqlock.h).  Only the camera part of GraphicsInfoV02 is
+// kept (no HWND, ambient light or expansion), so whole buffer spans two cache lines.
+struct rF2Graphics
+{
+  static int const CACHE_LINE_BYTES = 64;
+
+  unsigned int mSequence;          // Odd while buffer is being written to (see rF2MappedBufferHeader::mSequence).
+  unsigned int mUpdateNumber;      // Incremented on every graphics update, 0 until UpdateGraphics is first called.
+  int mID;                         // slot ID being viewed (-1 if invalid)
+  int mCameraType;                 // see GraphicsInfoV02 comments for possible values
+  rF2Vec3 mCamPos;                 // camera position
+  rF2Vec3 mCamOri[3];              // rows of orientation matrix (use TelemQuat conversions if desired), also converts local
+
+  unsigned char mExpansion[16];    // Pads buffer to two cache lines.
+};
+static_assert(sizeof(rF2Graphics) == 2 * rF2Graphics::CACHE_LINE_BYTES, "rF2Graphics has to span exactly two cache lines");
+
+
+// Telemetry of the player vehicle ($rFactor2SMMP_PlayerTelemetry$).  Single buffer, written by UpdateTelemetry as soon
+// as player vehicle telemetry arrives, without waiting for the rest of the frame, and protected by mSequence (see
+// Seqlock.h).  Player vehicle is the one with mIsPlayer set in the latest scoring update, so nothing is published
+// before the first scoring update.
+struct rF2PlayerTelemetry
+{
+  unsigned int mSequence;          // Odd while buffer is being written to (see rF2MappedBufferHeader::mSequence).
+  unsigned int mUpdateNumber;      // Incremented on every publish, 0 until player telemetry is first published.
+  double mPublishMicroseconds;     // Plugin clock at publish time (QueryPerformanceCounter based on Windows).
+  rF2VehicleTelemetry mVehicle;
+};
+
+
+struct rF2ForceFeedbackSample
+{
+  double mForceValue;              // Force value as passed to ForceFeedback.
+  double mMicroseconds;            // Plugin clock at the call (same clock as rF2PlayerTelemetry::mPublishMicroseconds).
+};
+
+
+// Force feedback values passed to ForceFeedback at physics rate ($rFactor2SMMP_ForceFeedback$).  Sample N is in
+// mSamples[N % MAX_SAMPLES], sample numbers keep growing, so samples older than mNumSamples - MAX_SAMPLES are gone.
+//
+// Same protocol as rF2ResultsStream: whole structure is protected by mSequence (see Seqlock.h), clients copy samples
+// after their last seen sample number up to mNumSamples, and retry if mSequence changed.  Plugin never waits.
+struct rF2ForceFeedback
+{
+  static int const MAX_SAMPLES = 4096;
+
+  unsigned int mSequence;          // Odd while being appended to (see rF2MappedBufferHeader::mSequence).
+  int mMaxSamples;                 // MAX_SAMPLES
+  unsigned long long mNumSamples;  // Total number of samples appended since plugin started (next sample number).
+  rF2ForceFeedbackSample mSamples[rF2ForceFeedback::MAX_SAMPLES];
+};
+
+
+// Control value posted by an external process (see rF2ControlInput).
+struct rF2ControlCommand
+{
+  static int const CONTROL_NAME_CHARS = 64;
+
+  long mTicket;                    // Slot protocol counter (see rF2ControlInput).
+  char mControlName[rF2ControlCommand::CONTROL_NAME_CHARS];  // Control name as game passes it to CheckHWControl (case insensitive).
+  double mValue;                   // Value game gets for the control.
+  long mFrames;                    // > 0: value is reported that many times (game asks once a frame), then control is released.
+                                   // 0: value is reported until the next command for the control.
+                                   // < 0: release the control (mValue is not used).
+};
+
+
+// Queue of control commands ($rFactor2SMMP_ControlInput$), mapped only if controlInput=1 is set in the configuration
+// file.  External processes (button boxes, pit strategy tools) post control values here instead of injecting
+// keystrokes, and plugin reports them to the game from CheckHWControl.  Plugin drains the queue once a frame.
+//
+// Command at position P is in mCommands[(unsigned long)P % MAX_COMMANDS].  Slot is free for position P when its
+// mTicket == P, and holds a posted command when mTicket == P + 1.
+// Producer protocol (any number of producers):
+//   1. P = mEnqueuePosition, slot = mCommands[P % MAX_COMMANDS].
+//   2. If slot.mTicket == P, claim P: InterlockedCompareExchange(&mEnqueuePosition, P + 1, P) == P, otherwise go to 1.
+//      If slot.mTicket - P < 0, queue is full (plugin is not draining, e.g. game is not running), retry later.
+//      If slot.mTicket - P > 0, another producer claimed P, go to 1.
+//   3. Fill mControlName, mValue and mFrames, then publish: InterlockedExchange(&slot.mTicket, P + 1).
+// Do not stall between steps 2 and 3: plugin does not skip claimed slots.
+struct rF2ControlInput
+{
+  static int const MAX_COMMANDS = 64;
+
+  long mEnqueuePosition;           // Position of the next command.  Only producers change it.
+  long mMaxCommands;               // MAX_COMMANDS
+  rF2ControlCommand mCommands[rF2ControlInput::MAX_COMMANDS];
+};
+
 #pragma pack(pop)
@@ -9,7 +9,7 @@ Website: thecrewchief.org
 #include <time.h>
 #include <assert.h>
 #include <stdio.h>                              // for sample output
-#include <share.h>                              // _fsopen share flags
+#include "Platform.h"                           // OS services, _fsopen share flags
 
 #pragma warning(push)
 #pragma warning(disable : 4263)   // UpdateGraphics virtual incorrect signature
@@ -27,20 +27,17 @@ Website: thecrewchief.org
 
 // Each component can be in [0:99] range.
 #define PLUGIN_VERSION_MAJOR "2.0"
-#define PLUGIN_VERSION_MINOR "0.0"
+#define PLUGIN_VERSION_MINOR "2.0"
 #define PLUGIN_NAME_AND_VERSION "rFactor 2 Shared Memory Map Plugin - v" PLUGIN_VERSION_MAJOR
 #define SHARED_MEMORY_VERSION PLUGIN_VERSION_MAJOR "." PLUGIN_VERSION_MINOR
 
-// This is hell on earth, but I do not want to add additional dependencies needed for STL right now.
-// Be super careful with those, there's no type safety or checks of any kind (1979 style).
-#define DEBUG_MSG(lvl, msg) SharedMemoryPlugin::WriteDebugMsg(lvl, "%s(%d) : %s\n", __FUNCTION__, __LINE__, msg)
-#define DEBUG_MSG2(lvl, msg, msg2) SharedMemoryPlugin::WriteDebugMsg(lvl, "%s(%d) : %s %s\n", __FUNCTION__, __LINE__, msg, msg2)
-#define DEBUG_INT2(lvl, msg, intValue) SharedMemoryPlugin::WriteDebugMsg(lvl, "%s(%d) : %s %d\n", __FUNCTION__, __LINE__, msg, intValue)
-#define DEBUG_FLOAT2(lvl, msg, floatValue) SharedMemoryPlugin::WriteDebugMsg(lvl, "%s(%d) : %s %f\n", __FUNCTION__, __LINE__, msg, floatValue)
-#define DEBUG_MSG3(lvl, msg, msg2, msg3) SharedMemoryPlugin::WriteDebugMsg(lvl, "%s(%d) : %s %s %s\n", __FUNCTION__, __LINE__, msg, msg2, msg3)
-
-#include "rF2State.h"
-#include "MappedDoubleBuffer.h"
+// Messages are queued as binary records and formatted off the calling thread (see DebugLogger.h).  Before Startup
+// and after Shutdown they are written synchronously.
+#define DEBUG_MSG(lvl, msg) SharedMemoryPlugin::WriteDebugRecord(lvl, DebugLogger::Format::Msg, __FUNCTION__, __LINE__, msg, nullptr, nullptr, 0, 0.0)
+#define DEBUG_MSG2(lvl, msg, msg2) SharedMemoryPlugin::WriteDebugRecord(lvl, DebugLogger::Format::Msg2, __FUNCTION__, __LINE__, msg, msg2, nullptr, 0, 0.0)
+#define DEBUG_INT2(lvl, msg, intValue) SharedMemoryPlugin::WriteDebugRecord(lvl, DebugLogger::Format::Int2, __FUNCTION__, __LINE__, msg, nullptr, nullptr, intValue, 0.0)
+#define DEBUG_FLOAT2(lvl, msg, floatValue) SharedMemoryPlugin::WriteDebugRecord(lvl, DebugLogger::Format::Float2, __FUNCTION__, __LINE__, msg, nullptr, nullptr, 0, floatValue)
+#define DEBUG_MSG3(lvl, msg, msg2, msg3) SharedMemoryPlugin::WriteDebugRecord(lvl, DebugLogger::Format::Msg3, __FUNCTION__, __LINE__, msg, msg2, msg3, 0, 0.0)
 
 enum DebugLevel
 {
@@ -53,6 +50,42 @@ enum DebugLevel
   Verbose = 6            // All
 };
 
+enum class SyncMode
+{
+  Mutex = 0,             // Double buffering with optional weak synchronization on global mutexes.
+  Seqlock = 1,           // Double buffering without mutexes.  Clients validate copies using mSequence counters.
+  MultiBuffer = 2        // N buffers in a single file, writer never waits or retries.  See rF2MultiBufferControl.
+};
+
+class SharedMemoryPlugin;
+
+// Mapped buffer templates refer to the plugin's configuration and debug output.  They do so via this type, so that
+// the reference is dependent and resolved on instantiation, after SharedMemoryPlugin is defined (two-phase lookup).
+template <typename T>
+struct DependentPlugin
+{
+  typedef SharedMemoryPlugin Type;
+};
+
+#include "rF2State.h"
+#include "SpscRing.h"
+#include "MpscRing.h"
+#include "DebugLogger.h"
+#include "MappedDoubleBuffer.h"
+#include "MappedHistoryRing.h"
+#include "RaceEventTracker.h"
+#include "MappedTextRing.h"
+#include "MappedSampleRing.h"
+#include "MappedControlInput.h"
+#include "MappedSeqlockBuffer.h"
+#include "MappedReaderRegistry.h"
+#include "VehicleUpdateTracker.h"
+#include "TelemetryProjection.h"
+#include "TelemetryRecording.h"
+#include "TelemetryRecorder.h"
+#include "CallbackPublisher.h"
+#include "CallbackJournal.h"
+
 // This is used for the app to use the plugin for its intended purpose
 class SharedMemoryPlugin : public InternalsPluginV07  // REMINDER: exported function GetPluginVersion() should return 1 if you are deriving from this InternalsPluginV01, 2 for InternalsPluginV02, etc.
 {
@@ -60,14 +93,51 @@ public:
   static char const* const MM_TELEMETRY_FILE_NAME1;
   static char const* const MM_TELEMETRY_FILE_NAME2;
   static char const* const MM_TELEMETRY_FILE_ACCESS_MUTEX;
+  static char const* const MM_TELEMETRY_MULTI_BUFFER_FILE_NAME;
+  static char const* const MM_TELEMETRY_FLIP_EVENT_NAME;
+  static char const* const MM_TELEMETRY_HISTORY_FILE_NAME;
 
   static char const* const MM_SCORING_FILE_NAME1;
   static char const* const MM_SCORING_FILE_NAME2;
   static char const* const MM_SCORING_FILE_ACCESS_MUTEX;
+  static char const* const MM_SCORING_MULTI_BUFFER_FILE_NAME;
+  static char const* const MM_SCORING_FLIP_EVENT_NAME;
 
   static char const* const MM_EXTENDED_FILE_NAME1;
   static char const* const MM_EXTENDED_FILE_NAME2;
   static char const* const MM_EXTENDED_FILE_ACCESS_MUTEX;
+  static char const* const MM_EXTENDED_MULTI_BUFFER_FILE_NAME;
+  static char const* const MM_EXTENDED_FLIP_EVENT_NAME;
+
+  static char const* const MM_KINEMATICS_FILE_NAME1;
+  static char const* const MM_KINEMATICS_FILE_NAME2;
+  static char const* const MM_KINEMATICS_FILE_ACCESS_MUTEX;
+  static char const* const MM_KINEMATICS_MULTI_BUFFER_FILE_NAME;
+  static char const* const MM_KINEMATICS_FLIP_EVENT_NAME;
+
+  static char const* const MM_LITE_TELEMETRY_FILE_NAME1;
+  static char const* const MM_LITE_TELEMETRY_FILE_NAME2;
+  static char const* const MM_LITE_TELEMETRY_FILE_ACCESS_MUTEX;
+  static char const* const MM_LITE_TELEMETRY_MULTI_BUFFER_FILE_NAME;
+  static char const* const MM_LITE_TELEMETRY_FLIP_EVENT_NAME;
+
+  static char const* const MM_RULES_FILE_NAME1;
+  static char const* const MM_RULES_FILE_NAME2;
+  static char const* const MM_RULES_FILE_ACCESS_MUTEX;
+  static char const* const MM_RULES_MULTI_BUFFER_FILE_NAME;
+  static char const* const MM_RULES_FLIP_EVENT_NAME;
+
+  static char const* const MM_STATS_FILE_NAME;
+  static char const* const MM_READER_REGISTRY_FILE_NAME;
+  static char const* const MM_RACE_EVENTS_FILE_NAME;
+  static char const* const MM_RESULTS_STREAM_FILE_NAME;
+  static char const* const MM_WEATHER_FILE_NAME;
+  static char const* const MM_MULTI_RULES_FILE_NAME;
+  static char const* const MM_PIT_INFO_FILE_NAME;
+  static char const* const MM_GRAPHICS_FILE_NAME;
+  static char const* const MM_PLAYER_TELEMETRY_FILE_NAME;
+  static char const* const MM_FORCE_FEEDBACK_FILE_NAME;
+  static char const* const MM_CONTROL_INPUT_FILE_NAME;
 
   static char const* const CONFIG_FILE_REL_PATH;
 
@@ -77,16 +147,38 @@ public:
   
   static int const MAX_ASYNC_RETRIES = 3;
   static int const MAX_PARTICIPANT_SLOTS = 256;
+  static int const MAX_STATS_READ_ATTEMPTS = 4;
   static int const BUFFER_IO_BYTES = 2048;
   static int const DEBUG_IO_FLUSH_PERIOD_SECS = 10;
+  static int const LITE_TELEMETRY_FIELDS_CHARS = 1024;
 
   static DebugLevel msDebugOutputLevel;
+  static SyncMode msSyncMode;
+  static int msMultiBufferCount;
+  static int msTelemetryHistoryFrames;
+  static char msLiteTelemetryFields[LITE_TELEMETRY_FIELDS_CHARS];
+  static bool msTelemetryRecorder;
+  static bool msCallbackJournal;
+  static bool msFlipNotification;
+  static bool msReaderRegistry;
+  static bool msRaceEvents;
+  static bool msResultsStream;
+  static bool msWeather;
+  static bool msRules;
+  static bool msMultiSessionRules;
+  static bool msPitMenu;
+  static bool msGraphics;
+  static bool msPlayerTelemetry;
+  static bool msForceFeedback;
+  static bool msControlInput;
+  static bool msPublisherThread;
   static bool msDebugISIInternals;
   static int msMillisRefresh;
   static DWORD msMillisMutexWait;
 
   // Ouptut files:
   static FILE* msDebugFile;
+  static DebugLogger msDebugLogger;
   static FILE* msIsiTelemetryFile;
   static FILE* msIsiScoringFile;
 
@@ -94,6 +186,21 @@ public:
 
   // Debug output helpers
   static void WriteDebugMsg(DebugLevel lvl, char const* const format, ...);
+  static void WriteDebugRecordSync(DebugLevel lvl, DebugLogger::Format format, char const* function, int line,
+    char const* msg, char const* msg2, char const* msg3, int intValue, double floatValue);
+
+  // DEBUG_* macros.  Level check is inlined, so filtered out messages cost a compare.
+  static void WriteDebugRecord(DebugLevel lvl, DebugLogger::Format format, char const* function, int line,
+    char const* msg, char const* msg2, char const* msg3, int intValue, double floatValue)
+  {
+    if (lvl > SharedMemoryPlugin::msDebugOutputLevel)
+      return;
+
+    if (!SharedMemoryPlugin::msDebugLogger.Log(format, function, line, msg, msg2, msg3, intValue, floatValue))
+      WriteDebugRecordSync(lvl, format, function, line, msg, msg2, msg3, intValue, floatValue);
+  }
+
+  static void OpenDebugFile();
   static void WriteToAllExampleOutputFiles(char const* const openStr, char const* const msg);
   static void WriteTelemetryInternals(TelemInfoV01 const& info);
   static void WriteScoringInternals(ScoringInfoV01 const& info);
@@ -107,7 +214,7 @@ private:
     {
       // There's a bug somewhere (in my head?), initializing mExtended = {} does not make it all 0.
       // Maybe there's a race between simulation and multimedia threads, but I can't debug due to game crashing on attach.
-      // Traces suggest no race however.
+      // Traces suggest no race however.  With publisherThread=1, mExtended is only written from the publisher thread.
       memset(&mExtended, 0, sizeof(rF2Extended));
 
       strcpy_s(mExtended.mVersion, SHARED_MEMORY_VERSION);
@@ -118,7 +225,8 @@ private:
       assert(!mExtended.mSimulationThreadStarted);
     }
 
-    void ProcessTelemetryUpdate(TelemInfoV01 const& info)
+    // Returns true if info carries a new impact.
+    bool ProcessTelemetryUpdate(TelemInfoV01 const& info)
     {
       auto const id = min(info.mID, rF2MappedBufferHeader::MAX_MAPPED_IDS - 1);
 
@@ -132,7 +240,10 @@ private:
         td.mAccumulatedImpactMagnitude += info.mLastImpactMagnitude;
 
         dti.mLastImpactProcessedET = info.mLastImpactET;
+        return true;
       }
+
+      return false;
     }
 
     void ProcessScoringUpdate(ScoringInfoV01 const& info)
@@ -196,6 +307,10 @@ public:
   long WantsTelemetryUpdates() override { return 2L; } // whether we want telemetry updates (0=no 1=player-only 2=all vehicles)
   void UpdateTelemetry(TelemInfoV01 const& info) override;
 
+  // GRAPHICS OUTPUT
+  bool WantsGraphicsUpdates() override { return SharedMemoryPlugin::msGraphics; } // whether we want graphics updates
+  void UpdateGraphics(GraphicsInfoV02 const& info) override; // update plugin with extended graphics info
+
   // SCORING OUTPUT
   bool WantsScoringUpdates() override { return true; }
   void UpdateScoring(ScoringInfoV01 const& info) override; // update plugin with scoring info (approximately five times per second)
@@ -207,18 +322,30 @@ public:
   void ThreadStarted(long type) override; // called just after a primary thread is started (type is 0=multimedia or 1=simulation)
   void ThreadStopping(long type) override;  // called just before a primary thread is stopped (type is 0=multimedia or 1=simulation)
 
-  bool WantsTrackRulesAccess() override { return false; } // change to true in order to read or write track order (during formation or caution laps)
+  bool WantsTrackRulesAccess() override { return SharedMemoryPlugin::msRules; } // change to true in order to read or write track order (during formation or caution laps)
   bool AccessTrackRules(TrackRulesV01& info) override; // current track order passed in; return true if you want to change it (note: this will be called immediately after UpdateScoring() when appropriate)
 
   // PIT MENU INFO (currently, the only way to edit the pit menu is to use this in conjunction with CheckHWControl())
-  bool WantsPitMenuAccess() { return false; } // change to true in order to view pit menu info
+  bool WantsPitMenuAccess() override { return SharedMemoryPlugin::msPitMenu; } // change to true in order to view pit menu info
   bool AccessPitMenu(PitMenuV01& info) override; // currently, the return code should always be false (because we may allow more direct editing in the future)
 
   void SetPhysicsOptions(PhysicsOptionsV01& options) override;
 
-  // FUTURE/V2: SCORING CONTROL (only available in single-player or on multiplayer server)
-  // virtual bool WantsMultiSessionRulesAccess() { return(false); } // change to true in order to read or write multi-session rules
-  // virtual bool AccessMultiSessionRules(MultiSessionRulesV01 &info) { return(false); } // current internal rules passed in; return true if you want to change them
+  // GAME INPUT
+  bool HasHardwareInputs() override { return SharedMemoryPlugin::msControlInput; } // whether plugin has hardware plugins
+  void UpdateHardware(double const fDT) override; // update the hardware with the time between frames
+  bool CheckHWControl(char const* const controlName, double& fRetVal) override; // see if the plugin wants to take over a hardware control
+
+  // FORCE FEEDBACK (only read, never changed)
+  bool ForceFeedback(double& forceValue) override; // alternate force feedback computation - return true if editing the value
+
+  // WEATHER (only read, never changed)
+  bool WantsWeatherAccess() override { return SharedMemoryPlugin::msWeather; }
+  bool AccessWeather(double trackNodeSize, WeatherControlInfoV01& info) override; // current weather is passed in; return true if you want to change it
+
+  // SCORING CONTROL (only available in single-player or on multiplayer server, only read, never changed)
+  bool WantsMultiSessionRulesAccess() override { return SharedMemoryPlugin::msMultiSessionRules; } // change to true in order to read or write multi-session rules
+  bool AccessMultiSessionRules(MultiSessionRulesV01& info) override; // current internal rules passed in; return true if you want to change them
 
 private:
   SharedMemoryPlugin(SharedMemoryPlugin const& rhs) = delete;
@@ -234,9 +361,40 @@ private:
   void TelemetryTraceVehicleAdded(TelemInfoV01 const& infos) const;
   void TelemetryTraceEndUpdate(int numVehiclesInChain) const;
   void TelemetryFlipBuffers();
+  void TelemetryAddHistoryFrame();
+  void TelemetryDiscardChain();
+
+  void KinematicsAddVehicle(int vehicleIndex, TelemInfoV01 const& info);
+
+  void PlayerTelemetryPublish(TelemInfoV01 const& info);
+  void KinematicsFlipBuffers();
+
+  void LiteTelemetryInitialize();
+  void LiteTelemetryFlipBuffers(int numVehiclesInChain);
+
+  void TelemetryRecorderTraceStats() const;
+
+  void StatsAddTelemetryFrame(int numVehiclesInChain);
+  void StatsPublish();
 
   void ScoringTraceBeginUpdate();
 
+  void ReaderRegistryPoll();
+  bool IsBufferRead(unsigned int readMask, rF2ReaderBuffer buffer) const { return (readMask & static_cast<unsigned int>(buffer)) != 0u; }
+
+  void ExtendedFlipBuffers();
+
+  void RulesClearState();
+  void RulesSnapshotStats();
+  void RulesReadStats(rF2BufferStats& stats) const;
+
+  // True if callback should be queued for the publisher thread instead of being published inline.
+  bool PublisherQueues() const { return mCallbackPublisher.IsRunning() && !mCallbackPublisher.IsPublisherThread(); }
+  // Callbacks are journaled on the game thread that made them, before they are queued, never again on replay.
+  bool JournalsCallbacks() const { return mCallbackJournal.IsOpen() && !mCallbackPublisher.IsPublisherThread(); }
+  static void PublisherHandleRecord(void* pContext, CallbackPublisher::Record& record, ScoringInfoV01 const* pScoringInfo);
+  void PublisherTraceDrops();
+
 private:
 
   // Only used for debugging in Timing level
@@ -257,10 +415,96 @@ private:
   bool mParticipantTelemetryUpdated[MAX_PARTICIPANT_SLOTS];
   // Number of vehicles last reported by UpdateScoring.
   int mScoringNumVehicles = 0;
+  // mLapDist last reported by UpdateScoring, indexed by mID.  Telemetry does not carry it.
+  double mScoringLapDist[rF2MappedBufferHeader::MAX_MAPPED_IDS];
+  // mID of the vehicle with mIsPlayer set in the last scoring update, -1 if none.  Telemetry does not carry it either.
+  long mScoringPlayerID = -1L;
+  // Same, but as of the last scoring update queued for the publisher thread.  Game thread only, player telemetry
+  // is published there if publisher thread is running.
+  long mSubmittedPlayerID = -1L;
 
   MappedDoubleBuffer<rF2Telemetry> mTelemetry;
   MappedDoubleBuffer<rF2Scoring> mScoring;
   MappedDoubleBuffer<rF2Extended> mExtended;
+  MappedDoubleBuffer<rF2Kinematics> mKinematics;
+
+  // Only mapped if liteTelemetryFields is set.
+  MappedDoubleBuffer<rF2LiteTelemetry> mLiteTelemetry;
+  TelemetryProjection mLiteTelemetryProjection;
+  // Record layout, written once.  Passed as initial contents on each ClearState.
+  rF2LiteTelemetryHeader mLiteTelemetryLayout = {};
+
+  // Only mapped if rules=1.  Track rules actions are kept in a ring, because game passes each action once.
+  // Passed as initial contents on each ClearState, mTrackRules is not kept and stays zeroed.
+  MappedDoubleBuffer<rF2Rules> mRules;
+  rF2RulesHeader mRulesActions = {};
+  // mRules.Stats() as of the last flip, read by StatsPublish.  See RulesSnapshotStats.
+  struct RulesStats
+  {
+    unsigned int mSequence;
+    rF2BufferStats mStats;
+  };
+  RulesStats mRulesStats = {};
+
+  // Per vehicle change tracking for mapped telemetry and scoring buffers.
+  VehicleUpdateTracker mTelemetryUpdateTracker;
+  VehicleUpdateTracker mScoringUpdateTracker;
+
+  // Last N complete telemetry frames, only mapped if telemetryHistoryFrames > 0.
+  MappedHistoryRing<rF2TelemetryHistory, rF2TelemetryHistorySlot> mTelemetryHistory;
+
+  // Discrete race events, only mapped if raceEvents=1.
+  MappedHistoryRing<rF2RaceEvents, rF2RaceEvent> mRaceEvents;
+  RaceEventTracker mRaceEventTracker;
+
+  // mResultsStream text of scoring updates, only mapped if resultsStream=1.
+  MappedTextRing<rF2ResultsStream> mResultsStream;
+
+  // Weather node grid, only mapped if weather=1.  Published only when mWeatherState changes.
+  MappedSeqlockBuffer<rF2Weather> mWeather;
+  rF2Weather mWeatherState = {};
+
+  // Multi-session rules and pit menu, only mapped if multiSessionRules=1 and pitMenu=1.  Published only on change.
+  MappedSeqlockBuffer<rF2MultiRules> mMultiRules;
+  rF2MultiRules mMultiRulesState = {};
+  MappedSeqlockBuffer<rF2PitInfo> mPitInfo;
+  rF2PitInfo mPitInfoState = {};
+
+  // Camera state, only mapped if graphics=1.  Written from the render thread.
+  MappedSeqlockBuffer<rF2Graphics> mGraphics;
+  rF2Graphics mGraphicsState = {};
+
+  // Player vehicle telemetry, only mapped if playerTelemetry=1.  Published ahead of the telemetry frame.
+  MappedSeqlockBuffer<rF2PlayerTelemetry> mPlayerTelemetry;
+
+  // Force feedback samples, only mapped if forceFeedback=1.
+  MappedSampleRing<rF2ForceFeedback, rF2ForceFeedbackSample> mForceFeedback;
+
+  // Control values posted by external processes, only mapped if controlInput=1.
+  MappedControlInput<rF2ControlInput, rF2ControlCommand> mControlInput;
+
+  // Plugin health statistics.  Optional, plugin works without it.
+  MappedSeqlockBuffer<rF2Stats> mStats;
+  rF2Stats mStatsCounters = {};
+  // Start of the current telemetry update chain, for frame assembly time.
+  double mTelemetryChainStartTicks = 0.0;
+
+  // Clients that registered, only mapped if readerRegistry=1.  Buffers not in mReadBuffersMask are not updated.
+  // Polled on the publisher thread if it is running, but also read on the simulation thread.
+  MappedReaderRegistry<rF2ReaderRegistry> mReaderRegistry;
+  std::atomic<unsigned int> mReadBuffersMask;
+  // mReadBuffersMask as of the start of the current telemetry update chain, so that frames are never half assembled.
+  unsigned int mTelemetryChainReadMask = static_cast<unsigned int>(rF2ReaderBuffer::All);
+
+  // Compressed telemetry recording written by a background thread, only running if telemetryRecorder=1.
+  TelemetryRecorder mTelemetryRecorder;
+
+  // Publishes callbacks off the game threads, only running if publisherThread=1.
+  CallbackPublisher mCallbackPublisher;
+  unsigned long long mPublisherDropsReported = 0uLL;
+
+  // Raw game callbacks, only open if callbackJournal=1.  See Tools\JournalReplay.cpp.
+  CallbackJournal::JournalWriter mCallbackJournal;
 
   // Buffers mapped successfully or not.
   bool mIsMapped = false;
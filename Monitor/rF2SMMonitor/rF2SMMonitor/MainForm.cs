@@ -28,6 +28,7 @@ namespace rF2SMMonitor
     private const int DISCONNECTED_CHECK_INTERVAL_MS = 15000;
     private const float DEGREES_IN_RADIAN = 57.2957795f;
     private const int LIGHT_MODE_REFRESH_MS = 500;
+    private const int FLIP_WAIT_TIMEOUT_MS = 50;
     System.Windows.Forms.Timer connectTimer = new System.Windows.Forms.Timer();
     System.Windows.Forms.Timer disconnectTimer = new System.Windows.Forms.Timer();
     bool connected = false;
@@ -36,11 +37,15 @@ namespace rF2SMMonitor
     {
       readonly int RF2_BUFFER_HEADER_SIZE_BYTES = Marshal.SizeOf(typeof(rF2BufferHeader));
       readonly int RF2_BUFFER_HEADER_WITH_SIZE_SIZE_BYTES = Marshal.SizeOf(typeof(rF2MappedBufferHeaderWithSize));
+      readonly int RF2_BUFFER_SEQUENCE_OFFSET = Marshal.OffsetOf(typeof(rF2MappedBufferHeaderWithSize), "mSequence").ToInt32();
+      readonly int RF2_BUFFER_BYTES_UPDATED_HINT_OFFSET = Marshal.OffsetOf(typeof(rF2MappedBufferHeaderWithSize), "mBytesUpdatedHint").ToInt32();
+      const int MAX_SEQLOCK_READ_ATTEMPTS = 10;
 
       readonly int BUFFER_SIZE_BYTES;
       readonly string BUFFER1_NAME;
       readonly string BUFFER2_NAME;
       readonly string MUTEX_NAME;
+      readonly string FLIP_EVENT_NAME;
 
       // Holds the entire byte array that can be marshalled to a MappedBufferT.  Partial updates
       // only read changed part of buffer, ignoring trailing uninteresting bytes.  However,
@@ -49,20 +54,44 @@ namespace rF2SMMonitor
       byte[] fullSizeBuffer = null;
 
       Mutex mutex = null;
+      EventWaitHandle flipEvent = null;
       MemoryMappedFile memoryMappedFile1 = null;
       MemoryMappedFile memoryMappedFile2 = null;
 
-      public MappedDoubleBuffer(string buff1Name, string buff2Name, string mutexName)
+      public MappedDoubleBuffer(string buff1Name, string buff2Name, string mutexName, string flipEventName = null)
       {
         this.BUFFER_SIZE_BYTES = Marshal.SizeOf(typeof(MappedBufferT));
         this.BUFFER1_NAME = buff1Name;
         this.BUFFER2_NAME = buff2Name;
         this.MUTEX_NAME = mutexName;
+        this.FLIP_EVENT_NAME = flipEventName;
       }
 
       public void Connect()
       {
-        this.mutex = Mutex.OpenExisting(this.MUTEX_NAME);
+        try
+        {
+          this.mutex = Mutex.OpenExisting(this.MUTEX_NAME);
+        }
+        catch (WaitHandleCannotBeOpenedException)
+        {
+          // Plugin runs in Seqlock sync mode, mutexes are not created.
+          this.mutex = null;
+        }
+
+        if (this.FLIP_EVENT_NAME != null)
+        {
+          try
+          {
+            this.flipEvent = EventWaitHandle.OpenExisting(this.FLIP_EVENT_NAME);
+          }
+          catch (WaitHandleCannotBeOpenedException)
+          {
+            // Plugin runs with flip notification disabled.
+            this.flipEvent = null;
+          }
+        }
+
         this.memoryMappedFile1 = MemoryMappedFile.OpenExisting(this.BUFFER1_NAME);
         this.memoryMappedFile2 = MemoryMappedFile.OpenExisting(this.BUFFER2_NAME);
 
@@ -81,14 +110,84 @@ namespace rF2SMMonitor
         if (this.mutex != null)
           this.mutex.Dispose();
 
+        if (this.flipEvent != null)
+          this.flipEvent.Dispose();
+
         this.memoryMappedFile1 = null;
         this.memoryMappedFile2 = null;
         this.fullSizeBuffer = null;
         this.mutex = null;
+        this.flipEvent = null;
+      }
+
+      // Blocks until plugin flips this buffer or timeout elapses.  Returns false immediately if plugin
+      // does not signal flips (flipNotification=0), so caller falls back to polling.
+      public bool WaitForFlip(int millisecondsTimeout)
+      {
+        if (this.flipEvent == null)
+          return false;
+
+        this.flipEvent.WaitOne(millisecondsTimeout);
+        return true;
+      }
+
+      // Used in Seqlock sync mode.  Copies current read buffer, and retries if plugin was writing to it during the copy.
+      // See Include\Seqlock.h for the protocol description.
+      private byte[] GetMappedBytesSeqlock(bool partial)
+      {
+        for (int attempt = 0; attempt < MAX_SEQLOCK_READ_ATTEMPTS; ++attempt)
+        {
+          using (var sharedMemoryStreamView1 = this.memoryMappedFile1.CreateViewStream())
+          using (var sharedMemoryStreamView2 = this.memoryMappedFile2.CreateViewStream())
+          {
+            // mCurrentRead is the first byte of the header.
+            var sharedMemoryStream = new BinaryReader(sharedMemoryStreamView1);
+            if (sharedMemoryStream.ReadByte() != 1)
+              sharedMemoryStream = new BinaryReader(sharedMemoryStreamView2);
+
+            sharedMemoryStream.BaseStream.Position = this.RF2_BUFFER_SEQUENCE_OFFSET;
+            var sequence = sharedMemoryStream.ReadUInt32();
+            if ((sequence & 1) != 0)
+              continue;  // Buffer is being written to.
+
+            var bytesToRead = this.BUFFER_SIZE_BYTES;
+            if (partial)
+            {
+              sharedMemoryStream.BaseStream.Position = this.RF2_BUFFER_BYTES_UPDATED_HINT_OFFSET;
+              var bytesUpdatedHint = sharedMemoryStream.ReadInt32();
+              if (bytesUpdatedHint > 0 && bytesUpdatedHint <= this.BUFFER_SIZE_BYTES)
+                bytesToRead = bytesUpdatedHint;
+            }
+
+            sharedMemoryStream.BaseStream.Position = 0;
+            var sharedMemoryReadBuffer = sharedMemoryStream.ReadBytes(bytesToRead);
+
+            Thread.MemoryBarrier();
+
+            sharedMemoryStream.BaseStream.Position = this.RF2_BUFFER_SEQUENCE_OFFSET;
+            if (sharedMemoryStream.ReadUInt32() == sequence)
+              return sharedMemoryReadBuffer;
+          }
+        }
+
+        return null;
       }
 
       public void GetMappedData(ref MappedBufferT mappedData)
       {
+        if (this.mutex == null)
+        {
+          var seqlockReadBuffer = this.GetMappedBytesSeqlock(false /*partial*/);
+          if (seqlockReadBuffer == null)
+            return;
+
+          var seqlockHandle = GCHandle.Alloc(seqlockReadBuffer, GCHandleType.Pinned);
+          mappedData = (MappedBufferT)Marshal.PtrToStructure(seqlockHandle.AddrOfPinnedObject(), typeof(MappedBufferT));
+          seqlockHandle.Free();
+
+          return;
+        }
+
         //
         // IMPORTANT:  Clients that do not need consistency accross the whole buffer, like dashboards that visualize data, _do not_ need to use mutexes.
         //
@@ -146,6 +245,21 @@ namespace rF2SMMonitor
 
       public void GetMappedDataPartial(ref MappedBufferT mappedData)
       {
+        if (this.mutex == null)
+        {
+          var seqlockReadBuffer = this.GetMappedBytesSeqlock(true /*partial*/);
+          if (seqlockReadBuffer == null)
+            return;
+
+          Array.Copy(seqlockReadBuffer, this.fullSizeBuffer, seqlockReadBuffer.Length);
+
+          var seqlockHandle = GCHandle.Alloc(this.fullSizeBuffer, GCHandleType.Pinned);
+          mappedData = (MappedBufferT)Marshal.PtrToStructure(seqlockHandle.AddrOfPinnedObject(), typeof(MappedBufferT));
+          seqlockHandle.Free();
+
+          return;
+        }
+
         //
         // IMPORTANT:  Clients that do not need consistency accross the whole buffer, like dashboards that visualize data, _do not_ need to use mutexes.
         //
@@ -214,8 +328,121 @@ namespace rF2SMMonitor
       }
     }
 
+    // Registers monitor in $rFactor2SMMP_ReaderRegistry$, so that plugin running with readerRegistry=1 keeps updating
+    // buffers monitor reads.  See rF2ReaderRegistry in Include\rF2State.h for the protocol.
+    private class ReaderRegistration
+    {
+      readonly int SLOTS_OFFSET = Marshal.OffsetOf(typeof(rF2ReaderRegistry), "mSlots").ToInt32();
+      readonly int SLOT_SIZE_BYTES = Marshal.SizeOf(typeof(rF2ReaderSlot));
+      readonly int OWNER_OFFSET = Marshal.OffsetOf(typeof(rF2ReaderSlot), "mOwner").ToInt32();
+      readonly int BUFFER_MASK_OFFSET = Marshal.OffsetOf(typeof(rF2ReaderSlot), "mBufferMask").ToInt32();
+      readonly int HEARTBEAT_OFFSET = Marshal.OffsetOf(typeof(rF2ReaderSlot), "mHeartbeat").ToInt32();
+      readonly int NAME_OFFSET = Marshal.OffsetOf(typeof(rF2ReaderSlot), "mName").ToInt32();
+      const int NAME_BYTES = 16;
+
+      readonly byte[] READER_NAME = new byte[NAME_BYTES];
+      readonly uint BUFFER_MASK;
+      readonly int PROCESS_ID = Process.GetCurrentProcess().Id;
+
+      MemoryMappedFile memoryMappedFile = null;
+      MemoryMappedViewAccessor view = null;
+      int slotOffset = -1;
+      uint heartbeat = 0;
+
+      public ReaderRegistration(string readerName, rF2ReaderBuffer bufferMask)
+      {
+        Encoding.ASCII.GetBytes(readerName, 0, Math.Min(readerName.Length, NAME_BYTES - 1), this.READER_NAME, 0);
+        this.BUFFER_MASK = (uint)bufferMask;
+      }
+
+      public void Connect()
+      {
+        try
+        {
+          this.memoryMappedFile = MemoryMappedFile.OpenExisting(rFactor2Constants.MM_READER_REGISTRY_FILE_NAME);
+        }
+        catch (FileNotFoundException)
+        {
+          // Plugin runs without reader registry, all buffers are updated.
+          this.memoryMappedFile = null;
+          return;
+        }
+
+        this.view = this.memoryMappedFile.CreateViewAccessor();
+        this.Claim();
+      }
+
+      public void Disconnect()
+      {
+        if (this.view != null && this.slotOffset != -1)
+        {
+          this.view.Write(this.slotOffset + this.BUFFER_MASK_OFFSET, 0u);
+          this.CompareExchangeOwner(this.slotOffset, 0, this.PROCESS_ID);
+        }
+
+        if (this.view != null)
+          this.view.Dispose();
+
+        if (this.memoryMappedFile != null)
+          this.memoryMappedFile.Dispose();
+
+        this.view = null;
+        this.memoryMappedFile = null;
+        this.slotOffset = -1;
+      }
+
+      // Call at least every HEARTBEAT_TIMEOUT_MS / 2.
+      public void Heartbeat()
+      {
+        if (this.view == null)
+          return;
+
+        // Plugin frees the slot if heartbeat stops for too long (debugger break etc.).  Claim again then.
+        if (this.slotOffset == -1 || this.view.ReadInt32(this.slotOffset + this.OWNER_OFFSET) != this.PROCESS_ID)
+          this.Claim();
+
+        if (this.slotOffset != -1)
+          this.view.Write(this.slotOffset + this.HEARTBEAT_OFFSET, ++this.heartbeat);
+      }
+
+      void Claim()
+      {
+        this.slotOffset = -1;
+        for (int i = 0; i < rF2ReaderRegistry.MAX_READERS; ++i)
+        {
+          var offset = this.SLOTS_OFFSET + i * this.SLOT_SIZE_BYTES;
+          if (this.CompareExchangeOwner(offset, this.PROCESS_ID, 0) != 0)
+            continue;
+
+          this.view.WriteArray(offset + this.NAME_OFFSET, this.READER_NAME, 0, NAME_BYTES);
+          this.view.Write(offset + this.BUFFER_MASK_OFFSET, this.BUFFER_MASK);
+          this.view.Write(offset + this.HEARTBEAT_OFFSET, ++this.heartbeat);
+          this.slotOffset = offset;
+          return;
+        }
+      }
+
+      unsafe int CompareExchangeOwner(int slotOffset, int value, int comparand)
+      {
+        byte* pView = null;
+        this.view.SafeMemoryMappedViewHandle.AcquirePointer(ref pView);
+        try
+        {
+          var pOwner = (int*)(pView + this.view.PointerOffset + slotOffset + this.OWNER_OFFSET);
+          return Interlocked.CompareExchange(ref *pOwner, value, comparand);
+        }
+        finally
+        {
+          this.view.SafeMemoryMappedViewHandle.ReleasePointer();
+        }
+      }
+    }
+
+    ReaderRegistration readerRegistration = new ReaderRegistration("rF2SMMonitor",
+      rF2ReaderBuffer.Telemetry | rF2ReaderBuffer.Scoring | rF2ReaderBuffer.Extended);
+
     MappedDoubleBuffer<rF2Telemetry> telemetryBuffer = new MappedDoubleBuffer<rF2Telemetry>(rFactor2Constants.MM_TELEMETRY_FILE_NAME1, 
-      rFactor2Constants.MM_TELEMETRY_FILE_NAME2, rFactor2Constants.MM_TELEMETRY_FILE_ACCESS_MUTEX);
+      rFactor2Constants.MM_TELEMETRY_FILE_NAME2, rFactor2Constants.MM_TELEMETRY_FILE_ACCESS_MUTEX, rFactor2Constants.MM_TELEMETRY_FLIP_EVENT_NAME);
 
     MappedDoubleBuffer<rF2Scoring> scoringBuffer = new MappedDoubleBuffer<rF2Scoring>(rFactor2Constants.MM_SCORING_FILE_NAME1,
       rFactor2Constants.MM_SCORING_FILE_NAME2, rFactor2Constants.MM_SCORING_FILE_ACCESS_MUTEX);
@@ -448,6 +675,10 @@ namespace rF2SMMonitor
     {
       while (this.IsApplicationIdle())
       {
+        // Instead of spinning, sleep until the next telemetry frame if plugin signals flips.
+        if (this.connected && !this.logLightMode)
+          this.telemetryBuffer.WaitForFlip(FLIP_WAIT_TIMEOUT_MS);
+
         this.MainUpdate();
 
         if (base.WindowState == FormWindowState.Minimized)
@@ -474,6 +705,7 @@ namespace rF2SMMonitor
 
       try
       {
+        readerRegistration.Heartbeat();
         extendedBuffer.GetMappedData(ref extended);
         scoringBuffer.GetMappedDataPartial(ref scoring);
         telemetryBuffer.GetMappedDataPartial(ref telemetry);
@@ -551,7 +783,7 @@ namespace rF2SMMonitor
         float yStep = SystemFonts.DefaultFont.Height;
         var gameStateText = new StringBuilder();
         gameStateText.Append(
-          $"Plugin Version:    Expected: 2.0.0.0 64bit   Actual: {MainForm.GetStringFromBytes(this.extended.mVersion)} {(this.extended.is64bit == 1 ? "64bit" : "32bit")}    FPS: {this.fps}");
+          $"Plugin Version:    Expected: 2.0.2.0 64bit   Actual: {MainForm.GetStringFromBytes(this.extended.mVersion)} {(this.extended.is64bit == 1 ? "64bit" : "32bit")}    FPS: {this.fps}");
 
         if (this.extended.is64bit == 0)
           throw new NotSupportedException("32bit rF2 is not supported.");
@@ -825,6 +1057,7 @@ namespace rF2SMMonitor
           this.telemetryBuffer.Connect();
           this.scoringBuffer.Connect();
           this.extendedBuffer.Connect();
+          this.readerRegistration.Connect();
 
           this.connected = true;
 
@@ -857,6 +1090,7 @@ namespace rF2SMMonitor
 
     private void Disconnect()
     {
+      this.readerRegistration.Disconnect();
       this.extendedBuffer.Disconnect();
       this.scoringBuffer.Disconnect();
       this.telemetryBuffer.Disconnect();
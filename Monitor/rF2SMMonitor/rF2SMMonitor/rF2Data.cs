@@ -24,10 +24,15 @@ namespace rF2SMMonitor
     public const string MM_TELEMETRY_FILE_NAME1 = "$rFactor2SMMP_TelemetryBuffer1$";
     public const string MM_TELEMETRY_FILE_NAME2 = "$rFactor2SMMP_TelemetryBuffer2$";
     public const string MM_TELEMETRY_FILE_ACCESS_MUTEX = @"Global\$rFactor2SMMP_TelemeteryMutex";
+    public const string MM_TELEMETRY_MULTI_BUFFER_FILE_NAME = "$rFactor2SMMP_TelemetryMultiBuffer$";
+    public const string MM_TELEMETRY_FLIP_EVENT_NAME = @"Global\$rFactor2SMMP_TelemetryFlipEvent";
+    public const string MM_TELEMETRY_HISTORY_FILE_NAME = "$rFactor2SMMP_TelemetryHistory$";
 
     public const string MM_SCORING_FILE_NAME1 = "$rFactor2SMMP_ScoringBuffer1$";
     public const string MM_SCORING_FILE_NAME2 = "$rFactor2SMMP_ScoringBuffer2$";
     public const string MM_SCORING_FILE_ACCESS_MUTEX = @"Global\$rFactor2SMMP_ScoringMutex";
+    public const string MM_SCORING_MULTI_BUFFER_FILE_NAME = "$rFactor2SMMP_ScoringMultiBuffer$";
+    public const string MM_SCORING_FLIP_EVENT_NAME = @"Global\$rFactor2SMMP_ScoringFlipEvent";
 
     public const string MM_PHYSICS_FILE_NAME1 = "$rFactor2SMMP_PhysicsBuffer1$";
     public const string MM_PHYSICS_FILE_NAME2 = "$rFactor2SMMP_PhysicsBuffer2$";
@@ -36,9 +41,56 @@ namespace rF2SMMonitor
     public const string MM_EXTENDED_FILE_NAME1 = "$rFactor2SMMP_ExtendedBuffer1$";
     public const string MM_EXTENDED_FILE_NAME2 = "$rFactor2SMMP_ExtendedBuffer2$";
     public const string MM_EXTENDED_FILE_ACCESS_MUTEX = @"Global\$rFactor2SMMP_ExtendedMutex";
+    public const string MM_EXTENDED_MULTI_BUFFER_FILE_NAME = "$rFactor2SMMP_ExtendedMultiBuffer$";
+    public const string MM_EXTENDED_FLIP_EVENT_NAME = @"Global\$rFactor2SMMP_ExtendedFlipEvent";
+
+    public const string MM_KINEMATICS_FILE_NAME1 = "$rFactor2SMMP_KinematicsBuffer1$";
+    public const string MM_KINEMATICS_FILE_NAME2 = "$rFactor2SMMP_KinematicsBuffer2$";
+    public const string MM_KINEMATICS_FILE_ACCESS_MUTEX = @"Global\$rFactor2SMMP_KinematicsMutex";
+    public const string MM_KINEMATICS_MULTI_BUFFER_FILE_NAME = "$rFactor2SMMP_KinematicsMultiBuffer$";
+    public const string MM_KINEMATICS_FLIP_EVENT_NAME = @"Global\$rFactor2SMMP_KinematicsFlipEvent";
+
+    public const string MM_LITE_TELEMETRY_FILE_NAME1 = "$rFactor2SMMP_LiteTelemetryBuffer1$";
+    public const string MM_LITE_TELEMETRY_FILE_NAME2 = "$rFactor2SMMP_LiteTelemetryBuffer2$";
+    public const string MM_LITE_TELEMETRY_FILE_ACCESS_MUTEX = @"Global\$rFactor2SMMP_LiteTelemetryMutex";
+    public const string MM_LITE_TELEMETRY_MULTI_BUFFER_FILE_NAME = "$rFactor2SMMP_LiteTelemetryMultiBuffer$";
+    public const string MM_LITE_TELEMETRY_FLIP_EVENT_NAME = @"Global\$rFactor2SMMP_LiteTelemetryFlipEvent";
+
+    public const string MM_RULES_FILE_NAME1 = "$rFactor2SMMP_RulesBuffer1$";
+    public const string MM_RULES_FILE_NAME2 = "$rFactor2SMMP_RulesBuffer2$";
+    public const string MM_RULES_FILE_ACCESS_MUTEX = @"Global\$rFactor2SMMP_RulesMutex";
+    public const string MM_RULES_MULTI_BUFFER_FILE_NAME = "$rFactor2SMMP_RulesMultiBuffer$";
+    public const string MM_RULES_FLIP_EVENT_NAME = @"Global\$rFactor2SMMP_RulesFlipEvent";
+
+    public const string MM_STATS_FILE_NAME = "$rFactor2SMMP_Stats$";
+
+    public const string MM_READER_REGISTRY_FILE_NAME = "$rFactor2SMMP_ReaderRegistry$";
+
+    public const string MM_RACE_EVENTS_FILE_NAME = "$rFactor2SMMP_RaceEvents$";
+
+    public const string MM_RESULTS_STREAM_FILE_NAME = "$rFactor2SMMP_ResultsStream$";
+
+    public const string MM_WEATHER_FILE_NAME = "$rFactor2SMMP_Weather$";
+
+    public const string MM_MULTI_RULES_FILE_NAME = "$rFactor2SMMP_MultiRules$";
+
+    public const string MM_PIT_INFO_FILE_NAME = "$rFactor2SMMP_PitInfo$";
+
+    public const string MM_GRAPHICS_FILE_NAME = "$rFactor2SMMP_Graphics$";
+
+    public const string MM_PLAYER_TELEMETRY_FILE_NAME = "$rFactor2SMMP_PlayerTelemetry$";
+
+    public const string MM_FORCE_FEEDBACK_FILE_NAME = "$rFactor2SMMP_ForceFeedback$";
+
+    public const string MM_CONTROL_INPUT_FILE_NAME = "$rFactor2SMMP_ControlInput$";
 
     public const int MAX_MAPPED_VEHICLES = 128;
     public const int MAX_MAPPED_IDS = 256;
+    public const int MAX_MULTI_BUFFERS = 8;
+    public const int VEHICLE_MASK_WORDS = MAX_MAPPED_VEHICLES / 32;
+    public const int MAX_LITE_TELEMETRY_FIELDS = 64;
+    public const int MAX_LITE_TELEMETRY_RECORD_BYTES = 2048;
+    public const int MAX_MAPPED_RULES_ACTIONS = 64;
     public const string RFACTOR2_PROCESS_NAME = "rFactor2";
 
     // TODO: remove if not needed
@@ -159,6 +211,52 @@ namespace rF2SMMonitor
       CountLapAndTime = 2,
     }
 
+    // Mirror of TrackRulesCommandV01.
+    public enum rF2TrackRulesCommand
+    {
+      AddFromTrack = 0,             // crossed s/f line for first time after full-course yellow was called
+      AddFromPit,                   // exited pit during full-course yellow
+      AddFromUndq,                  // during a full-course yellow, the admin reversed a disqualification
+      RemoveToPit,                  // entered pit during full-course yellow
+      RemoveToDnf,                  // vehicle DNF'd during full-course yellow
+      RemoveToDq,                   // vehicle DQ'd during full-course yellow
+      RemoveToUnloaded,             // vehicle unloaded (possibly kicked out or banned) during full-course yellow
+      MoveToBack,                   // misbehavior during full-course yellow, resulting in the penalty of being moved to the back of their current line
+      LongestLine,                  // misbehavior during full-course yellow, resulting in the penalty of being moved to the back of the longest line
+      //------------------
+      Maximum                       // should be last
+    }
+
+    // Mirror of TrackRulesColumnV01.
+    public enum rF2TrackRulesColumn
+    {
+      LeftLane = 0,                 // left (inside)
+      MidLeftLane,                  // mid-left
+      MiddleLane,                   // middle
+      MidRightLane,                 // mid-right
+      RightLane,                    // right (outside)
+      //------------------
+      MaxLanes,                     // should be after the valid static lane choices
+      //------------------
+      Invalid = MaxLanes,           // currently invalid (hasn't crossed line or in pits/garage)
+      FreeChoice,                   // free choice (dynamically chosen by driver)
+      Pending,                      // depends on another participant's free choice (dynamically set after another driver chooses)
+      //------------------
+      Maximum                       // should be last
+    }
+
+    // Mirror of TrackRulesStageV01.
+    public enum rF2TrackRulesStage
+    {
+      FormationInit = 0,            // initialization of the formation lap
+      FormationUpdate,              // update of the formation lap
+      Normal,                       // normal (non-yellow) update
+      CautionInit,                  // initialization of a full-course yellow
+      CautionUpdate,                // update of a full-course yellow
+      //------------------
+      Maximum                       // should be last
+    }
+
     // 0=disallowed, 1=criteria detected but not allowed quite yet, 2=allowed
     public enum rF2RearFlapLegalStatus {
       Disallowed = 0,
@@ -531,10 +629,40 @@ namespace rF2SMMonitor
     }
 
 
+    [StructLayout(LayoutKind.Sequential, CharSet = CharSet.Ansi, Pack = 4)]
+    public struct rF2WeatherControlInfo
+    {
+      // The current conditions are passed in with the API call. The following ET (Elapsed Time) value should typically be far
+      // enough in the future that it can be interpolated smoothly, and allow clouds time to roll in before rain starts. In
+      // other words you probably shouldn't have mCloudiness and mRaining suddenly change from 0.0 to 1.0 and expect that
+      // to happen in a few seconds without looking crazy.
+      public double mET;                           // when you want this weather to take effect
+
+      // mRaining[1][1] is at the origin (2013.12.19 - and currently the only implemented node), while the others
+      // are spaced at <trackNodeSize> meters where <trackNodeSize> is the maximum absolute value of a track vertex
+      // coordinate (and is passed into the API call).
+      [MarshalAsAttribute(UnmanagedType.ByValArray, SizeConst = 9)]
+      public double[] mRaining;                    // rain (0.0-1.0) at different nodes, [3][3] flattened row by row
+
+      public double mCloudiness;                   // general cloudiness (0.0=clear to 1.0=dark), will be automatically overridden to help ensure clouds exist over rainy areas
+      public double mAmbientTempK;                 // ambient temperature (Kelvin)
+      public double mWindMaxSpeed;                 // maximum speed of wind (ground speed, but it affects how fast the clouds move, too)
+
+      public byte mApplyCloudinessInstantly;       // preferably we roll the new clouds in, but you can instantly change them now
+      public byte mUnused1;                        //
+      public byte mUnused2;                        //
+      public byte mUnused3;                        //
+
+      [MarshalAsAttribute(UnmanagedType.ByValArray, SizeConst = 508)]
+      public byte[] mExpansion;                    // future use (humidity, pressure, air density, etc.)
+    }
+
+
     [StructLayout(LayoutKind.Sequential, CharSet = CharSet.Ansi, Pack = 4)]
     public struct rF2MappedBufferHeader
     {
       public byte mCurrentRead;                 // True indicates buffer is safe to read under mutex.
+      public uint mSequence;                    // Odd while buffer is being written to, incremented on every write and publish.
     }
 
 
@@ -542,31 +670,80 @@ namespace rF2SMMonitor
     public struct rF2MappedBufferHeaderWithSize
     {
       public byte mCurrentRead;                 // True indicates buffer is safe to read under mutex.
+      public uint mSequence;                    // Odd while buffer is being written to, incremented on every write and publish.
       public int mBytesUpdatedHint;             // How many bytes of the structure were written during the last update.
                                                 // 0 means unknown (whole buffer should be considered as updated).
     }
 
 
+    [StructLayout(LayoutKind.Sequential, CharSet = CharSet.Ansi, Pack = 4)]
+    public struct rF2MultiBufferControl
+    {
+      public int mNumBuffers;                   // Number of buffers following this block.
+      public int mBufferBytes;                  // Size of a single buffer structure.
+      public int mBufferStride;                 // Distance between buffers (buffer size rounded up to the cache line).
+      public int mFirstBufferOffset;            // Offset of the first buffer from the beginning of the file.
+      public int mLatest;                       // Index of the most recently published buffer.
+      [MarshalAsAttribute(UnmanagedType.ByValArray, SizeConst = (int)rFactor2Constants.MAX_MULTI_BUFFERS)]
+      public int[] mReaders;                    // Number of clients currently copying each buffer.
+    }
+
+
     [StructLayout(LayoutKind.Sequential, CharSet = CharSet.Ansi, Pack = 4)]
     public struct rF2Telemetry
     {
       public byte mCurrentRead;                 // True indicates buffer is safe to read under mutex.
+      public uint mSequence;                    // Odd while buffer is being written to, incremented on every write and publish.
       public int mBytesUpdatedHint;             // How many bytes of the structure were written during the last update.
                                                 // 0 means unknown (whole buffer should be considered as updated).
 
+      public uint mUpdateGeneration;            // Incremented on every publish of this buffer.
+      [MarshalAsAttribute(UnmanagedType.ByValArray, SizeConst = rFactor2Constants.VEHICLE_MASK_WORDS)]
+      public uint[] mVehiclesUpdatedMask;       // Bit (i % 32) of word (i / 32) is set if mVehicles[i] changed since the previous publish.
+      [MarshalAsAttribute(UnmanagedType.ByValArray, SizeConst = rFactor2Constants.MAX_MAPPED_VEHICLES)]
+      public uint[] mVehicleUpdateGeneration;   // mUpdateGeneration of the publish in which mVehicles[i] last changed.
+
       public int mNumVehicles;                  // current number of vehicles
       [MarshalAsAttribute(UnmanagedType.ByValArray, SizeConst = rFactor2Constants.MAX_MAPPED_VEHICLES)]
       public rF2VehicleTelemetry[] mVehicles;
     }
 
 
+    [StructLayout(LayoutKind.Sequential, CharSet = CharSet.Ansi, Pack = 4)]
+    public struct rF2TelemetryHistory
+    {
+      public uint mSequence;                    // Odd while header is being updated (see rF2MappedBufferHeader::mSequence).
+      public int mNumSlots;                     // Number of frames kept.
+      public int mSlotStride;                   // Distance between slots (slot size rounded up to the cache line).
+      public int mFirstSlotOffset;              // Offset of the first slot from the beginning of the file.
+      public ulong mLastFrameNumber;            // Number of the most recently completed frame, 0 if none.
+    }
+
+
+    [StructLayout(LayoutKind.Sequential, CharSet = CharSet.Ansi, Pack = 4)]
+    public struct rF2TelemetryHistorySlot
+    {
+      public uint mSequence;                    // Odd while slot is being written to (see rF2MappedBufferHeader::mSequence).
+      public ulong mFrameNumber;                // Monotonically increasing telemetry frame number.
+      public double mElapsedTime;               // ET of the frame (mElapsedTime of the first vehicle update in the frame).
+      public rF2Telemetry mTelemetry;           // Only mTelemetry.mBytesUpdatedHint bytes are written, rest is stale.
+    }
+
+
     [StructLayout(LayoutKind.Sequential, CharSet = CharSet.Ansi, Pack = 4)]
     public struct rF2Scoring
     {
       public byte mCurrentRead;                 // True indicates buffer is safe to read under mutex.
+      public uint mSequence;                    // Odd while buffer is being written to, incremented on every write and publish.
       public int mBytesUpdatedHint;             // How many bytes of the structure were written during the last update.
                                                 // 0 means unknown (whole buffer should be considered as updated).
 
+      public uint mUpdateGeneration;            // Incremented on every publish of this buffer.
+      [MarshalAsAttribute(UnmanagedType.ByValArray, SizeConst = rFactor2Constants.VEHICLE_MASK_WORDS)]
+      public uint[] mVehiclesUpdatedMask;       // Bit (i % 32) of word (i / 32) is set if mVehicles[i] changed since the previous publish.
+      [MarshalAsAttribute(UnmanagedType.ByValArray, SizeConst = rFactor2Constants.MAX_MAPPED_VEHICLES)]
+      public uint[] mVehicleUpdateGeneration;   // mUpdateGeneration of the publish in which mVehicles[i] last changed.
+
       public rF2ScoringInfo mScoringInfo;
 
       [MarshalAsAttribute(UnmanagedType.ByValArray, SizeConst = rFactor2Constants.MAX_MAPPED_VEHICLES)]
@@ -574,6 +751,66 @@ namespace rF2SMMonitor
     }
 
 
+    [StructLayout(LayoutKind.Sequential, CharSet = CharSet.Ansi, Pack = 4)]
+    public struct rF2Kinematics
+    {
+      public byte mCurrentRead;                 // True indicates buffer is safe to read under mutex.
+      public uint mSequence;                    // Odd while buffer is being written to, incremented on every write and publish.
+
+      public int mNumVehicles;                  // Number of valid entries in each column.
+      public double mElapsedTime;               // ET of the telemetry frame.
+      [MarshalAsAttribute(UnmanagedType.ByValArray, SizeConst = 44)]
+      public byte[] mAlignmentPadding;          // Aligns columns to the cache line.
+
+      [MarshalAsAttribute(UnmanagedType.ByValArray, SizeConst = rFactor2Constants.MAX_MAPPED_VEHICLES)]
+      public int[] mID;                         // slot ID (note that it can be re-used in multiplayer after someone leaves)
+      [MarshalAsAttribute(UnmanagedType.ByValArray, SizeConst = rFactor2Constants.MAX_MAPPED_VEHICLES)]
+      public double[] mPosX;                    // world position in meters
+      [MarshalAsAttribute(UnmanagedType.ByValArray, SizeConst = rFactor2Constants.MAX_MAPPED_VEHICLES)]
+      public double[] mPosY;
+      [MarshalAsAttribute(UnmanagedType.ByValArray, SizeConst = rFactor2Constants.MAX_MAPPED_VEHICLES)]
+      public double[] mPosZ;
+      [MarshalAsAttribute(UnmanagedType.ByValArray, SizeConst = rFactor2Constants.MAX_MAPPED_VEHICLES)]
+      public double[] mLocalVelX;               // velocity (meters/sec) in local vehicle coordinates
+      [MarshalAsAttribute(UnmanagedType.ByValArray, SizeConst = rFactor2Constants.MAX_MAPPED_VEHICLES)]
+      public double[] mLocalVelY;
+      [MarshalAsAttribute(UnmanagedType.ByValArray, SizeConst = rFactor2Constants.MAX_MAPPED_VEHICLES)]
+      public double[] mLocalVelZ;
+      [MarshalAsAttribute(UnmanagedType.ByValArray, SizeConst = 9 * rFactor2Constants.MAX_MAPPED_VEHICLES)]
+      public double[] mOri;                     // orientation matrix, [(row * 3 + col) * MAX_MAPPED_VEHICLES + vehicle]
+      [MarshalAsAttribute(UnmanagedType.ByValArray, SizeConst = rFactor2Constants.MAX_MAPPED_VEHICLES)]
+      public double[] mLapDist;                 // current distance around track, from the latest scoring update
+    }
+
+
+    [StructLayout(LayoutKind.Sequential, CharSet = CharSet.Ansi, Pack = 4)]
+    public struct rF2LiteTelemetryField
+    {
+      [MarshalAsAttribute(UnmanagedType.ByValArray, SizeConst = 32)]
+      public byte[] mName;                      // rF2VehicleTelemetry member name, as listed in liteTelemetryFields.
+      public int mOffset;                       // Offset of the field within the vehicle record.
+      public int mSize;                         // Size of the field in bytes.
+    }
+
+
+    // Only the header is mirrored.  Vehicle records follow it (record i starts at mRecordBytes * i), and should be
+    // decoded using mFields.
+    [StructLayout(LayoutKind.Sequential, CharSet = CharSet.Ansi, Pack = 4)]
+    public struct rF2LiteTelemetryHeader
+    {
+      public byte mCurrentRead;                 // True indicates buffer is safe to read under mutex.
+      public uint mSequence;                    // Odd while buffer is being written to, incremented on every write and publish.
+      public int mBytesUpdatedHint;             // How many bytes of the structure were written during the last update.
+
+      public int mNumFields;                    // Number of valid entries in mFields.
+      public int mRecordBytes;                  // Size of a single vehicle record.
+      public int mNumVehicles;                  // Number of records written.
+      public double mElapsedTime;               // ET of the telemetry frame.
+      [MarshalAsAttribute(UnmanagedType.ByValArray, SizeConst = rFactor2Constants.MAX_LITE_TELEMETRY_FIELDS)]
+      public rF2LiteTelemetryField[] mFields;
+    }
+
+
     [StructLayout(LayoutKind.Sequential, Pack = 4)]
     public struct rF2TrackedDamage
     {
@@ -586,6 +823,7 @@ namespace rF2SMMonitor
     public struct rF2Extended
     {
       public byte mCurrentRead;                          // True indicates buffer is safe to read under mutex.
+      public uint mSequence;                             // Odd while buffer is being written to, incremented on every write and publish.
 
       [MarshalAsAttribute(UnmanagedType.ByValArray, SizeConst = 8)]
       public byte[] mVersion;                            // API version
@@ -605,10 +843,502 @@ namespace rF2SMMonitor
     }
 
 
+    // Indexes of rF2Stats.mBuffers.
+    public enum rF2StatsBufferType
+    {
+      Telemetry = 0,
+      Scoring = 1,
+      Extended = 2,
+      Kinematics = 3,
+      LiteTelemetry = 4,
+      Rules = 5
+    }
+
+
+    [StructLayout(LayoutKind.Sequential, Pack = 4)]
+    public struct rF2BufferStats
+    {
+      public const int HISTOGRAM_BUCKETS = 32;
+
+      public ulong mFlips;                               // Buffers published.
+      public ulong mForcedFlips;                         // Flips that waited on the mutex instead of retrying later.  Mutex sync mode only.
+      public ulong mRetries;                             // Flips postponed (or frames skipped) because mutex was held.
+      public ulong mOverwrites;                          // Flips that went ahead after mutex wait timed out or failed, or overwrote a buffer held by a reader.
+      public ulong mMutexWaits;                          // Mutex acquisition attempts timed in mMutexWaitHistogram.
+      [MarshalAsAttribute(UnmanagedType.ByValArray, SizeConst = rF2BufferStats.HISTOGRAM_BUCKETS)]
+      public ulong[] mMutexWaitHistogram;                // Bucket i counts attempts that took [2^i, 2^(i+1)) ns.
+    }
+
+
+    [StructLayout(LayoutKind.Sequential, Pack = 4)]
+    public struct rF2Stats
+    {
+      public const int NUM_BUFFER_TYPES = 6;
+
+      public uint mSequence;                             // Odd while buffer is being written to.  No mCurrentRead, single buffer.
+      [MarshalAsAttribute(UnmanagedType.ByValArray, SizeConst = 4)]
+      public byte[] mAlignmentPadding1;                  // Keeps 8 byte fields naturally aligned.
+      public ulong mPublishCount;                        // Incremented on every update of this buffer.
+
+      [MarshalAsAttribute(UnmanagedType.ByValArray, SizeConst = rF2Stats.NUM_BUFFER_TYPES)]
+      public rF2BufferStats[] mBuffers;                  // Indexed by rF2StatsBufferType.
+
+      public ulong mTelemetryFrames;                     // Complete telemetry frames assembled.
+      public ulong mSkippedDuplicateETUpdates;           // Telemetry updates skipped because ET did not change.
+      [MarshalAsAttribute(UnmanagedType.ByValArray, SizeConst = rF2BufferStats.HISTOGRAM_BUCKETS)]
+      public ulong[] mFrameAssemblyHistogram;            // Telemetry frame assembly time, bucket i counts [2^i, 2^(i+1)) ns.
+      public double mLastFrameAssemblyMicroseconds;      // Assembly time of the last telemetry frame.
+      public double mMaxFrameAssemblyMicroseconds;       // Longest assembly time so far.
+      public int mLastVehiclesPerFrame;                  // Number of vehicles in the last telemetry frame.
+      [MarshalAsAttribute(UnmanagedType.ByValArray, SizeConst = 4)]
+      public byte[] mAlignmentPadding2;                  //
+      [MarshalAsAttribute(UnmanagedType.ByValArray, SizeConst = rFactor2Constants.MAX_MAPPED_VEHICLES + 1)]
+      public ulong[] mVehiclesPerFrameHistogram;         // Entry n counts telemetry frames with n vehicles.
+    }
+
+
+    // Bits of rF2ReaderSlot.mBufferMask.
+    [Flags]
+    public enum rF2ReaderBuffer : uint
+    {
+      Telemetry = 1u << 0,
+      Scoring = 1u << 1,
+      Extended = 1u << 2,
+      Kinematics = 1u << 3,
+      LiteTelemetry = 1u << 4,
+      TelemetryHistory = 1u << 5,
+      Rules = 1u << 6,
+      PlayerTelemetry = 1u << 7,
+      All = 0xFFFFFFFFu
+    }
+
+
+    [StructLayout(LayoutKind.Sequential, Pack = 4)]
+    public struct rF2ReaderSlot
+    {
+      public int mOwner;                                 // Reader's process id while slot is claimed, 0 if slot is free.
+      public uint mBufferMask;                           // rF2ReaderBuffer bits of the buffers reader consumes.
+      public uint mHeartbeat;                            // Incremented by the reader at least every HEARTBEAT_TIMEOUT_MS / 2.
+      [MarshalAsAttribute(UnmanagedType.ByValArray, SizeConst = 16)]
+      public byte[] mName;                               // Optional zero terminated reader name, for debug output.
+      [MarshalAsAttribute(UnmanagedType.ByValArray, SizeConst = 36)]
+      public byte[] mPad;
+    }
+
+
+    // See rF2ReaderRegistry in rF2State.h for the reader protocol.
+    [StructLayout(LayoutKind.Sequential, Pack = 4)]
+    public struct rF2ReaderRegistry
+    {
+      public const int MAX_READERS = 16;
+      public const uint HEARTBEAT_TIMEOUT_MS = 2000;
+
+      public uint mLiveBufferMask;                       // Set by plugin: rF2ReaderBuffer bits of buffers that currently have a live reader.
+      public uint mLiveReaders;                          // Set by plugin: number of live readers.
+      [MarshalAsAttribute(UnmanagedType.ByValArray, SizeConst = 56)]
+      public byte[] mPad;
+
+      [MarshalAsAttribute(UnmanagedType.ByValArray, SizeConst = rF2ReaderRegistry.MAX_READERS)]
+      public rF2ReaderSlot[] mSlots;
+    }
+
+
+    // Discrete race events detected by the plugin (see rF2RaceEvent).
+    public enum rF2RaceEventType
+    {
+      SessionStarted = 0,          // StartSession callback.
+      SessionEnded = 1,            // EndSession callback.
+      RealtimeEntered = 2,         // EnterRealtime callback.
+      RealtimeExited = 3,          // ExitRealtime callback.
+      GamePhaseChanged = 4,        // mOldValue/mNewValue: rF2ScoringInfo::mGamePhase.
+      YellowFlagStateChanged = 5,  // mOldValue/mNewValue: rF2ScoringInfo::mYellowFlagState.
+      VehicleJoined = 6,           // Vehicle appeared in scoring.  mNewValue: mPlace.
+      VehicleLeft = 7,             // Vehicle no longer in scoring.  mOldValue: last mPlace.
+      LapCompleted = 8,            // mOldValue/mNewValue: mTotalLaps, mValue: mLastLapTime.
+      PitEntered = 9,              // mInPits became true.
+      PitExited = 10,              // mInPits became false.
+      PitStateChanged = 11,        // mOldValue/mNewValue: mPitState (see rF2PitState).
+      PlaceChanged = 12,           // mOldValue/mNewValue: mPlace.
+      FinishStatusChanged = 13,    // mOldValue/mNewValue: mFinishStatus (see rF2FinishStatus).
+      ControlChanged = 14,         // mOldValue/mNewValue: mControl (see rF2Control).
+      PenaltiesChanged = 15,       // mOldValue/mNewValue: mNumPenalties.
+      Impact = 16                  // New impact reported in telemetry.  mValue: mLastImpactMagnitude, mElapsedTime: mLastImpactET.
+    }
+
+
+    // Header of $rFactor2SMMP_RaceEvents$, same protocol as rF2TelemetryHistory.
+    [StructLayout(LayoutKind.Sequential, Pack = 4)]
+    public struct rF2RaceEvents
+    {
+      public uint mSequence;                             // Odd while header is being updated (see rF2MappedBufferHeader::mSequence).
+      public int mNumSlots;                              // Number of events kept.
+      public int mSlotStride;                            // Distance between slots.
+      public int mFirstSlotOffset;                       // Offset of the first slot from the beginning of the file.
+      public ulong mLastFrameNumber;                     // Number of the most recent event, 0 if none.  Keeps growing across sessions.
+    }
+
+
+    [StructLayout(LayoutKind.Sequential, Pack = 4)]
+    public struct rF2RaceEvent
+    {
+      public uint mSequence;                             // Odd while slot is being written to (see rF2MappedBufferHeader::mSequence).
+      public ulong mFrameNumber;                         // Monotonically increasing event number.
+      public double mElapsedTime;                        // ET at which event was detected.
+      public rF2RaceEventType mType;
+      public int mID;                                    // Vehicle slot ID, -1 for session wide events.
+      public int mOldValue;                              // Value before the transition (see rF2RaceEventType).
+      public int mNewValue;                              // Value after the transition.
+      public double mValue;                              // Additional value (see rF2RaceEventType).
+      [MarshalAsAttribute(UnmanagedType.ByValArray, SizeConst = 20)]
+      public byte[] mPad;
+    }
+
+
+    [StructLayout(LayoutKind.Sequential, CharSet = CharSet.Ansi, Pack = 4)]
+    public struct rF2TrackRulesAction
+    {
+      // input only
+      public rFactor2Constants.rF2TrackRulesCommand mCommand;  // recommended action
+      public int mID;                              // slot ID if applicable
+      public double mET;                           // elapsed time that event occurred, if applicable
+    }
+
+
+    [StructLayout(LayoutKind.Sequential, CharSet = CharSet.Ansi, Pack = 4)]
+    public struct rF2TrackRulesParticipant
+    {
+      // input only
+      public int mID;                              // slot ID
+      public short mFrozenOrder;                   // 0-based place when caution came out (not valid for formation laps)
+      public short mPlace;                         // 1-based place (typically used for the initialization of the formation lap track order)
+      public float mYellowSeverity;                // a rating of how much this vehicle is contributing to a yellow flag (the sum of all vehicles is compared to TrackRulesV01::mSafetyCarThreshold)
+      public double mCurrentRelativeDistance;      // equal to ( ( ScoringInfoV01::mLapDist * this->mRelativeLaps ) + VehicleScoringInfoV01::mLapDist )
+
+      // input/output
+      public int mRelativeLaps;                    // current formation/caution laps relative to safety car (should generally be zero except when safety car crosses s/f line); this can be decremented to implement 'wave around' or 'beneficiary rule' (a.k.a. 'lucky dog' or 'free pass')
+      public rFactor2Constants.rF2TrackRulesColumn mColumnAssignment;  // which column (line/lane) that participant is supposed to be in
+      public int mPositionAssignment;              // 0-based position within column (line/lane) that participant is supposed to be located at (-1 is invalid)
+      public byte mAllowedToPit;                   // whether the rules allow this particular vehicle to enter pits right now
+
+      [MarshalAsAttribute(UnmanagedType.ByValArray, SizeConst = 3)]
+      public byte[] mUnused;                       //
+      public double mGoalRelativeDistance;         // calculated based on where the leader is, and adjusted by the desired column spacing and the column/position assignments
+
+      [MarshalAsAttribute(UnmanagedType.ByValArray, SizeConst = 96)]
+      public byte[] mMessage;                      // a message for this participant to explain what is going on (untranslated; it will get run through translator on client machines)
+
+      // future expansion
+      [MarshalAsAttribute(UnmanagedType.ByValArray, SizeConst = 192)]
+      public byte[] mExpansion;
+    }
+
+
+    [StructLayout(LayoutKind.Sequential, CharSet = CharSet.Ansi, Pack = 4)]
+    public struct rF2TrackRules
+    {
+      // input only
+      public double mCurrentET;                    // current time
+      public rFactor2Constants.rF2TrackRulesStage mStage;  // current stage
+      public rFactor2Constants.rF2TrackRulesColumn mPoleColumn;  // column assignment where pole position seems to be located
+      public int mNumActions;                      // number of recent actions
+      // MM_NOT_USED
+      //TrackRulesActionV01 *mAction;         // array of recent actions
+      // MM_NEW
+      [MarshalAsAttribute(UnmanagedType.ByValArray, SizeConst = 8)]
+      public byte[] pointer1;
+
+      public int mNumParticipants;                 // number of participants (vehicles)
+
+      public byte mYellowFlagDetected;             // whether yellow flag was requested or sum of participant mYellowSeverity's exceeds mSafetyCarThreshold
+      public byte mYellowFlagLapsWasOverridden;    // whether mYellowFlagLaps (below) is an admin request
+
+      public byte mSafetyCarExists;                // whether safety car even exists
+      public byte mSafetyCarActive;                // whether safety car is active
+      public int mSafetyCarLaps;                   // number of laps
+      public float mSafetyCarThreshold;            // the threshold at which a safety car is called out (compared to the sum of TrackRulesParticipantV01::mYellowSeverity for each vehicle)
+      public double mSafetyCarLapDist;             // safety car lap distance
+      public float mSafetyCarLapDistAtStart;       // where the safety car starts from
+
+      public float mPitLaneStartDist;              // where the waypoint branch to the pits breaks off (this may not be perfectly accurate)
+      public float mTeleportLapDist;               // the front of the teleport locations (a useful first guess as to where to throw the green flag)
+
+      // future input expansion
+      [MarshalAsAttribute(UnmanagedType.ByValArray, SizeConst = 256)]
+      public byte[] mInputExpansion;
+
+      // input/output
+      public sbyte mYellowFlagState;               // see ScoringInfoV01 for values
+      public short mYellowFlagLaps;                // suggested number of laps to run under yellow (may be passed in with admin command)
+
+      public int mSafetyCarInstruction;            // 0=no change, 1=go active, 2=head for pits
+      public float mSafetyCarSpeed;                // maximum speed at which to drive
+      public float mSafetyCarMinimumSpacing;       // minimum spacing behind safety car (-1 to indicate no limit)
+      public float mSafetyCarMaximumSpacing;       // maximum spacing behind safety car (-1 to indicate no limit)
+
+      public float mMinimumColumnSpacing;          // minimum desired spacing between vehicles in a column (-1 to indicate indeterminate/unenforced)
+      public float mMaximumColumnSpacing;          // maximum desired spacing between vehicles in a column (-1 to indicate indeterminate/unenforced)
+
+      public float mMinimumSpeed;                  // minimum speed that anybody should be driving (-1 to indicate no limit)
+      public float mMaximumSpeed;                  // maximum speed that anybody should be driving (-1 to indicate no limit)
+
+      [MarshalAsAttribute(UnmanagedType.ByValArray, SizeConst = 96)]
+      public byte[] mMessage;                      // a message for everybody to explain what is going on (which will get run through translator on client machines)
+
+      // MM_NOT_USED
+      //TrackRulesParticipantV01 *mParticipant;         // array of partipants (vehicles)
+      // MM_NEW
+      [MarshalAsAttribute(UnmanagedType.ByValArray, SizeConst = 8)]
+      public byte[] pointer2;
+
+      // future input/output expansion
+      [MarshalAsAttribute(UnmanagedType.ByValArray, SizeConst = 256)]
+      public byte[] mInputOutputExpansion;
+    }
+
+
+    [StructLayout(LayoutKind.Sequential, CharSet = CharSet.Ansi, Pack = 4)]
+    public struct rF2MultiSessionParticipant
+    {
+      // input only
+      public int mID;                              // slot ID (if loaded) or -1 (if currently disconnected)
+      [MarshalAsAttribute(UnmanagedType.ByValArray, SizeConst = 32)]
+      public byte[] mDriverName;                   // driver name
+      [MarshalAsAttribute(UnmanagedType.ByValArray, SizeConst = 64)]
+      public byte[] mVehicleName;                  // vehicle name
+      [MarshalAsAttribute(UnmanagedType.ByValArray, SizeConst = 16)]
+      public byte[] mUpgradePack;                  // coded upgrades
+
+      public float mBestPracticeTime;              // best practice time
+      public int mQualParticipantIndex;            // once qualifying begins, this becomes valid and ranks participants according to practice time if possible
+      [MarshalAsAttribute(UnmanagedType.ByValArray, SizeConst = 4)]
+      public float[] mQualificationTime;            // best qualification time in up to 4 qual sessions
+      [MarshalAsAttribute(UnmanagedType.ByValArray, SizeConst = 4)]
+      public float[] mFinalRacePlace;              // final race place in up to 4 race sessions
+      [MarshalAsAttribute(UnmanagedType.ByValArray, SizeConst = 4)]
+      public float[] mFinalRaceTime;               // final race time in up to 4 race sessions
+
+      // input/output
+      public byte mServerScored;                   // whether vehicle is allowed to participate in current session
+      public int mGridPosition;                    // 1-based grid position for current race session (or upcoming race session if it is currently warmup), or -1 if currently disconnected
+
+      // future expansion
+      [MarshalAsAttribute(UnmanagedType.ByValArray, SizeConst = 128)]
+      public byte[] mExpansion;
+    }
+
+
+    [StructLayout(LayoutKind.Sequential, CharSet = CharSet.Ansi, Pack = 4)]
+    public struct rF2MultiSessionRules
+    {
+      // input only
+      public int mSession;                         // current session (0=testday 1-4=practice 5-8=qual 9=warmup 10-13=race)
+      public int mSpecialSlotID;                   // slot ID of someone who just joined, or -2 requesting to update qual order, or -1 (default/general)
+      [MarshalAsAttribute(UnmanagedType.ByValArray, SizeConst = 32)]
+      public byte[] mTrackType;                    // track type from GDB
+      public int mNumParticipants;                 // number of participants (vehicles)
+
+      // input/output
+      // MM_NOT_USED
+      //MultiSessionParticipantV01 *mParticipant;       // array of partipants (vehicles)
+      // MM_NEW
+      [MarshalAsAttribute(UnmanagedType.ByValArray, SizeConst = 8)]
+      public byte[] pointer1;
+
+      public int mNumQualSessions;                 // number of qualifying sessions configured
+      public int mNumRaceSessions;                 // number of race sessions configured
+      public int mMaxLaps;                         // maximum laps allowed in current session (LONG_MAX = unlimited) (note: cannot currently edit in *race* sessions)
+      public int mMaxSeconds;                      // maximum time allowed in current session (LONG_MAX = unlimited) (note: cannot currently edit in *race* sessions)
+      [MarshalAsAttribute(UnmanagedType.ByValArray, SizeConst = 32)]
+      public byte[] mName;                         // untranslated name override for session (please use mixed case here, it should get uppercased if necessary)
+
+      // future expansion
+      [MarshalAsAttribute(UnmanagedType.ByValArray, SizeConst = 256)]
+      public byte[] mExpansion;
+    }
+
+
+    [StructLayout(LayoutKind.Sequential, CharSet = CharSet.Ansi, Pack = 4)]
+    public struct rF2PitMenu
+    {
+      public int mCategoryIndex;                   // index of the current category
+      [MarshalAsAttribute(UnmanagedType.ByValArray, SizeConst = 32)]
+      public byte[] mCategoryName;                 // name of the current category (untranslated)
+
+      public int mChoiceIndex;                     // index of the current choice (within the current category)
+      [MarshalAsAttribute(UnmanagedType.ByValArray, SizeConst = 32)]
+      public byte[] mChoiceString;                 // name of the current choice (may have some translated words)
+      public int mNumChoices;                      // total number of choices (0 <= mChoiceIndex < mNumChoices)
+
+      [MarshalAsAttribute(UnmanagedType.ByValArray, SizeConst = 256)]
+      public byte[] mExpansion;                    // for future use
+    }
+
+
+    // See rF2Rules in rF2State.h.
+    [StructLayout(LayoutKind.Sequential, CharSet = CharSet.Ansi, Pack = 4)]
+    public struct rF2Rules
+    {
+      public byte mCurrentRead;                          // True indicates buffer is safe to read under mutex.
+      public uint mSequence;                             // Odd while buffer is being written to, incremented on every write and publish.
+      public int mBytesUpdatedHint;                      // How many bytes of the structure were written during the last update.
+                                                         // 0 means unknown (whole buffer should be considered as updated).
+
+      public rF2TrackRules mTrackRules;
+      public ulong mNumActionsAppended;                  // Total number of actions passed by the game since plugin started.
+      [MarshalAsAttribute(UnmanagedType.ByValArray, SizeConst = rFactor2Constants.MAX_MAPPED_RULES_ACTIONS)]
+      public rF2TrackRulesAction[] mActions;             // Action N is in mActions[N % MAX_MAPPED_RULES_ACTIONS].
+      [MarshalAsAttribute(UnmanagedType.ByValArray, SizeConst = rFactor2Constants.MAX_MAPPED_VEHICLES)]
+      public rF2TrackRulesParticipant[] mParticipants;
+    }
+
+
+    // See rF2MultiRules in rF2State.h.
+    [StructLayout(LayoutKind.Sequential, Pack = 4)]
+    public struct rF2MultiRules
+    {
+      public uint mSequence;                             // Odd while buffer is being written to (see rF2MappedBufferHeader::mSequence).
+      public uint mGeneration;                           // Incremented each time rules change, 0 until AccessMultiSessionRules is first called.
+      public rF2MultiSessionRules mMultiSessionRules;
+      [MarshalAsAttribute(UnmanagedType.ByValArray, SizeConst = rFactor2Constants.MAX_MAPPED_VEHICLES)]
+      public rF2MultiSessionParticipant[] mParticipants; // First mMultiSessionRules.mNumParticipants entries are valid.
+    }
+
+
+    // See rF2PitInfo in rF2State.h.
+    [StructLayout(LayoutKind.Sequential, Pack = 4)]
+    public struct rF2PitInfo
+    {
+      public uint mSequence;                             // Odd while buffer is being written to (see rF2MappedBufferHeader::mSequence).
+      public uint mGeneration;                           // Incremented each time pit menu state changes, 0 until AccessPitMenu is first called.
+      public rF2PitMenu mPitMenu;
+    }
+
+
+    // See rF2Graphics in rF2State.h.
+    [StructLayout(LayoutKind.Sequential, Pack = 4)]
+    public struct rF2Graphics
+    {
+      public uint mSequence;                             // Odd while buffer is being written to (see rF2MappedBufferHeader::mSequence).
+      public uint mUpdateNumber;                         // Incremented on every graphics update, 0 until UpdateGraphics is first called.
+      public int mID;                                    // slot ID being viewed (-1 if invalid)
+      public int mCameraType;                            // see GraphicsInfoV02 comments for possible values
+      public rF2Vec3 mCamPos;                            // camera position
+      [MarshalAsAttribute(UnmanagedType.ByValArray, SizeConst = 3)]
+      public rF2Vec3[] mCamOri;                          // rows of orientation matrix (use TelemQuat conversions if desired), also converts local
+
+      [MarshalAsAttribute(UnmanagedType.ByValArray, SizeConst = 16)]
+      public byte[] mExpansion;                          // Pads buffer to two cache lines.
+    }
+
+
+    // See rF2PlayerTelemetry in rF2State.h.
+    [StructLayout(LayoutKind.Sequential, Pack = 4)]
+    public struct rF2PlayerTelemetry
+    {
+      public uint mSequence;                             // Odd while buffer is being written to (see rF2MappedBufferHeader::mSequence).
+      public uint mUpdateNumber;                         // Incremented on every publish, 0 until player telemetry is first published.
+      public double mPublishMicroseconds;                // Plugin clock at publish time (QueryPerformanceCounter based on Windows).
+      public rF2VehicleTelemetry mVehicle;
+    }
+
+
+    [StructLayout(LayoutKind.Sequential, Pack = 4)]
+    public struct rF2ForceFeedbackSample
+    {
+      public double mForceValue;                         // Force value as passed to ForceFeedback.
+      public double mMicroseconds;                       // Plugin clock at the call (same clock as rF2PlayerTelemetry.mPublishMicroseconds).
+    }
+
+
+    // See rF2ForceFeedback in rF2State.h for the layout and client protocol.
+    [StructLayout(LayoutKind.Sequential, Pack = 4)]
+    public struct rF2ForceFeedback
+    {
+      public const int MAX_SAMPLES = 4096;
+
+      public uint mSequence;                             // Odd while being appended to (see rF2MappedBufferHeader::mSequence).
+      public int mMaxSamples;                            // MAX_SAMPLES
+      public ulong mNumSamples;                          // Total number of samples appended since plugin started (next sample number).
+
+      [MarshalAsAttribute(UnmanagedType.ByValArray, SizeConst = rF2ForceFeedback.MAX_SAMPLES)]
+      public rF2ForceFeedbackSample[] mSamples;          // Sample N is in mSamples[N % MAX_SAMPLES].
+    }
+
+
+    // See rF2ControlCommand in rF2State.h.
+    [StructLayout(LayoutKind.Sequential, CharSet = CharSet.Ansi, Pack = 4)]
+    public struct rF2ControlCommand
+    {
+      public const int CONTROL_NAME_CHARS = 64;
+
+      public int mTicket;                                // Slot protocol counter (see rF2ControlInput).
+      [MarshalAsAttribute(UnmanagedType.ByValArray, SizeConst = rF2ControlCommand.CONTROL_NAME_CHARS)]
+      public byte[] mControlName;                        // Control name as game passes it to CheckHWControl (case insensitive).
+      public double mValue;                              // Value game gets for the control.
+      public int mFrames;                                // > 0: report that many times, 0: until next command for the control, < 0: release the control.
+    }
+
+
+    // See rF2ControlInput in rF2State.h for the producer protocol.
+    [StructLayout(LayoutKind.Sequential, Pack = 4)]
+    public struct rF2ControlInput
+    {
+      public const int MAX_COMMANDS = 64;
+
+      public int mEnqueuePosition;                       // Position of the next command.  Only producers change it.
+      public int mMaxCommands;                           // MAX_COMMANDS
+
+      [MarshalAsAttribute(UnmanagedType.ByValArray, SizeConst = rF2ControlInput.MAX_COMMANDS)]
+      public rF2ControlCommand[] mCommands;
+    }
+
+
+    // See rF2Weather in rF2State.h.
+    [StructLayout(LayoutKind.Sequential, Pack = 4)]
+    public struct rF2Weather
+    {
+      public uint mSequence;                             // Odd while buffer is being written to (see rF2MappedBufferHeader::mSequence).
+      public uint mGeneration;                           // Incremented each time weather changes, 0 until AccessWeather is first called.
+      public double mTrackNodeSize;                      // Distance between mRaining nodes (see rF2WeatherControlInfo::mRaining).
+      public rF2WeatherControlInfo mWeatherInfo;         // Changes to mET alone do not count, so mET is as of the latest change.
+    }
+
+
+    [StructLayout(LayoutKind.Sequential, Pack = 4)]
+    public struct rF2ResultsStreamChunk
+    {
+      public ulong mOffset;                              // Stream offset of the first byte of the chunk (text byte at offset O is mText[O % RING_BYTES]).
+      public uint mBytes;                                // Number of bytes stored.
+      public uint mBytesDropped;                         // Bytes of the update that did not fit into the ring (tail of the update).
+      public double mElapsedTime;                        // ET of the scoring update the chunk came with.
+    }
+
+
+    // See rF2ResultsStream in rF2State.h for the layout and client protocol.
+    [StructLayout(LayoutKind.Sequential, Pack = 4)]
+    public struct rF2ResultsStream
+    {
+      public const int RING_BYTES = 256 * 1024;
+      public const int MAX_CHUNKS = 512;
+
+      public uint mSequence;                             // Odd while being appended to (see rF2MappedBufferHeader::mSequence).
+      public int mRingBytes;                             // RING_BYTES
+      public int mMaxChunks;                             // MAX_CHUNKS
+      public ulong mWriteOffset;                         // Total bytes appended, stream offset of the next byte.
+      public ulong mNumChunks;                           // Total chunks appended, chunk number of the next chunk.
+
+      [MarshalAsAttribute(UnmanagedType.ByValArray, SizeConst = rF2ResultsStream.MAX_CHUNKS)]
+      public rF2ResultsStreamChunk[] mChunks;
+      [MarshalAsAttribute(UnmanagedType.ByValArray, SizeConst = rF2ResultsStream.RING_BYTES)]
+      public byte[] mText;
+    }
+
+
     [StructLayout(LayoutKind.Sequential, Pack = 4)]
     public struct rF2BufferHeader
     {
       internal byte mCurrentRead;                        // True indicates buffer is safe to read under mutex.
+      internal uint mSequence;                           // Odd while buffer is being written to, incremented on every write and publish.
     }
   }
 }
\ No newline at end of file
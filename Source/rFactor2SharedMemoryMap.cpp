@@ -16,12 +16,50 @@ Shared resources:
   Shared resources use the following naming convention:
     - $rFactor2SMMP_<BUFFER_TYPE>Buffer1$
     - $rFactor2SMMP_<BUFFER_TYPE>Buffer2$
-    - Global\$rFactor2SMMP_<BUFFER_TYPE>Mutex - mutex for optional weak synchronization (see Synchronization below)
+    - Global\$rFactor2SMMP_<BUFFER_TYPE>Mutex - mutex for optional weak synchronization (see Synchronization below).
+      Not created in Seqlock and MultiBuffer sync modes.
+    - $rFactor2SMMP_<BUFFER_TYPE>MultiBuffer$ - rF2MultiBufferControl followed by N buffers.  Used instead of the
+      files above in MultiBuffer sync mode.
+    - Global\$rFactor2SMMP_<BUFFER_TYPE>FlipEvent - named auto reset event signaled after each flip (see Flip notification
+      below).  Only created if flipNotification=1 is set in the configuration file.
+    - $rFactor2SMMP_TelemetryHistory$ - optional ring of the last N complete telemetry frames (see MappedHistoryRing.h).
+      Only created if telemetryHistoryFrames > 0 in the configuration file.
+    - $rFactor2SMMP_Stats$ - rF2Stats plugin health statistics: flips, retries, overwrites and mutex wait histograms of
+      each buffer type, telemetry frame assembly times, vehicles per frame and skipped duplicate ET updates.  Single
+      buffer updated in place after each telemetry frame and scoring update, validated with mSequence (see Seqlock.h).
+    - $rFactor2SMMP_ReaderRegistry$ - rF2ReaderRegistry slots where clients declare buffers they read and heartbeat (see
+      Reader registry below).  Only created if readerRegistry=1 is set in the configuration file.
+    - $rFactor2SMMP_RaceEvents$ - ring of discrete race events (see Race events below).  Only created if raceEvents=1 is
+      set in the configuration file.
+    - $rFactor2SMMP_ResultsStream$ - rF2ResultsStream text ring with mResultsStream additions of scoring updates (see
+      Results stream below).  Only created if resultsStream=1 is set in the configuration file.
+    - $rFactor2SMMP_Weather$ - rF2Weather node grid as passed to AccessWeather, rewritten only when it changes (see
+      Weather below).  Only created if weather=1 is set in the configuration file.
+    - $rFactor2SMMP_MultiRules$ - rF2MultiRules multi-session rules and participants as passed to
+      AccessMultiSessionRules, rewritten only when they change.  Only created if multiSessionRules=1 is set in the
+      configuration file.
+    - $rFactor2SMMP_PitInfo$ - rF2PitInfo pit menu state as passed to AccessPitMenu, rewritten only when it changes.
+      Only created if pitMenu=1 is set in the configuration file.
+    - $rFactor2SMMP_Graphics$ - rF2Graphics camera position, orientation, type and viewed slot, rewritten on every
+      graphics update (see Graphics below).  Only created if graphics=1 is set in the configuration file.
+    - $rFactor2SMMP_PlayerTelemetry$ - rF2PlayerTelemetry of the player vehicle, published as soon as its telemetry
+      arrives (see Player telemetry below).  Only created if playerTelemetry=1 is set in the configuration file.
+    - $rFactor2SMMP_ForceFeedback$ - rF2ForceFeedback ring of force values passed to ForceFeedback (see Force feedback
+      below).  Only created if forceFeedback=1 is set in the configuration file.
+    - $rFactor2SMMP_ControlInput$ - rF2ControlInput queue external processes post control values to (see Control
+      input below).  Only created if controlInput=1 is set in the configuration file.
 
   where <BUFFER_TYPE> is one of the following:
     * Telemetry - mapped view of rF2Telemetry structure
     * Scoring - mapped view of rF2Scoring structure
     * Extended - mapped view of rF2Extended structure
+    * Kinematics - mapped view of rF2Kinematics structure (position, velocity, orientation and lap distance of all
+      vehicles laid out column-wise, updated together with telemetry)
+    * LiteTelemetry - mapped view of rF2LiteTelemetry structure (tightly packed subset of telemetry fields selected by
+      liteTelemetryFields in the configuration file).  Only mapped if liteTelemetryFields is set, and sized to the
+      selected fields.
+    * Rules - mapped view of rF2Rules structure (track rules, recent actions and participants passed to
+      AccessTrackRules).  Only mapped if rules=1 is set in the configuration file.
 
   Those types are (with few exceptions) exact mirror of ISI structures, plugin constantly memcpy'es them from game to memory mapped files.
 
@@ -30,6 +68,8 @@ State updates (buffer flips, see Double Buffering):
   Telemetry - updated every 10ms, but in practice only every other update contains updated data, so real update rate is around 50FPS.
   Scoring - every 200ms (5FPS)
   Extended - every 200ms or on tracked function call.
+  Kinematics, LiteTelemetry - with every telemetry frame.  If buffer's mutex is signaled, frame is skipped.
+  Rules - on each AccessTrackRules call (formation and caution laps, right after scoring update).
 
   Plugin does not add artificial delays, except:
     - telemetry updates with same game time are skipped
@@ -40,6 +80,34 @@ Telemetry state:
   rF2 calls UpdateTelemetry for each vehicle.  Plugin tries to guess when all vehicles received an update, and only after that flip is attempted (see Double Buffering).
 
 
+Telemetry recording:
+  If telemetryRecorder=1 is set in the configuration file, every complete telemetry frame is also handed over to
+  a background thread, which compresses it and appends it to RF2SMMP_TelemetryRecording_<date>_<time>.rf2tr
+  (see TelemetryRecorder.h and TelemetryRecording.h for the format).  Simulation thread only copies the frame
+  into a preallocated queue slot; if the writer falls behind, frames are dropped rather than waited for.
+  New file is started for each session.  Use Tools\TelemetryRecordingDecoder.cpp to decode and verify recordings.
+
+
+Callback journal:
+  If callbackJournal=1 is set in the configuration file, every game callback plugin handles (lifecycle, telemetry,
+  scoring, physics options) is journaled with its raw arguments and a timestamp into
+  RF2SMMP_CallbackJournal_<date>_<time>.rf2cj (see CallbackJournal.h).  Tools\JournalReplay.cpp feeds journal back
+  into the plugin at recorded, scaled or maximum speed, which makes frame assembly issues and perf runs reproducible.
+
+
+Debug output:
+  DEBUG_* macros do not format or write on the calling (game) thread.  Between Startup and Shutdown, messages are
+  copied as binary records into per thread lock-free rings and formatted into RF2SMMP_DebugOutput.txt by a
+  background thread (see DebugLogger.h), with timestamps in seconds since Startup.  Outside of that window, and if
+  the logger fails to start, output is synchronous as before.
+
+
+Per vehicle change tracking:
+  Telemetry and scoring buffers carry update generation, mask of vehicle slots that changed since the previous publish
+  and generation at which each slot last changed (see rF2MappedVehicleBufferHeader).  Clients can use those to copy
+  only changed vehicles they care about, instead of the whole mBytesUpdatedHint prefix.
+
+
 Extended state:
   Exposed extended state consists of the two parts:
 
@@ -74,6 +142,106 @@ Synchronization:
   during telemetry updates (~90FPS) and only waiting for 1ms max during scoring updates (and on fourth telemetry flip retry), 
   before forcefully flipping buffers.  Also, if 1ms elapses on synchronized flip, buffer will be overwritten anyway.
 
+  Seqlock sync mode (syncMode=1 in the configuration file) replaces mutexes with per buffer sequence
+  counters (rF2MappedBufferHeader::mSequence), see Seqlock.h.  Plugin never waits in this mode, and clients
+  get guaranteed consistent copies by retrying until the counter is even and did not change during the copy.
+  Counters are maintained in the Mutex mode as well, so clients can validate copies either way.
+
+  MultiBuffer sync mode (syncMode=2) maps multiBufferCount (3 to 8) buffers per buffer type in a single file.
+  Clients register as readers of the latest buffer (see rF2MultiBufferControl), and plugin always writes to
+  a buffer nobody reads, so it neither waits nor retries, and readers are not racing the next frame.
+
+
+Reader registry:
+  If readerRegistry=1 is set in the configuration file, plugin only updates buffers that have a live registered reader
+  (see rF2ReaderRegistry for the client protocol and MappedReaderRegistry.h).  Registry is polled at the start of each
+  telemetry update chain and on each scoring update, which costs a few loads per slot.  Buffers nobody reads are
+  neither copied to nor flipped, resuming with the next telemetry frame (or scoring update) after a reader registers;
+  extended buffer is published right away.  Telemetry history and recorder keep telemetry frame assembly on.
+  Damage tracking and other extended state is maintained regardless.  Unregistered clients see stale buffers in this
+  mode, so it is meant for setups where all clients register, like unattended dedicated servers.
+
+
+Race events:
+  If raceEvents=1 is set in the configuration file, plugin appends discrete transitions (session start/end, realtime
+  enter/exit, game phase and yellow flag changes, vehicles joining and leaving, completed laps, pit entry/exit, place,
+  finish status, control and penalty changes, impacts) as fixed size rF2RaceEvent records to a 512 event ring (see
+  RaceEventTracker.h).  Clients keep the number of the last event they consumed and drain only newer ones, using the
+  same protocol as telemetry history (see MappedHistoryRing.h), instead of diffing scoring snapshots.  Event numbers
+  keep growing across sessions.  Events are detected regardless of the reader registry, because missed transitions
+  cannot be reconstructed later.
+
+
+Results stream:
+  rF2ScoringInfo does not expose ScoringInfoV01::mResultsStream (it is a pointer).  If resultsStream=1 is set in the
+  configuration file, text added to the results stream with each scoring update is appended, stamped with the update
+  ET, to a 256KB byte ring (see rF2ResultsStream and MappedTextRing.h).  Stream offsets and chunk numbers keep
+  growing, so clients copy only text after the last chunk they consumed.  Ring is bounded and plugin never waits:
+  clients that fall behind by more than the ring size lose the oldest text.
+
+
+Weather:
+  If weather=1 is set in the configuration file, plugin asks the game for weather access and copies
+  WeatherControlInfoV01 (rain at each node, cloudiness, ambient temperature, wind) along with the track node size into
+  rF2Weather.  Buffer is only rewritten when any of the values other than mET change, and each change increments
+  mGeneration, so clients can cache weather and copy it again only when mGeneration changes.  Plugin never changes
+  the weather.
+
+  Multi-session rules (multiSessionRules=1) and pit menu (pitMenu=1) are exposed the same way, in rF2MultiRules and
+  rF2PitInfo.  Game calls those rarely, and not from the telemetry path.
+
+
+Graphics:
+  If graphics=1 is set in the configuration file, plugin asks the game for graphics updates and copies camera position,
+  orientation, camera type and the slot ID being viewed into rF2Graphics on every UpdateGraphics call.  Those come from
+  the render thread at frame rate, so buffer is small (two cache lines), never uses mutex and is only published with
+  its sequence counter.  Overlays can follow camera cuts with frame latency, instead of guessing from scoring.
+
+
+Player telemetry:
+  Telemetry buffer is only flipped once all vehicles in the frame are collected, so on a full grid player vehicle data
+  waits for the whole update chain.  If playerTelemetry=1 is set in the configuration file, player vehicle telemetry
+  is also copied into rF2PlayerTelemetry and published right from its UpdateTelemetry call, stamped with the plugin
+  clock.  Motion rigs and shakers can read ~2KB instead of the whole rF2Telemetry, a frame earlier.  Game does not mark
+  player vehicle in telemetry, so mIsPlayer of the latest scoring update is used to find it.
+
+
+Force feedback:
+  Game calls ForceFeedback at physics rate, far more often than telemetry.  If forceFeedback=1 is set in the
+  configuration file, each value is appended, stamped with the plugin clock, to the rF2ForceFeedback sample ring (see
+  MappedSampleRing.h), so wheel base tuning and FFB analysis tools can see the full rate signal.  Append only touches
+  the ring and its sequence counter, and the value is never changed.
+
+
+Control input:
+  If controlInput=1 is set in the configuration file, plugin tells the game it has hardware inputs, and external
+  processes can post control name/value commands into rF2ControlInput (see the producer protocol there) instead of
+  injecting keystrokes through OS input APIs.  Queue is drained once a frame in UpdateHardware, and commands override
+  game controls from CheckHWControl for the requested number of frames (see MappedControlInput.h).  Drain of an empty
+  queue is a single load.
+
+
+Publisher thread:
+  By default, buffers are copied, flipped and extended state is updated inline, on whichever game thread invokes the
+  callback (simulation for telemetry and scoring, others for thread, session and physics notifications).  If
+  publisherThread=1 is set in the configuration file, telemetry, scoring, session, realtime, thread and physics
+  callbacks only copy their arguments into a preallocated queue and return (see CallbackPublisher.h and MpscRing.h).
+  Plugin thread then replays them in order through the same code, so all telemetry, scoring and extended buffer
+  writes happen on one thread, and mutex waits in Mutex sync mode never stall the game.  Callbacks that publish their
+  own small buffers (rules, weather, pit menu, graphics, force feedback, control input) stay inline, and so does
+  clearing of the rules buffer, and so does player telemetry, published before the vehicle is queued.  Buffers lag
+  the game by the queue hop: idle thread is woken by the game thread that queues the next callback.  If the thread
+  falls behind, whole telemetry frames and scoring updates are dropped and reported in the debug output.
+
+
+Flip notification:
+  If flipNotification=1 is set in the configuration file, plugin signals Global\$rFactor2SMMP_<BUFFER_TYPE>FlipEvent
+  after each flip of that buffer type (in all sync modes, after mutex is released).  Clients can wait on it (with
+  a timeout, in case game is paused or plugin stops) instead of polling mCurrentRead/mLatest, which keeps client CPU
+  near zero and wakes it as soon as data is published.  On POSIX builds, event is a process shared condition
+  variable in shared memory (see PlatformPosix.h).  Event is auto reset, so each signal wakes a single waiter:
+  intended for one waiting client per buffer type, other clients should keep polling.
+
 
 Configuration file:
   Optional configuration file is supported (primarily for debugging purposes).
@@ -94,10 +262,30 @@ static double const MICROSECONDS_IN_MILLISECOND = 1000.0;
 static double const MICROSECONDS_IN_SECOND = MILLISECONDS_IN_SECOND * MICROSECONDS_IN_MILLISECOND;
 
 DebugLevel SharedMemoryPlugin::msDebugOutputLevel = DebugLevel::Off;
+SyncMode SharedMemoryPlugin::msSyncMode = SyncMode::Mutex;
+int SharedMemoryPlugin::msMultiBufferCount = 3;
+int SharedMemoryPlugin::msTelemetryHistoryFrames = 0;
+char SharedMemoryPlugin::msLiteTelemetryFields[SharedMemoryPlugin::LITE_TELEMETRY_FIELDS_CHARS];
+bool SharedMemoryPlugin::msTelemetryRecorder = false;
+bool SharedMemoryPlugin::msCallbackJournal = false;
+bool SharedMemoryPlugin::msFlipNotification = false;
+bool SharedMemoryPlugin::msReaderRegistry = false;
+bool SharedMemoryPlugin::msRaceEvents = false;
+bool SharedMemoryPlugin::msResultsStream = false;
+bool SharedMemoryPlugin::msWeather = false;
+bool SharedMemoryPlugin::msRules = false;
+bool SharedMemoryPlugin::msMultiSessionRules = false;
+bool SharedMemoryPlugin::msPitMenu = false;
+bool SharedMemoryPlugin::msGraphics = false;
+bool SharedMemoryPlugin::msPlayerTelemetry = false;
+bool SharedMemoryPlugin::msForceFeedback = false;
+bool SharedMemoryPlugin::msControlInput = false;
+bool SharedMemoryPlugin::msPublisherThread = false;
 bool SharedMemoryPlugin::msDebugISIInternals = false;
 DWORD SharedMemoryPlugin::msMillisMutexWait = 1;
 
 FILE* SharedMemoryPlugin::msDebugFile;
+DebugLogger SharedMemoryPlugin::msDebugLogger;
 FILE* SharedMemoryPlugin::msIsiTelemetryFile;
 FILE* SharedMemoryPlugin::msIsiScoringFile;
 
@@ -110,14 +298,51 @@ FILE* SharedMemoryPlugin::msIsiScoringFile;
 char const* const SharedMemoryPlugin::MM_TELEMETRY_FILE_NAME1 = "$rFactor2SMMP_TelemetryBuffer1$";
 char const* const SharedMemoryPlugin::MM_TELEMETRY_FILE_NAME2 = "$rFactor2SMMP_TelemetryBuffer2$";
 char const* const SharedMemoryPlugin::MM_TELEMETRY_FILE_ACCESS_MUTEX = R"(Global\$rFactor2SMMP_TelemeteryMutex)";
+char const* const SharedMemoryPlugin::MM_TELEMETRY_MULTI_BUFFER_FILE_NAME = "$rFactor2SMMP_TelemetryMultiBuffer$";
+char const* const SharedMemoryPlugin::MM_TELEMETRY_FLIP_EVENT_NAME = R"(Global\$rFactor2SMMP_TelemetryFlipEvent)";
+char const* const SharedMemoryPlugin::MM_TELEMETRY_HISTORY_FILE_NAME = "$rFactor2SMMP_TelemetryHistory$";
 
 char const* const SharedMemoryPlugin::MM_SCORING_FILE_NAME1 = "$rFactor2SMMP_ScoringBuffer1$";
 char const* const SharedMemoryPlugin::MM_SCORING_FILE_NAME2 = "$rFactor2SMMP_ScoringBuffer2$";
 char const* const SharedMemoryPlugin::MM_SCORING_FILE_ACCESS_MUTEX = R"(Global\$rFactor2SMMP_ScoringMutex)";
+char const* const SharedMemoryPlugin::MM_SCORING_MULTI_BUFFER_FILE_NAME = "$rFactor2SMMP_ScoringMultiBuffer$";
+char const* const SharedMemoryPlugin::MM_SCORING_FLIP_EVENT_NAME = R"(Global\$rFactor2SMMP_ScoringFlipEvent)";
 
 char const* const SharedMemoryPlugin::MM_EXTENDED_FILE_NAME1 = "$rFactor2SMMP_ExtendedBuffer1$";
 char const* const SharedMemoryPlugin::MM_EXTENDED_FILE_NAME2 = "$rFactor2SMMP_ExtendedBuffer2$";
 char const* const SharedMemoryPlugin::MM_EXTENDED_FILE_ACCESS_MUTEX = R"(Global\$rFactor2SMMP_ExtendedMutex)";
+char const* const SharedMemoryPlugin::MM_EXTENDED_MULTI_BUFFER_FILE_NAME = "$rFactor2SMMP_ExtendedMultiBuffer$";
+char const* const SharedMemoryPlugin::MM_EXTENDED_FLIP_EVENT_NAME = R"(Global\$rFactor2SMMP_ExtendedFlipEvent)";
+
+char const* const SharedMemoryPlugin::MM_KINEMATICS_FILE_NAME1 = "$rFactor2SMMP_KinematicsBuffer1$";
+char const* const SharedMemoryPlugin::MM_KINEMATICS_FILE_NAME2 = "$rFactor2SMMP_KinematicsBuffer2$";
+char const* const SharedMemoryPlugin::MM_KINEMATICS_FILE_ACCESS_MUTEX = R"(Global\$rFactor2SMMP_KinematicsMutex)";
+char const* const SharedMemoryPlugin::MM_KINEMATICS_MULTI_BUFFER_FILE_NAME = "$rFactor2SMMP_KinematicsMultiBuffer$";
+char const* const SharedMemoryPlugin::MM_KINEMATICS_FLIP_EVENT_NAME = R"(Global\$rFactor2SMMP_KinematicsFlipEvent)";
+
+char const* const SharedMemoryPlugin::MM_LITE_TELEMETRY_FILE_NAME1 = "$rFactor2SMMP_LiteTelemetryBuffer1$";
+char const* const SharedMemoryPlugin::MM_LITE_TELEMETRY_FILE_NAME2 = "$rFactor2SMMP_LiteTelemetryBuffer2$";
+char const* const SharedMemoryPlugin::MM_LITE_TELEMETRY_FILE_ACCESS_MUTEX = R"(Global\$rFactor2SMMP_LiteTelemetryMutex)";
+char const* const SharedMemoryPlugin::MM_LITE_TELEMETRY_MULTI_BUFFER_FILE_NAME = "$rFactor2SMMP_LiteTelemetryMultiBuffer$";
+char const* const SharedMemoryPlugin::MM_LITE_TELEMETRY_FLIP_EVENT_NAME = R"(Global\$rFactor2SMMP_LiteTelemetryFlipEvent)";
+
+char const* const SharedMemoryPlugin::MM_RULES_FILE_NAME1 = "$rFactor2SMMP_RulesBuffer1$";
+char const* const SharedMemoryPlugin::MM_RULES_FILE_NAME2 = "$rFactor2SMMP_RulesBuffer2$";
+char const* const SharedMemoryPlugin::MM_RULES_FILE_ACCESS_MUTEX = R"(Global\$rFactor2SMMP_RulesMutex)";
+char const* const SharedMemoryPlugin::MM_RULES_MULTI_BUFFER_FILE_NAME = "$rFactor2SMMP_RulesMultiBuffer$";
+char const* const SharedMemoryPlugin::MM_RULES_FLIP_EVENT_NAME = R"(Global\$rFactor2SMMP_RulesFlipEvent)";
+
+char const* const SharedMemoryPlugin::MM_STATS_FILE_NAME = "$rFactor2SMMP_Stats$";
+char const* const SharedMemoryPlugin::MM_READER_REGISTRY_FILE_NAME = "$rFactor2SMMP_ReaderRegistry$";
+char const* const SharedMemoryPlugin::MM_RACE_EVENTS_FILE_NAME = "$rFactor2SMMP_RaceEvents$";
+char const* const SharedMemoryPlugin::MM_RESULTS_STREAM_FILE_NAME = "$rFactor2SMMP_ResultsStream$";
+char const* const SharedMemoryPlugin::MM_WEATHER_FILE_NAME = "$rFactor2SMMP_Weather$";
+char const* const SharedMemoryPlugin::MM_MULTI_RULES_FILE_NAME = "$rFactor2SMMP_MultiRules$";
+char const* const SharedMemoryPlugin::MM_PIT_INFO_FILE_NAME = "$rFactor2SMMP_PitInfo$";
+char const* const SharedMemoryPlugin::MM_GRAPHICS_FILE_NAME = "$rFactor2SMMP_Graphics$";
+char const* const SharedMemoryPlugin::MM_PLAYER_TELEMETRY_FILE_NAME = "$rFactor2SMMP_PlayerTelemetry$";
+char const* const SharedMemoryPlugin::MM_FORCE_FEEDBACK_FILE_NAME = "$rFactor2SMMP_ForceFeedback$";
+char const* const SharedMemoryPlugin::MM_CONTROL_INPUT_FILE_NAME = "$rFactor2SMMP_ControlInput$";
 
 char const* const SharedMemoryPlugin::CONFIG_FILE_REL_PATH = R"(\UserData\player\rf2smmp.ini)";  // Relative to rF2 root.
 char const* const SharedMemoryPlugin::INTERNALS_TELEMETRY_FILENAME = "RF2SMMP_InternalsTelemetryOutput.txt";
@@ -149,23 +374,80 @@ SharedMemoryPlugin::SharedMemoryPlugin()
   : mTelemetry(SharedMemoryPlugin::MAX_ASYNC_RETRIES
      , SharedMemoryPlugin::MM_TELEMETRY_FILE_NAME1
      , SharedMemoryPlugin::MM_TELEMETRY_FILE_NAME2
-     , SharedMemoryPlugin::MM_TELEMETRY_FILE_ACCESS_MUTEX),
+     , SharedMemoryPlugin::MM_TELEMETRY_FILE_ACCESS_MUTEX
+     , SharedMemoryPlugin::MM_TELEMETRY_MULTI_BUFFER_FILE_NAME
+     , SharedMemoryPlugin::MM_TELEMETRY_FLIP_EVENT_NAME),
     mScoring(0 /*maxRetries*/
       , SharedMemoryPlugin::MM_SCORING_FILE_NAME1
       , SharedMemoryPlugin::MM_SCORING_FILE_NAME2
-      , SharedMemoryPlugin::MM_SCORING_FILE_ACCESS_MUTEX),
+      , SharedMemoryPlugin::MM_SCORING_FILE_ACCESS_MUTEX
+      , SharedMemoryPlugin::MM_SCORING_MULTI_BUFFER_FILE_NAME
+      , SharedMemoryPlugin::MM_SCORING_FLIP_EVENT_NAME),
     mExtended(0 /*maxRetries*/
       , SharedMemoryPlugin::MM_EXTENDED_FILE_NAME1
       , SharedMemoryPlugin::MM_EXTENDED_FILE_NAME2
-      , SharedMemoryPlugin::MM_EXTENDED_FILE_ACCESS_MUTEX)
+      , SharedMemoryPlugin::MM_EXTENDED_FILE_ACCESS_MUTEX
+      , SharedMemoryPlugin::MM_EXTENDED_MULTI_BUFFER_FILE_NAME
+      , SharedMemoryPlugin::MM_EXTENDED_FLIP_EVENT_NAME),
+    mKinematics(0 /*maxRetries*/
+      , SharedMemoryPlugin::MM_KINEMATICS_FILE_NAME1
+      , SharedMemoryPlugin::MM_KINEMATICS_FILE_NAME2
+      , SharedMemoryPlugin::MM_KINEMATICS_FILE_ACCESS_MUTEX
+      , SharedMemoryPlugin::MM_KINEMATICS_MULTI_BUFFER_FILE_NAME
+      , SharedMemoryPlugin::MM_KINEMATICS_FLIP_EVENT_NAME),
+    mLiteTelemetry(0 /*maxRetries*/
+      , SharedMemoryPlugin::MM_LITE_TELEMETRY_FILE_NAME1
+      , SharedMemoryPlugin::MM_LITE_TELEMETRY_FILE_NAME2
+      , SharedMemoryPlugin::MM_LITE_TELEMETRY_FILE_ACCESS_MUTEX
+      , SharedMemoryPlugin::MM_LITE_TELEMETRY_MULTI_BUFFER_FILE_NAME
+      , SharedMemoryPlugin::MM_LITE_TELEMETRY_FLIP_EVENT_NAME),
+    mRules(0 /*maxRetries*/
+      , SharedMemoryPlugin::MM_RULES_FILE_NAME1
+      , SharedMemoryPlugin::MM_RULES_FILE_NAME2
+      , SharedMemoryPlugin::MM_RULES_FILE_ACCESS_MUTEX
+      , SharedMemoryPlugin::MM_RULES_MULTI_BUFFER_FILE_NAME
+      , SharedMemoryPlugin::MM_RULES_FLIP_EVENT_NAME),
+    mTelemetryHistory(SharedMemoryPlugin::MM_TELEMETRY_HISTORY_FILE_NAME),
+    mRaceEvents(SharedMemoryPlugin::MM_RACE_EVENTS_FILE_NAME),
+    mResultsStream(SharedMemoryPlugin::MM_RESULTS_STREAM_FILE_NAME),
+    mWeather(SharedMemoryPlugin::MM_WEATHER_FILE_NAME),
+    mMultiRules(SharedMemoryPlugin::MM_MULTI_RULES_FILE_NAME),
+    mPitInfo(SharedMemoryPlugin::MM_PIT_INFO_FILE_NAME),
+    mGraphics(SharedMemoryPlugin::MM_GRAPHICS_FILE_NAME),
+    mPlayerTelemetry(SharedMemoryPlugin::MM_PLAYER_TELEMETRY_FILE_NAME),
+    mForceFeedback(SharedMemoryPlugin::MM_FORCE_FEEDBACK_FILE_NAME),
+    mControlInput(SharedMemoryPlugin::MM_CONTROL_INPUT_FILE_NAME),
+    mStats(SharedMemoryPlugin::MM_STATS_FILE_NAME),
+    mReaderRegistry(SharedMemoryPlugin::MM_READER_REGISTRY_FILE_NAME),
+    mReadBuffersMask(static_cast<unsigned int>(rF2ReaderBuffer::All))
 {}
 
 
 void SharedMemoryPlugin::Startup(long version)
 {
+  // Before any of the worker threads are started.
+  Platform::InitializeClock();
+
   // Read configuration .ini if there's one.
   LoadConfig();
 
+  // From here on, debug output is formatted and written by the logger thread.
+  if (SharedMemoryPlugin::msDebugOutputLevel != DebugLevel::Off) {
+    OpenDebugFile();
+    if (!msDebugLogger.Start(msDebugFile))
+      DEBUG_MSG(DebugLevel::Errors, "Failed to start debug logger, debug output is synchronous");
+  }
+
+  if (SharedMemoryPlugin::msCallbackJournal) {
+    if (mCallbackJournal.Open())
+      DEBUG_MSG2(DebugLevel::Errors, "Callback journal opened:", mCallbackJournal.FileName());
+    else
+      DEBUG_MSG(DebugLevel::Errors, "Failed to open callback journal");
+  }
+
+  if (mCallbackJournal.IsOpen())
+    mCallbackJournal.WriteEvent(CallbackJournal::EventType::Startup, static_cast<int>(version));
+
   char temp[80] = {};
   sprintf(temp, "-STARTUP- (version %.3f)", (float)version / 1000.0f);
   WriteToAllExampleOutputFiles("w", temp);
@@ -185,10 +467,98 @@ void SharedMemoryPlugin::Startup(long version)
     return;
   }
 
+  if (!mKinematics.Initialize()) {
+    DEBUG_MSG(DebugLevel::Errors, "Failed to initialize kinematics mapping");
+    return;
+  }
+
+  // Statistics are optional, plugin works without them.
+  if (!mStats.Initialize())
+    DEBUG_MSG(DebugLevel::Errors, "Failed to initialize stats mapping");
+
+  // Without the registry, all buffers are updated as if read.
+  mReadBuffersMask.store(static_cast<unsigned int>(rF2ReaderBuffer::All));
+  if (SharedMemoryPlugin::msReaderRegistry) {
+    if (mReaderRegistry.Initialize()) {
+      mReadBuffersMask.store(mReaderRegistry.Poll(Platform::TickCountMillis()));
+      DEBUG_INT2(DebugLevel::Errors, "Reader registry mapped, live readers:", static_cast<int>(mReaderRegistry.LiveReaders()));
+    }
+    else
+      DEBUG_MSG(DebugLevel::Errors, "Failed to initialize reader registry mapping, all buffers will be updated");
+  }
+
+  mTelemetryChainReadMask = mReadBuffersMask.load();
+
+  // History is optional, plugin works without it.
+  if (SharedMemoryPlugin::msTelemetryHistoryFrames > 0
+    && !mTelemetryHistory.Initialize(SharedMemoryPlugin::msTelemetryHistoryFrames))
+    DEBUG_MSG(DebugLevel::Errors, "Failed to initialize telemetry history mapping");
+
+  // And race events.
+  if (SharedMemoryPlugin::msRaceEvents
+    && !mRaceEvents.Initialize(MappedHistoryRing<rF2RaceEvents, rF2RaceEvent>::MAX_FRAMES))
+    DEBUG_MSG(DebugLevel::Errors, "Failed to initialize race events mapping");
+
+  // And results stream.
+  if (SharedMemoryPlugin::msResultsStream && !mResultsStream.Initialize())
+    DEBUG_MSG(DebugLevel::Errors, "Failed to initialize results stream mapping");
+
+  // And rules.
+  mRulesActions = {};
+  if (SharedMemoryPlugin::msRules && !mRules.Initialize())
+    DEBUG_MSG(DebugLevel::Errors, "Failed to initialize rules mapping");
+
+  // And weather.
+  mWeatherState = {};
+  if (SharedMemoryPlugin::msWeather && !mWeather.Initialize())
+    DEBUG_MSG(DebugLevel::Errors, "Failed to initialize weather mapping");
+
+  // And multi-session rules and pit menu.
+  memset(&mMultiRulesState, 0, sizeof(mMultiRulesState));
+  if (SharedMemoryPlugin::msMultiSessionRules && !mMultiRules.Initialize())
+    DEBUG_MSG(DebugLevel::Errors, "Failed to initialize multi-session rules mapping");
+
+  mPitInfoState = {};
+  if (SharedMemoryPlugin::msPitMenu && !mPitInfo.Initialize())
+    DEBUG_MSG(DebugLevel::Errors, "Failed to initialize pit info mapping");
+
+  mGraphicsState = {};
+  if (SharedMemoryPlugin::msGraphics && !mGraphics.Initialize())
+    DEBUG_MSG(DebugLevel::Errors, "Failed to initialize graphics mapping");
+
+  if (SharedMemoryPlugin::msPlayerTelemetry && !mPlayerTelemetry.Initialize())
+    DEBUG_MSG(DebugLevel::Errors, "Failed to initialize player telemetry mapping");
+
+  if (SharedMemoryPlugin::msForceFeedback && !mForceFeedback.Initialize())
+    DEBUG_MSG(DebugLevel::Errors, "Failed to initialize force feedback mapping");
+
+  if (SharedMemoryPlugin::msControlInput && !mControlInput.Initialize())
+    DEBUG_MSG(DebugLevel::Errors, "Failed to initialize control input mapping");
+
+  // Lite telemetry is optional as well.
+  if (SharedMemoryPlugin::msLiteTelemetryFields[0] != '\0')
+    LiteTelemetryInitialize();
+
+  // So is the recorder.
+  if (SharedMemoryPlugin::msTelemetryRecorder) {
+    if (mTelemetryRecorder.Start())
+      DEBUG_MSG(DebugLevel::Errors, "Telemetry recorder started");
+    else
+      DEBUG_MSG(DebugLevel::Errors, "Failed to start telemetry recorder");
+  }
+
   mIsMapped = true;
 
   ClearState();
 
+  // From here on, callbacks are published by the plugin thread.
+  if (SharedMemoryPlugin::msPublisherThread) {
+    if (mCallbackPublisher.Start(SharedMemoryPlugin::PublisherHandleRecord, this))
+      DEBUG_MSG(DebugLevel::Errors, "Publisher thread started");
+    else
+      DEBUG_MSG(DebugLevel::Errors, "Failed to start publisher thread, callbacks are published inline");
+  }
+
   DEBUG_MSG(DebugLevel::Errors, "Files mapped successfully");
   if (SharedMemoryPlugin::msDebugOutputLevel != DebugLevel::Off) {
     char sizeSz[20] = {};
@@ -209,15 +579,44 @@ void SharedMemoryPlugin::Startup(long version)
     size = static_cast<int>(sizeof(rF2Extended));
     _itoa_s(size, sizeSz, 10);
     DEBUG_MSG3(DebugLevel::Errors, "Size of extended buffers:", sizeSz, "bytes each.");
+
+    sizeSz[0] = '\0';
+    size = static_cast<int>(sizeof(rF2Kinematics));
+    _itoa_s(size, sizeSz, 10);
+    DEBUG_MSG3(DebugLevel::Errors, "Size of kinematics buffers:", sizeSz, "bytes each.");
   }
 }
 
 void SharedMemoryPlugin::Shutdown()
 {
+  // Publishes queued callbacks, so do it before anything is closed or unmapped.
+  if (mCallbackPublisher.IsRunning()) {
+    mCallbackPublisher.Stop();
+    PublisherTraceDrops();
+  }
+
   WriteToAllExampleOutputFiles("a", "-SHUTDOWN-");
 
   DEBUG_MSG(DebugLevel::Errors, "Shutting down");
 
+  if (SharedMemoryPlugin::msCallbackJournal) {
+    mCallbackJournal.WriteEvent(CallbackJournal::EventType::Shutdown);
+    mCallbackJournal.Close();
+    DEBUG_INT2(DebugLevel::Errors, "Callback journal closed, write errors:", static_cast<int>(mCallbackJournal.WriteErrors()));
+  }
+
+  // Drains the queue, so do it before debug output is closed.
+  if (mTelemetryRecorder.IsRunning()) {
+    mTelemetryRecorder.Stop();
+    TelemetryRecorderTraceStats();
+  }
+
+  // Writes out queued messages.  Remaining output is synchronous.
+  if (msDebugLogger.IsRunning()) {
+    msDebugLogger.Stop();
+    DEBUG_INT2(DebugLevel::Errors, "Debug logger stopped, messages dropped:", static_cast<int>(msDebugLogger.Dropped()));
+  }
+
   if (msDebugFile != nullptr) {
     fclose(msDebugFile);
     msDebugFile = nullptr;
@@ -242,6 +641,45 @@ void SharedMemoryPlugin::Shutdown()
   mExtended.ClearState(nullptr /*pInitialContents*/);
   mExtended.ReleaseResources();
 
+  mKinematics.ClearState(nullptr /*pInitialContents*/);
+  mKinematics.ReleaseResources();
+
+  if (mLiteTelemetry.IsMapped())
+    mLiteTelemetry.ClearState(nullptr /*pInitialContents*/);
+
+  mLiteTelemetry.ReleaseResources();
+
+  if (mRules.IsMapped())
+    mRules.ClearState(nullptr /*pInitialContents*/);
+
+  mRules.ReleaseResources();
+
+  mTelemetryHistory.ReleaseResources();
+
+  mRaceEvents.ReleaseResources();
+
+  mResultsStream.ReleaseResources();
+
+  mWeather.ReleaseResources();
+
+  mMultiRules.ReleaseResources();
+
+  mPitInfo.ReleaseResources();
+
+  mGraphics.ReleaseResources();
+
+  mPlayerTelemetry.ReleaseResources();
+
+  mForceFeedback.ReleaseResources();
+
+  mControlInput.ReleaseResources();
+
+  mStats.ReleaseResources();
+
+  mReaderRegistry.ReleaseResources();
+  mReadBuffersMask.store(static_cast<unsigned int>(rF2ReaderBuffer::All));
+  mTelemetryChainReadMask = mReadBuffersMask.load();
+
   mIsMapped = false;
 }
 
@@ -259,6 +697,8 @@ void SharedMemoryPlugin::ClearTimingsAndCounters()
   memset(mParticipantTelemetryUpdated, 0, sizeof(mParticipantTelemetryUpdated));
 
   mScoringNumVehicles = 0;
+  memset(mScoringLapDist, 0, sizeof(mScoringLapDist));
+  mScoringPlayerID = -1L;
 }
 
 
@@ -270,26 +710,78 @@ void SharedMemoryPlugin::ClearState()
   mTelemetry.ClearState(nullptr /*pInitialContents*/);
   mScoring.ClearState(nullptr /*pInitialContents*/);
 
+  mTelemetryUpdateTracker.Reset();
+  mScoringUpdateTracker.Reset();
+
+  // Next scoring update establishes new baseline.
+  mRaceEventTracker.Reset();
+
   // Certain members of extended state persist between restarts/sessions.
   // So, clear the state but pass persisting state as initial state.
   mExtStateTracker.ClearState();
   mExtended.ClearState(&(mExtStateTracker.mExtended));
 
+  mKinematics.ClearState(nullptr /*pInitialContents*/);
+
+  if (mLiteTelemetry.IsMapped())
+    mLiteTelemetry.ClearState(&mLiteTelemetryLayout, static_cast<int>(sizeof(rF2LiteTelemetryHeader)));
+
+  // With the publisher thread, rules are cleared on the game thread, which also calls AccessTrackRules.
+  if (!mCallbackPublisher.IsRunning())
+    RulesClearState();
+
   ClearTimingsAndCounters();
 }
 
 void SharedMemoryPlugin::StartSession()
 {
+  if (JournalsCallbacks())
+    mCallbackJournal.WriteEvent(CallbackJournal::EventType::StartSession);
+
+  if (PublisherQueues()) {
+    RulesClearState();
+    mSubmittedPlayerID = -1L;
+
+    if (!mCallbackPublisher.SubmitEvent(CallbackPublisher::Kind::StartSession))
+      DEBUG_MSG(DebugLevel::Warnings, "WARNING: Publisher queue is full, StartSession dropped.");
+
+    return;
+  }
+
   WriteToAllExampleOutputFiles("a", "--STARTSESSION--");
 
   ClearState();
+
+  RaceEventTracker::Add(mRaceEvents, rF2RaceEventType::SessionStarted, 0.0 /*elapsedTime*/, -1L, 0L, 0L, 0.0);
 }
 
 
 void SharedMemoryPlugin::EndSession()
 {
+  if (JournalsCallbacks())
+    mCallbackJournal.WriteEvent(CallbackJournal::EventType::EndSession);
+
+  if (PublisherQueues()) {
+    RulesClearState();
+    mSubmittedPlayerID = -1L;
+
+    if (!mCallbackPublisher.SubmitEvent(CallbackPublisher::Kind::EndSession))
+      DEBUG_MSG(DebugLevel::Warnings, "WARNING: Publisher queue is full, EndSession dropped.");
+
+    return;
+  }
+
   WriteToAllExampleOutputFiles("a", "--ENDSESSION--");
 
+  if (mTelemetryRecorder.IsRunning()) {
+    if (!mTelemetryRecorder.EndSession())
+      DEBUG_MSG(DebugLevel::Warnings, "WARNING: Telemetry recorder queue is full, recording continues into the same file.");
+
+    TelemetryRecorderTraceStats();
+  }
+
+  RaceEventTracker::Add(mRaceEvents, rF2RaceEventType::SessionEnded, mLastScoringUpdateET, -1L, 0L, 0L, 0.0);
+
   ClearState();
 }
 
@@ -302,13 +794,25 @@ void SharedMemoryPlugin::UpdateInRealtimeFC(bool inRealTime)
   DEBUG_MSG(DebugLevel::Synchronization, inRealTime ? "Entering Realtime" : "Exiting Realtime");
 
   mExtStateTracker.mExtended.mInRealtimeFC = inRealTime;
-  memcpy(mExtended.mpCurWriteBuf, &(mExtStateTracker.mExtended), sizeof(rF2Extended));
-  mExtended.FlipBuffers();
+  ExtendedFlipBuffers();
+
+  RaceEventTracker::Add(mRaceEvents, inRealTime ? rF2RaceEventType::RealtimeEntered : rF2RaceEventType::RealtimeExited,
+    mLastScoringUpdateET, -1L, 0L, 0L, 0.0);
 }
 
 
 void SharedMemoryPlugin::EnterRealtime()
 {
+  if (JournalsCallbacks())
+    mCallbackJournal.WriteEvent(CallbackJournal::EventType::EnterRealtime);
+
+  if (PublisherQueues()) {
+    if (!mCallbackPublisher.SubmitEvent(CallbackPublisher::Kind::EnterRealtime))
+      DEBUG_MSG(DebugLevel::Warnings, "WARNING: Publisher queue is full, EnterRealtime dropped.");
+
+    return;
+  }
+
   // start up timer every time we enter realtime
   WriteToAllExampleOutputFiles("a", "---ENTERREALTIME---");
 
@@ -318,6 +822,16 @@ void SharedMemoryPlugin::EnterRealtime()
 
 void SharedMemoryPlugin::ExitRealtime()
 {
+  if (JournalsCallbacks())
+    mCallbackJournal.WriteEvent(CallbackJournal::EventType::ExitRealtime);
+
+  if (PublisherQueues()) {
+    if (!mCallbackPublisher.SubmitEvent(CallbackPublisher::Kind::ExitRealtime))
+      DEBUG_MSG(DebugLevel::Warnings, "WARNING: Publisher queue is full, ExitRealtime dropped.");
+
+    return;
+  }
+
   WriteToAllExampleOutputFiles("a", "---EXITREALTIME---");
 
   UpdateInRealtimeFC(false /*inRealtime*/);
@@ -329,20 +843,9 @@ void SharedMemoryPlugin::ExitRealtime()
 #define USE_QPC
 double TicksNow() {
 #ifdef USE_QPC
-  static double frequencyMicrosecond = 0.0;
-  static bool once = false;
-  if (!once) {
-    LARGE_INTEGER qpcFrequency = {};
-    QueryPerformanceFrequency(&qpcFrequency);
-    frequencyMicrosecond = static_cast<double>(qpcFrequency.QuadPart) / MICROSECONDS_IN_SECOND;
-    once = true;
-  }
-
-  LARGE_INTEGER now = {};
-  QueryPerformanceCounter(&now);
-  return static_cast<double>(now.QuadPart) / frequencyMicrosecond;
+  return Platform::TicksMicroseconds();
 #else 
-  return GetTickCount64() * MICROSECONDS_IN_MILLISECOND;
+  return Platform::TickCountMillis() * MICROSECONDS_IN_MILLISECOND;
 #endif
 }
 
@@ -421,7 +924,12 @@ void SharedMemoryPlugin::TelemetryTraceEndUpdate(int numVehiclesInChain) const
 
 void SharedMemoryPlugin::TelemetryFlipBuffers()
 {
-  if (mLastTelemetryUpdateET <= mLastScoringUpdateET) {
+  if (msSyncMode != SyncMode::Mutex) {
+    // Flip never waits without mutex, so there's nothing to retry.
+    DEBUG_MSG(DebugLevel::Timing, "TELEMETRY - Buffer flip succeeded.");
+    mTelemetry.FlipBuffers();
+  }
+  else if (mLastTelemetryUpdateET <= mLastScoringUpdateET) {
     // If scoring update is ahead of this telemetry update, force flip.
     DEBUG_MSG(DebugLevel::Synchronization, "TELEMETRY - Force flip due to: mLastTelemetryUpdateET <= mLastScoringUpdateET.");
     mTelemetry.FlipBuffers();
@@ -447,6 +955,35 @@ void SharedMemoryPlugin::TelemetryFlipBuffers()
     DEBUG_MSG(DebugLevel::Synchronization, "TELEMETRY - Force flip due to retry limit exceeded.");
     mTelemetry.FlipBuffers();
   }
+
+  // Generation written by the publish becomes current only once clients can see it.
+  if (!mTelemetry.RetryPending())
+    mTelemetryUpdateTracker.Commit();
+}
+
+
+void SharedMemoryPlugin::TelemetryAddHistoryFrame()
+{
+  if (!mTelemetryHistory.IsMapped())
+    return;
+
+  // Frame is complete, but not published yet.  Only copy the part that was updated.
+  auto const pSlot = mTelemetryHistory.BeginFrame(mLastTelemetryUpdateET);
+  memcpy(&(pSlot->mTelemetry), mTelemetry.mpCurWriteBuf, mTelemetry.mpCurWriteBuf->mBytesUpdatedHint);
+  mTelemetryHistory.EndFrame(pSlot);
+}
+
+
+// Publisher thread.  Rest of the update chain was dropped, so vehicles assembled so far are never flipped.  Write
+// buffers are simply overwritten by the next chain.
+void SharedMemoryPlugin::TelemetryDiscardChain()
+{
+  if (mTelemetryUpdateInProgress)
+    DEBUG_INT2(DebugLevel::Synchronization, "TELEMETRY - Update chain dropped by publisher after:", mCurTelemetryVehicleIndex);
+
+  mTelemetryUpdateInProgress = false;
+  mCurTelemetryVehicleIndex = 0;
+  memset(mParticipantTelemetryUpdated, 0, sizeof(mParticipantTelemetryUpdated));
 }
 
 
@@ -464,6 +1001,21 @@ Note that I am seeing different ET for vehicles in frame (typically no more than
 */
 void SharedMemoryPlugin::UpdateTelemetry(TelemInfoV01 const& info)
 {
+  if (JournalsCallbacks())
+    mCallbackJournal.WriteTelemetry(info);
+
+  // Dropped updates are reported by the publisher thread.
+  if (PublisherQueues()) {
+    // Player vehicle goes out right away, instead of waiting behind the queued frames.
+    if (info.mID == mSubmittedPlayerID
+      && mPlayerTelemetry.IsMapped()
+      && IsBufferRead(mReadBuffersMask.load(), rF2ReaderBuffer::PlayerTelemetry))
+      PlayerTelemetryPublish(info);
+
+    mCallbackPublisher.SubmitTelemetry(info);
+    return;
+  }
+
   WriteTelemetryInternals(info);
 
   if (!mIsMapped)
@@ -476,6 +1028,8 @@ void SharedMemoryPlugin::UpdateTelemetry(TelemInfoV01 const& info)
       TelemetryTraceSkipUpdate(info);
       assert(!mTelemetryUpdateInProgress);
 
+      ++mStatsCounters.mSkippedDuplicateETUpdates;
+
       // Once per skipped update, retry pending flip, if any.
       if (mTelemetry.RetryPending()) {
         DEBUG_MSG(DebugLevel::Synchronization, "TELEMETRY - Retry pending buffer flip on update skip.");
@@ -503,25 +1057,54 @@ void SharedMemoryPlugin::UpdateTelemetry(TelemInfoV01 const& info)
     if (alreadyUpdated)
       DEBUG_INT2(DebugLevel::Synchronization, "TELEMETRY - Update chain started at:", info.mID);
 
-    // Start new telemetry update chain.
+    // Start new telemetry update chain.  Decide which buffers are assembled for the whole chain.
+    ReaderRegistryPoll();
+    mTelemetryChainReadMask = mReadBuffersMask.load();
+
+    // History and recorder are assembled from the telemetry write buffer.
+    if (mTelemetryRecorder.IsRunning()
+      || (mTelemetryHistory.IsMapped() && IsBufferRead(mTelemetryChainReadMask, rF2ReaderBuffer::TelemetryHistory)))
+      mTelemetryChainReadMask |= static_cast<unsigned int>(rF2ReaderBuffer::Telemetry);
+
+    mTelemetryChainStartTicks = TicksNow();
     mLastTelemetryUpdateET = info.mElapsedTime;
     mTelemetryUpdateInProgress = true;
     mCurTelemetryVehicleIndex = 0;
     memset(mParticipantTelemetryUpdated, 0, sizeof(mParticipantTelemetryUpdated));
     mTelemetry.mpCurWriteBuf->mNumVehicles = mScoringNumVehicles;
+    mKinematics.mpCurWriteBuf->mElapsedTime = info.mElapsedTime;
   }
 
   if (mTelemetryUpdateInProgress) {
+    // Player vehicle goes out first, before anything else is done with it.  Published on submission if queued.
+    if (info.mID == mScoringPlayerID
+      && !mCallbackPublisher.IsPublisherThread()
+      && mPlayerTelemetry.IsMapped()
+      && IsBufferRead(mTelemetryChainReadMask, rF2ReaderBuffer::PlayerTelemetry))
+      PlayerTelemetryPublish(info);
+
     // Update extended state for this vehicle.
     // Since I do not want to miss impact data, and it is not accumulated in any way
     // I am aware of in rF2 internals, process on every telemetr update.
-    mExtStateTracker.ProcessTelemetryUpdate(info);
+    if (mExtStateTracker.ProcessTelemetryUpdate(info))
+      RaceEventTracker::Add(mRaceEvents, rF2RaceEventType::Impact, info.mLastImpactET, info.mID, 0L, 0L, info.mLastImpactMagnitude);
 
     auto const partiticpantIndex = min(info.mID, MAX_PARTICIPANT_SLOTS - 1);
     assert(mParticipantTelemetryUpdated[partiticpantIndex] == false);
     mParticipantTelemetryUpdated[partiticpantIndex] = true;
 
-    memcpy(&(mTelemetry.mpCurWriteBuf->mVehicles[mCurTelemetryVehicleIndex]), &info, sizeof(rF2VehicleTelemetry));
+    if (IsBufferRead(mTelemetryChainReadMask, rF2ReaderBuffer::Telemetry)) {
+      // Time stamps change on every update, do not let them mark every vehicle as changed.
+      mTelemetryUpdateTracker.TrackVehicle(mCurTelemetryVehicleIndex, &info, &(mTelemetry.mpCurReadBuf->mVehicles[mCurTelemetryVehicleIndex]), sizeof(rF2VehicleTelemetry),
+        offsetof(rF2VehicleTelemetry, mDeltaTime), offsetof(rF2VehicleTelemetry, mLapNumber) - offsetof(rF2VehicleTelemetry, mDeltaTime));
+      memcpy(&(mTelemetry.mpCurWriteBuf->mVehicles[mCurTelemetryVehicleIndex]), &info, sizeof(rF2VehicleTelemetry));
+    }
+
+    if (IsBufferRead(mTelemetryChainReadMask, rF2ReaderBuffer::Kinematics))
+      KinematicsAddVehicle(mCurTelemetryVehicleIndex, info);
+
+    if (mLiteTelemetry.IsMapped() && IsBufferRead(mTelemetryChainReadMask, rF2ReaderBuffer::LiteTelemetry))
+      mLiteTelemetryProjection.Project(info, mLiteTelemetry.mpCurWriteBuf->mRecords + mCurTelemetryVehicleIndex * mLiteTelemetryProjection.RecordBytes());
     ++mCurTelemetryVehicleIndex;
 
     TelemetryTraceVehicleAdded(info);
@@ -531,13 +1114,34 @@ void SharedMemoryPlugin::UpdateTelemetry(TelemInfoV01 const& info)
       || mCurTelemetryVehicleIndex >= rF2Telemetry::MAX_MAPPED_VEHICLES) {
       auto const numVehiclesInChain = mCurTelemetryVehicleIndex;
 
-      mTelemetry.mpCurWriteBuf->mBytesUpdatedHint = offsetof(rF2Telemetry, mVehicles[mTelemetry.mpCurWriteBuf->mNumVehicles]);
-
       mTelemetryUpdateInProgress = false;
       mCurTelemetryVehicleIndex = 0;
       memset(mParticipantTelemetryUpdated, 0, sizeof(mParticipantTelemetryUpdated));
 
-      TelemetryFlipBuffers();
+      if (IsBufferRead(mTelemetryChainReadMask, rF2ReaderBuffer::Telemetry)) {
+        mTelemetry.mpCurWriteBuf->mBytesUpdatedHint = static_cast<int>(offsetof(rF2Telemetry, mVehicles)
+          + mTelemetry.mpCurWriteBuf->mNumVehicles * sizeof(rF2VehicleTelemetry));
+
+        mTelemetryUpdateTracker.Publish(mTelemetry.mpCurWriteBuf);
+        TelemetryAddHistoryFrame();
+
+        if (mTelemetryRecorder.IsRunning() && !mTelemetryRecorder.SubmitFrame(mTelemetry.mpCurWriteBuf->mVehicles, numVehiclesInChain))
+          DEBUG_MSG(DebugLevel::Perf, "TELEMETRY RECORDER - Frame dropped, writer thread is behind.");
+
+        TelemetryFlipBuffers();
+      }
+
+      if (IsBufferRead(mTelemetryChainReadMask, rF2ReaderBuffer::Kinematics)) {
+        mKinematics.mpCurWriteBuf->mNumVehicles = numVehiclesInChain;
+        KinematicsFlipBuffers();
+      }
+
+      if (mLiteTelemetry.IsMapped() && IsBufferRead(mTelemetryChainReadMask, rF2ReaderBuffer::LiteTelemetry))
+        LiteTelemetryFlipBuffers(numVehiclesInChain);
+
+      StatsAddTelemetryFrame(numVehiclesInChain);
+      StatsPublish();
+
       TelemetryTraceEndUpdate(numVehiclesInChain);
     }
 
@@ -546,6 +1150,157 @@ void SharedMemoryPlugin::UpdateTelemetry(TelemInfoV01 const& info)
 }
 
 
+void SharedMemoryPlugin::PlayerTelemetryPublish(TelemInfoV01 const& info)
+{
+  // Written in place: this is on the telemetry path, so avoid the extra copy of MappedSeqlockBuffer::Publish.
+  auto const pBuf = mPlayerTelemetry.BeginUpdate();
+  ++pBuf->mUpdateNumber;
+  pBuf->mPublishMicroseconds = Platform::TicksMicroseconds();
+  memcpy(&(pBuf->mVehicle), &info, sizeof(rF2VehicleTelemetry));
+  mPlayerTelemetry.EndUpdate();
+}
+
+
+void SharedMemoryPlugin::KinematicsAddVehicle(int vehicleIndex, TelemInfoV01 const& info)
+{
+  auto const pBuf = mKinematics.mpCurWriteBuf;
+  pBuf->mID[vehicleIndex] = info.mID;
+
+  pBuf->mPosX[vehicleIndex] = info.mPos.x;
+  pBuf->mPosY[vehicleIndex] = info.mPos.y;
+  pBuf->mPosZ[vehicleIndex] = info.mPos.z;
+
+  pBuf->mLocalVelX[vehicleIndex] = info.mLocalVel.x;
+  pBuf->mLocalVelY[vehicleIndex] = info.mLocalVel.y;
+  pBuf->mLocalVelZ[vehicleIndex] = info.mLocalVel.z;
+
+  for (int row = 0; row < 3; ++row) {
+    pBuf->mOri[row * 3][vehicleIndex] = info.mOri[row].x;
+    pBuf->mOri[row * 3 + 1][vehicleIndex] = info.mOri[row].y;
+    pBuf->mOri[row * 3 + 2][vehicleIndex] = info.mOri[row].z;
+  }
+
+  pBuf->mLapDist[vehicleIndex] = mScoringLapDist[min(info.mID, rF2MappedBufferHeader::MAX_MAPPED_IDS - 1)];
+}
+
+
+void SharedMemoryPlugin::KinematicsFlipBuffers()
+{
+  // Never wait for kinematics clients.  If mutex is held, frame is dropped and the write buffer is reused for the next one.
+  mKinematics.TryFlipBuffers();
+  if (mKinematics.RetryPending())
+    DEBUG_MSG(DebugLevel::Synchronization, "KINEMATICS - Buffer flip skipped, mutex is held.");
+}
+
+
+void SharedMemoryPlugin::LiteTelemetryInitialize()
+{
+  mLiteTelemetryProjection.Clear();
+
+  // Comma separated list of rF2VehicleTelemetry member names.
+  char fields[SharedMemoryPlugin::LITE_TELEMETRY_FIELDS_CHARS] = {};
+  strcpy_s(fields, SharedMemoryPlugin::msLiteTelemetryFields);
+
+  auto pField = fields;
+  while (pField != nullptr && *pField != '\0') {
+    auto const pSeparator = strchr(pField, ',');
+    if (pSeparator != nullptr)
+      *pSeparator = '\0';
+
+    while (*pField == ' ' || *pField == '\t')
+      ++pField;
+
+    auto pEnd = pField + strlen(pField);
+    while (pEnd > pField && (pEnd[-1] == ' ' || pEnd[-1] == '\t'))
+      *--pEnd = '\0';
+
+    if (*pField != '\0' && !mLiteTelemetryProjection.AddField(pField))
+      DEBUG_MSG2(DebugLevel::Errors, "Lite telemetry field is unknown, duplicate or does not fit, ignored:", pField);
+
+    pField = pSeparator != nullptr ? pSeparator + 1 : nullptr;
+  }
+
+  if (mLiteTelemetryProjection.NumFields() == 0) {
+    DEBUG_MSG(DebugLevel::Errors, "No valid lite telemetry fields, lite telemetry is disabled");
+    return;
+  }
+
+  mLiteTelemetryProjection.WriteLayout(&mLiteTelemetryLayout);
+
+  // Map only as many records as the projection needs, instead of MAX_RECORD_BYTES each.
+  auto const bufferBytes = static_cast<int>(offsetof(rF2LiteTelemetry, mRecords))
+    + rF2MappedBufferHeader::MAX_MAPPED_VEHICLES * mLiteTelemetryProjection.RecordBytes();
+
+  if (!mLiteTelemetry.Initialize(bufferBytes)) {
+    DEBUG_MSG(DebugLevel::Errors, "Failed to initialize lite telemetry mapping");
+    mLiteTelemetry.ReleaseResources();
+    return;
+  }
+
+  DEBUG_INT2(DebugLevel::Errors, "Lite telemetry record bytes:", mLiteTelemetryProjection.RecordBytes());
+  DEBUG_INT2(DebugLevel::Errors, "Lite telemetry buffer bytes:", bufferBytes);
+  DEBUG_INT2(DebugLevel::Verbose, "Lite telemetry copy runs per vehicle:", mLiteTelemetryProjection.NumCopyRuns());
+}
+
+
+void SharedMemoryPlugin::LiteTelemetryFlipBuffers(int numVehiclesInChain)
+{
+  auto const pBuf = mLiteTelemetry.mpCurWriteBuf;
+  pBuf->mNumVehicles = numVehiclesInChain;
+  pBuf->mElapsedTime = mLastTelemetryUpdateET;
+  pBuf->mBytesUpdatedHint = static_cast<int>(offsetof(rF2LiteTelemetry, mRecords) + numVehiclesInChain * mLiteTelemetryProjection.RecordBytes());
+
+  // Never wait for clients.  If mutex is held, frame is dropped and the write buffer is reused for the next one.
+  mLiteTelemetry.TryFlipBuffers();
+  if (mLiteTelemetry.RetryPending())
+    DEBUG_MSG(DebugLevel::Synchronization, "LITE TELEMETRY - Buffer flip skipped, mutex is held.");
+}
+
+
+void SharedMemoryPlugin::TelemetryRecorderTraceStats() const
+{
+  if (SharedMemoryPlugin::msDebugOutputLevel >= DebugLevel::Errors) {
+    char msg[512] = {};
+    sprintf(msg, "TELEMETRY RECORDER - Frames submitted: %llu  written: %llu  dropped: %llu  bytes written: %llu  file errors: %u",
+      mTelemetryRecorder.FramesSubmitted(), mTelemetryRecorder.FramesWritten(), mTelemetryRecorder.FramesDropped(),
+      mTelemetryRecorder.BytesWritten(), mTelemetryRecorder.FileErrors());
+
+    DEBUG_MSG(DebugLevel::Errors, msg);
+  }
+}
+
+
+void SharedMemoryPlugin::StatsAddTelemetryFrame(int numVehiclesInChain)
+{
+  auto const assemblyMicroseconds = TicksNow() - mTelemetryChainStartTicks;
+
+  ++mStatsCounters.mTelemetryFrames;
+  StatsHistogram::AddLog2(mStatsCounters.mFrameAssemblyHistogram, StatsHistogram::MicrosecondsToNanoseconds(assemblyMicroseconds));
+  mStatsCounters.mLastFrameAssemblyMicroseconds = assemblyMicroseconds;
+  mStatsCounters.mMaxFrameAssemblyMicroseconds = max(mStatsCounters.mMaxFrameAssemblyMicroseconds, assemblyMicroseconds);
+
+  mStatsCounters.mLastVehiclesPerFrame = numVehiclesInChain;
+  ++mStatsCounters.mVehiclesPerFrameHistogram[min(numVehiclesInChain, rF2MappedBufferHeader::MAX_MAPPED_VEHICLES)];
+}
+
+
+void SharedMemoryPlugin::StatsPublish()
+{
+  if (!mStats.IsMapped())
+    return;
+
+  mStatsCounters.mBuffers[static_cast<int>(rF2StatsBufferType::Telemetry)] = mTelemetry.Stats();
+  mStatsCounters.mBuffers[static_cast<int>(rF2StatsBufferType::Scoring)] = mScoring.Stats();
+  mStatsCounters.mBuffers[static_cast<int>(rF2StatsBufferType::Extended)] = mExtended.Stats();
+  mStatsCounters.mBuffers[static_cast<int>(rF2StatsBufferType::Kinematics)] = mKinematics.Stats();
+  mStatsCounters.mBuffers[static_cast<int>(rF2StatsBufferType::LiteTelemetry)] = mLiteTelemetry.Stats();
+  RulesReadStats(mStatsCounters.mBuffers[static_cast<int>(rF2StatsBufferType::Rules)]);
+
+  ++mStatsCounters.mPublishCount;
+  mStats.Publish(mStatsCounters);
+}
+
+
 void SharedMemoryPlugin::ScoringTraceBeginUpdate()
 {
   auto ticksNow = 0.0;
@@ -569,6 +1324,21 @@ void SharedMemoryPlugin::ScoringTraceBeginUpdate()
 
 void SharedMemoryPlugin::UpdateScoring(ScoringInfoV01 const& info)
 {
+  if (JournalsCallbacks())
+    mCallbackJournal.WriteScoring(info);
+
+  // Dropped updates are reported by the publisher thread.
+  if (PublisherQueues()) {
+    mSubmittedPlayerID = -1L;
+    for (int i = 0; info.mVehicle != nullptr && i < info.mNumVehicles; ++i) {
+      if (info.mVehicle[i].mIsPlayer)
+        mSubmittedPlayerID = info.mVehicle[i].mID;
+    }
+
+    mCallbackPublisher.SubmitScoring(info);
+    return;
+  }
+
   WriteScoringInternals(info);
 
   if (!mIsMapped)
@@ -579,9 +1349,14 @@ void SharedMemoryPlugin::UpdateScoring(ScoringInfoV01 const& info)
 
   ScoringTraceBeginUpdate();
 
+  // Keep reader state current even if telemetry is not coming (game paused).
+  ReaderRegistryPoll();
+  auto const publishScoring = IsBufferRead(mReadBuffersMask.load(), rF2ReaderBuffer::Scoring);
+
   if (mTelemetry.RetryPending()) {
     DEBUG_MSG(DebugLevel::Synchronization, "SCORING - Force telemetry flip due to retry pending.");
     mTelemetry.FlipBuffers();
+    mTelemetryUpdateTracker.Commit();
   }
 
   // Below apparently never happens, but let's keep it in case there's a regression in the game.
@@ -589,18 +1364,84 @@ void SharedMemoryPlugin::UpdateScoring(ScoringInfoV01 const& info)
   if (mLastScoringUpdateET > mLastTelemetryUpdateET)
     DEBUG_MSG(DebugLevel::Warnings, "WARNING: Scoring update is ahead of telemetry.");
 
-  memcpy(&(mScoring.mpCurWriteBuf->mScoringInfo), &info, sizeof(rF2ScoringInfo));
+  if (publishScoring)
+    memcpy(&(mScoring.mpCurWriteBuf->mScoringInfo), &info, sizeof(rF2ScoringInfo));
 
-  for (int i = 0; i < info.mNumVehicles; ++i)
-    memcpy(&(mScoring.mpCurWriteBuf->mVehicles[i]), &(info.mVehicle[i]), sizeof(rF2VehicleScoring));
+  mScoringPlayerID = -1L;
+  for (int i = 0; i < info.mNumVehicles; ++i) {
+    // Kinematics needs mLapDist even if nobody reads scoring.
+    mScoringLapDist[min(info.mVehicle[i].mID, rF2MappedBufferHeader::MAX_MAPPED_IDS - 1)] = info.mVehicle[i].mLapDist;
 
-  mScoring.mpCurWriteBuf->mBytesUpdatedHint = offsetof(rF2Scoring, mVehicles[info.mNumVehicles]);
+    if (info.mVehicle[i].mIsPlayer)
+      mScoringPlayerID = info.mVehicle[i].mID;
 
-  mScoring.FlipBuffers();
+    if (publishScoring) {
+      mScoringUpdateTracker.TrackVehicle(i, &(info.mVehicle[i]), &(mScoring.mpCurReadBuf->mVehicles[i]), sizeof(rF2VehicleScoring));
+      memcpy(&(mScoring.mpCurWriteBuf->mVehicles[i]), &(info.mVehicle[i]), sizeof(rF2VehicleScoring));
+    }
+  }
+
+  if (publishScoring) {
+    mScoring.mpCurWriteBuf->mBytesUpdatedHint = static_cast<int>(offsetof(rF2Scoring, mVehicles) + info.mNumVehicles * sizeof(rF2VehicleScoring));
+    mScoringUpdateTracker.Publish(mScoring.mpCurWriteBuf);
+
+    mScoring.FlipBuffers();
+    mScoringUpdateTracker.Commit();
+  }
 
   // Update extended state.
   mExtStateTracker.ProcessScoringUpdate(info);
-  memcpy(mExtended.mpCurWriteBuf, &(mExtStateTracker.mExtended), sizeof(rF2Extended));
+  ExtendedFlipBuffers();
+
+  if (mRaceEvents.IsMapped())
+    mRaceEventTracker.ProcessScoringUpdate(info, mRaceEvents);
+
+  // Only updates that added results text produce a chunk.
+  if (mResultsStream.IsMapped() && info.mResultsStream != nullptr && info.mResultsStream[0] != '\0') {
+    auto const bytesDropped = mResultsStream.Append(info.mResultsStream, static_cast<unsigned int>(strlen(info.mResultsStream)), info.mCurrentET);
+    if (bytesDropped > 0u)
+      DEBUG_INT2(DebugLevel::Warnings, "WARNING: Results stream update does not fit into the ring, bytes dropped:", static_cast<int>(bytesDropped));
+  }
+
+  StatsPublish();
+}
+
+
+void SharedMemoryPlugin::ReaderRegistryPoll()
+{
+  if (!mReaderRegistry.IsMapped())
+    return;
+
+  auto const previousMask = mReadBuffersMask.load();
+  auto const readMask = mReaderRegistry.Poll(Platform::TickCountMillis());
+  mReadBuffersMask.store(readMask);
+  if (readMask == previousMask)
+    return;
+
+  if (SharedMemoryPlugin::msDebugOutputLevel >= DebugLevel::Errors) {
+    char msg[512] = {};
+    sprintf(msg, "READER REGISTRY - Live readers: %u  buffers read mask changed: 0x%x -> 0x%x",
+      mReaderRegistry.LiveReaders(), previousMask, readMask);
+    DEBUG_MSG(DebugLevel::Errors, msg);
+  }
+
+  // Extended state changes rarely, so publish it right away instead of waiting for the next update.
+  if (!IsBufferRead(previousMask, rF2ReaderBuffer::Extended) && IsBufferRead(readMask, rF2ReaderBuffer::Extended))
+    ExtendedFlipBuffers();
+}
+
+
+void SharedMemoryPlugin::ExtendedFlipBuffers()
+{
+  if (!IsBufferRead(mReadBuffersMask.load(), rF2ReaderBuffer::Extended))
+    return;
+
+  // Do not overwrite mapped buffer header, it is maintained by MappedDoubleBuffer.
+  auto const headerBytes = offsetof(rF2Extended, mVersion);
+  memcpy(reinterpret_cast<char*>(mExtended.mpCurWriteBuf) + headerBytes,
+    reinterpret_cast<char const*>(&(mExtStateTracker.mExtended)) + headerBytes,
+    sizeof(rF2Extended) - headerBytes);
+
   mExtended.FlipBuffers();
 }
 
@@ -621,42 +1462,338 @@ void SharedMemoryPlugin::UpdateThreadState(long type, bool starting)
   if (!mIsMapped)
     return;
 
-  memcpy(mExtended.mpCurWriteBuf, &(mExtStateTracker.mExtended), sizeof(rF2Extended));
-  mExtended.FlipBuffers();
+  ExtendedFlipBuffers();
 }
 
 
 void SharedMemoryPlugin::ThreadStarted(long type)
 {
+  if (JournalsCallbacks())
+    mCallbackJournal.WriteEvent(CallbackJournal::EventType::ThreadStarted, static_cast<int>(type));
+
+  if (PublisherQueues()) {
+    if (!mCallbackPublisher.SubmitEvent(CallbackPublisher::Kind::ThreadStarted, type))
+      DEBUG_MSG(DebugLevel::Warnings, "WARNING: Publisher queue is full, ThreadStarted dropped.");
+
+    return;
+  }
+
   DEBUG_MSG(DebugLevel::Synchronization, type == 0 ? "Multimedia thread started" : "Simulation thread started");
+
   UpdateThreadState(type, true /*starting*/);
 }
 
 void SharedMemoryPlugin::ThreadStopping(long type)
 {
+  if (JournalsCallbacks())
+    mCallbackJournal.WriteEvent(CallbackJournal::EventType::ThreadStopping, static_cast<int>(type));
+
+  if (PublisherQueues()) {
+    if (!mCallbackPublisher.SubmitEvent(CallbackPublisher::Kind::ThreadStopping, type))
+      DEBUG_MSG(DebugLevel::Warnings, "WARNING: Publisher queue is full, ThreadStopping dropped.");
+
+    return;
+  }
+
   DEBUG_MSG(DebugLevel::Synchronization, type == 0 ? "Multimedia thread stopped" : "Simulation thread stopped");
+
   UpdateThreadState(type, false /*starting*/);
 }
 
 
 // Called roughly every 300ms.
-bool SharedMemoryPlugin::AccessTrackRules(TrackRulesV01& /*info*/)
+// Invoked during formation and caution laps, right after UpdateScoring.
+bool SharedMemoryPlugin::AccessTrackRules(TrackRulesV01& info)
 {
+  if (!mIsMapped || !mRules.IsMapped())
+    return false;
+
+  // Game passes each action once, so keep them even if nobody reads rules right now.
+  auto const numActions = info.mAction != nullptr ? info.mNumActions : 0L;
+  for (long i = 0L; i < numActions; ++i) {
+    auto const slot = static_cast<int>(mRulesActions.mNumActionsAppended % rF2Rules::MAX_MAPPED_ACTIONS);
+    memcpy(&(mRulesActions.mActions[slot]), &(info.mAction[i]), sizeof(rF2TrackRulesAction));
+    ++mRulesActions.mNumActionsAppended;
+  }
+
+  if (!IsBufferRead(mReadBuffersMask.load(), rF2ReaderBuffer::Rules))
+    return false;
+
+  auto const pBuf = mRules.mpCurWriteBuf;
+  memcpy(&(pBuf->mTrackRules), &info, sizeof(rF2TrackRules));
+  pBuf->mNumActionsAppended = mRulesActions.mNumActionsAppended;
+  memcpy(pBuf->mActions, mRulesActions.mActions, sizeof(mRulesActions.mActions));
+
+  auto const numParticipants = info.mParticipant != nullptr
+    ? max(0, min(static_cast<int>(info.mNumParticipants), rF2MappedBufferHeader::MAX_MAPPED_VEHICLES))
+    : 0;
+
+  if (numParticipants > 0)
+    memcpy(pBuf->mParticipants, info.mParticipant, numParticipants * sizeof(rF2TrackRulesParticipant));
+
+  pBuf->mBytesUpdatedHint = static_cast<int>(offsetof(rF2Rules, mParticipants) + numParticipants * sizeof(rF2TrackRulesParticipant));
+
+  mRules.FlipBuffers();
+  RulesSnapshotStats();
+
+  // Track order is never changed.
   return false;
 }
 
+// Actions ring keeps going, so that clients do not see action numbers go back.
+void SharedMemoryPlugin::RulesClearState()
+{
+  if (mRules.IsMapped()) {
+    mRules.ClearState(&mRulesActions, static_cast<int>(sizeof(rF2RulesHeader)));
+    RulesSnapshotStats();
+  }
+}
+
+
+// Rules are flipped on the simulation thread, while stats might be published by the publisher thread.  So stats are
+// handed over through a seqlock protected copy.
+void SharedMemoryPlugin::RulesSnapshotStats()
+{
+  Seqlock::BeginWrite(&mRulesStats);
+  mRulesStats.mStats = mRules.Stats();
+  Seqlock::EndWrite(&mRulesStats);
+}
+
+
+// Keeps previous value in the unlikely case snapshot is being written on every attempt.
+void SharedMemoryPlugin::RulesReadStats(rF2BufferStats& stats) const
+{
+  for (int attempt = 0; attempt < SharedMemoryPlugin::MAX_STATS_READ_ATTEMPTS; ++attempt) {
+    auto const sequence = Seqlock::ReadBegin(&mRulesStats);
+    if (Seqlock::IsWriteInProgress(sequence))
+      continue;
+
+    rF2BufferStats snapshot;
+    memcpy(&snapshot, &(mRulesStats.mStats), sizeof(rF2BufferStats));
+
+    if (Seqlock::ReadValidate(&mRulesStats, sequence)) {
+      stats = snapshot;
+      return;
+    }
+  }
+}
+
 // Invoked periodically.
-bool SharedMemoryPlugin::AccessPitMenu(PitMenuV01& /*info*/)
+bool SharedMemoryPlugin::AccessPitMenu(PitMenuV01& info)
 {
+  if (!mIsMapped || !mPitInfo.IsMapped())
+    return false;
+
+  // Only publish changes.
+  if (mPitInfoState.mGeneration != 0u
+    && memcmp(&(mPitInfoState.mPitMenu), &info, sizeof(rF2PitMenu)) == 0)
+    return false;
+
+  ++mPitInfoState.mGeneration;
+  memcpy(&(mPitInfoState.mPitMenu), &info, sizeof(rF2PitMenu));
+
+  mPitInfo.Publish(mPitInfoState);
+
+  DEBUG_INT2(DebugLevel::Timing, "PIT MENU - Updated, generation:", static_cast<int>(mPitInfoState.mGeneration));
+
+  // Currently, the return code should always be false.
   return false;
 }
 
+
+bool SharedMemoryPlugin::AccessMultiSessionRules(MultiSessionRulesV01& info)
+{
+  if (!mIsMapped || !mMultiRules.IsMapped())
+    return false;
+
+  // Participant array pointer means nothing to clients, and is not part of the change.
+  rF2MultiSessionRules rules;
+  memcpy(&rules, &info, sizeof(rF2MultiSessionRules));
+  memset(rules.pointer1, 0, sizeof(rules.pointer1));
+
+  auto const numParticipants = info.mParticipant != nullptr
+    ? max(0, min(static_cast<int>(info.mNumParticipants), rF2MappedBufferHeader::MAX_MAPPED_VEHICLES))
+    : 0;
+
+  auto const participantBytes = numParticipants * sizeof(rF2MultiSessionParticipant);
+
+  // Only publish changes.
+  if (mMultiRulesState.mGeneration != 0u
+    && memcmp(&(mMultiRulesState.mMultiSessionRules), &rules, sizeof(rF2MultiSessionRules)) == 0
+    && (participantBytes == 0u || memcmp(mMultiRulesState.mParticipants, info.mParticipant, participantBytes) == 0))
+    return false;
+
+  ++mMultiRulesState.mGeneration;
+  memcpy(&(mMultiRulesState.mMultiSessionRules), &rules, sizeof(rF2MultiSessionRules));
+
+  if (participantBytes > 0u)
+    memcpy(mMultiRulesState.mParticipants, info.mParticipant, participantBytes);
+
+  memset(&(mMultiRulesState.mParticipants[numParticipants]), 0,
+    (rF2MappedBufferHeader::MAX_MAPPED_VEHICLES - numParticipants) * sizeof(rF2MultiSessionParticipant));
+
+  mMultiRules.Publish(mMultiRulesState);
+
+  DEBUG_INT2(DebugLevel::Timing, "MULTI-SESSION RULES - Updated, generation:", static_cast<int>(mMultiRulesState.mGeneration));
+
+  // Never change the rules.
+  return false;
+}
+
+bool SharedMemoryPlugin::AccessWeather(double trackNodeSize, WeatherControlInfoV01& info)
+{
+  if (!mIsMapped || !mWeather.IsMapped())
+    return false;
+
+  // Game passes current weather on each call, only publish changes.  mET is not compared.
+  auto const compareOffset = offsetof(rF2WeatherControlInfo, mRaining);
+  if (mWeatherState.mGeneration != 0u
+    && mWeatherState.mTrackNodeSize == trackNodeSize
+    && memcmp(reinterpret_cast<char const*>(&(mWeatherState.mWeatherInfo)) + compareOffset,
+      reinterpret_cast<char const*>(&info) + compareOffset, sizeof(rF2WeatherControlInfo) - compareOffset) == 0)
+    return false;
+
+  ++mWeatherState.mGeneration;
+  mWeatherState.mTrackNodeSize = trackNodeSize;
+  memcpy(&(mWeatherState.mWeatherInfo), &info, sizeof(rF2WeatherControlInfo));
+
+  mWeather.Publish(mWeatherState);
+
+  DEBUG_INT2(DebugLevel::Timing, "WEATHER - Updated, generation:", static_cast<int>(mWeatherState.mGeneration));
+
+  // Never change the weather.
+  return false;
+}
+
+
+// Invoked once a frame.
+void SharedMemoryPlugin::UpdateHardware(double const /*fDT*/)
+{
+  if (!mIsMapped || !mControlInput.IsMapped())
+    return;
+
+  auto const numApplied = mControlInput.Drain();
+  if (numApplied > 0)
+    DEBUG_INT2(DebugLevel::Timing, "CONTROL INPUT - Commands applied:", numApplied);
+}
+
+
+// Invoked for each control, every frame.
+bool SharedMemoryPlugin::CheckHWControl(char const* const controlName, double& fRetVal)
+{
+  if (!mIsMapped || !mControlInput.IsMapped())
+    return false;
+
+  return mControlInput.Report(controlName, fRetVal);
+}
+
+
+// Invoked at physics rate.  Keep it cheap: no mutex, no debug output.
+bool SharedMemoryPlugin::ForceFeedback(double& forceValue)
+{
+  if (mIsMapped && mForceFeedback.IsMapped()) {
+    rF2ForceFeedbackSample const sample = { forceValue, Platform::TicksMicroseconds() };
+    mForceFeedback.Append(sample);
+  }
+
+  // Never change the value.
+  return false;
+}
+
+
+// Invoked from the render thread, every frame.  Keep it cheap: no mutex, no debug output.
+void SharedMemoryPlugin::UpdateGraphics(GraphicsInfoV02 const& info)
+{
+  if (!mIsMapped || !mGraphics.IsMapped())
+    return;
+
+  ++mGraphicsState.mUpdateNumber;
+  mGraphicsState.mID = static_cast<int>(info.mID);
+  mGraphicsState.mCameraType = static_cast<int>(info.mCameraType);
+  memcpy(&(mGraphicsState.mCamPos), &(info.mCamPos), sizeof(rF2Vec3));
+  memcpy(mGraphicsState.mCamOri, info.mCamOri, sizeof(mGraphicsState.mCamOri));
+
+  mGraphics.Publish(mGraphicsState);
+}
+
 void SharedMemoryPlugin::SetPhysicsOptions(PhysicsOptionsV01& options)
 {
+  if (JournalsCallbacks())
+    mCallbackJournal.WritePhysicsOptions(options);
+
+  if (PublisherQueues()) {
+    if (!mCallbackPublisher.SubmitPhysicsOptions(options))
+      DEBUG_MSG(DebugLevel::Warnings, "WARNING: Publisher queue is full, physics options update dropped.");
+
+    return;
+  }
+
   DEBUG_MSG(DebugLevel::Timing, "PHYSICS - Updated.");
+
   memcpy(&(mExtStateTracker.mExtended.mPhysics), &options, sizeof(rF2PhysicsOptions));
-  memcpy(mExtended.mpCurWriteBuf, &(mExtStateTracker.mExtended), sizeof(rF2Extended));
-  mExtended.FlipBuffers();
+  ExtendedFlipBuffers();
+}
+
+
+// Publisher thread.  Replays queued callback, PublisherQueues() is false on this thread.
+void SharedMemoryPlugin::PublisherHandleRecord(void* pContext, CallbackPublisher::Record& record, ScoringInfoV01 const* pScoringInfo)
+{
+  auto const pPlugin = static_cast<SharedMemoryPlugin*>(pContext);
+  switch (record.mKind) {
+  case CallbackPublisher::Kind::Telemetry:
+    pPlugin->UpdateTelemetry(record.mTelemetry);
+    break;
+  case CallbackPublisher::Kind::TelemetryChainDropped:
+    pPlugin->TelemetryDiscardChain();
+    break;
+  case CallbackPublisher::Kind::Scoring:
+    pPlugin->UpdateScoring(*pScoringInfo);
+    pPlugin->PublisherTraceDrops();
+    break;
+  case CallbackPublisher::Kind::ThreadStarted:
+    pPlugin->ThreadStarted(record.mArgument);
+    break;
+  case CallbackPublisher::Kind::ThreadStopping:
+    pPlugin->ThreadStopping(record.mArgument);
+    break;
+  case CallbackPublisher::Kind::PhysicsOptions:
+    pPlugin->SetPhysicsOptions(record.mPhysicsOptions);
+    break;
+  case CallbackPublisher::Kind::StartSession:
+    pPlugin->StartSession();
+    break;
+  case CallbackPublisher::Kind::EndSession:
+    pPlugin->EndSession();
+    break;
+  case CallbackPublisher::Kind::EnterRealtime:
+    pPlugin->EnterRealtime();
+    break;
+  case CallbackPublisher::Kind::ExitRealtime:
+    pPlugin->ExitRealtime();
+    break;
+  }
+}
+
+
+// Publisher thread (roughly every scoring update), and on Shutdown.
+void SharedMemoryPlugin::PublisherTraceDrops()
+{
+  auto const recordsDropped = mCallbackPublisher.RecordsDropped();
+  auto const chainsDropped = mCallbackPublisher.ChainsDropped();
+  auto const scoringDropped = mCallbackPublisher.ScoringDropped();
+  auto const resultsTruncated = mCallbackPublisher.ResultsTruncated();
+  auto const drops = recordsDropped + scoringDropped + resultsTruncated;
+  if (drops == mPublisherDropsReported)
+    return;
+
+  mPublisherDropsReported = drops;
+  if (SharedMemoryPlugin::msDebugOutputLevel >= DebugLevel::Warnings) {
+    char msg[512] = {};
+    sprintf(msg, "WARNING: Publisher thread is behind.  Records dropped: %llu  telemetry frames dropped: %llu  scoring updates dropped: %llu  results text truncated: %llu",
+      recordsDropped, chainsDropped, scoringDropped, resultsTruncated);
+
+    DEBUG_MSG(DebugLevel::Warnings, msg);
+  }
 }
 
 ////////////////////////////////////////////
@@ -679,6 +1816,50 @@ void SharedMemoryPlugin::LoadConfig()
 
   msDebugISIInternals = GetPrivateProfileInt("config", "debugISIInternals", 0, iniPath) != 0;
 
+  auto syncMode = GetPrivateProfileInt("config", "syncMode", 0, iniPath);
+  if (syncMode > static_cast<UINT>(SyncMode::MultiBuffer))
+    syncMode = 0;
+
+  msSyncMode = static_cast<SyncMode>(syncMode);
+
+  msMultiBufferCount = static_cast<int>(GetPrivateProfileInt("config", "multiBufferCount", 3, iniPath));
+  msMultiBufferCount = max(3, min(msMultiBufferCount, static_cast<int>(rF2MultiBufferControl::MAX_BUFFERS)));
+
+  msTelemetryHistoryFrames = static_cast<int>(GetPrivateProfileInt("config", "telemetryHistoryFrames", 0, iniPath));
+  msTelemetryHistoryFrames = min(msTelemetryHistoryFrames, (MappedHistoryRing<rF2TelemetryHistory, rF2TelemetryHistorySlot>::MAX_FRAMES));
+
+  GetPrivateProfileString("config", "liteTelemetryFields", "", msLiteTelemetryFields, sizeof(msLiteTelemetryFields), iniPath);
+
+  msTelemetryRecorder = GetPrivateProfileInt("config", "telemetryRecorder", 0, iniPath) != 0;
+
+  msCallbackJournal = GetPrivateProfileInt("config", "callbackJournal", 0, iniPath) != 0;
+
+  msFlipNotification = GetPrivateProfileInt("config", "flipNotification", 0, iniPath) != 0;
+
+  msReaderRegistry = GetPrivateProfileInt("config", "readerRegistry", 0, iniPath) != 0;
+
+  msRaceEvents = GetPrivateProfileInt("config", "raceEvents", 0, iniPath) != 0;
+
+  msResultsStream = GetPrivateProfileInt("config", "resultsStream", 0, iniPath) != 0;
+
+  msWeather = GetPrivateProfileInt("config", "weather", 0, iniPath) != 0;
+
+  msRules = GetPrivateProfileInt("config", "rules", 0, iniPath) != 0;
+
+  msMultiSessionRules = GetPrivateProfileInt("config", "multiSessionRules", 0, iniPath) != 0;
+
+  msPitMenu = GetPrivateProfileInt("config", "pitMenu", 0, iniPath) != 0;
+
+  msGraphics = GetPrivateProfileInt("config", "graphics", 0, iniPath) != 0;
+
+  msPlayerTelemetry = GetPrivateProfileInt("config", "playerTelemetry", 0, iniPath) != 0;
+
+  msForceFeedback = GetPrivateProfileInt("config", "forceFeedback", 0, iniPath) != 0;
+
+  msControlInput = GetPrivateProfileInt("config", "controlInput", 0, iniPath) != 0;
+
+  msPublisherThread = GetPrivateProfileInt("config", "publisherThread", 0, iniPath) != 0;
+
   DEBUG_MSG2(DebugLevel::Verbose, "Loaded config from:", iniPath);
 }
 
@@ -700,29 +1881,48 @@ void SharedMemoryPlugin::WriteToAllExampleOutputFiles(const char * const openStr
   }
 }
 
+void SharedMemoryPlugin::OpenDebugFile()
+{
+  if (SharedMemoryPlugin::msDebugFile == nullptr) {
+    SharedMemoryPlugin::msDebugFile = _fsopen(SharedMemoryPlugin::DEBUG_OUTPUT_FILENAME, "a", _SH_DENYNO);
+    if (SharedMemoryPlugin::msDebugFile != nullptr)
+      setvbuf(SharedMemoryPlugin::msDebugFile, nullptr, _IOFBF, SharedMemoryPlugin::BUFFER_IO_BYTES);
+  }
+}
+
 void SharedMemoryPlugin::WriteDebugMsg(DebugLevel lvl, const char* const format, ...)
 {
   if (lvl > SharedMemoryPlugin::msDebugOutputLevel)
     return;
 
   va_list argList;
-  if (SharedMemoryPlugin::msDebugFile == nullptr) {
-    SharedMemoryPlugin::msDebugFile = _fsopen(SharedMemoryPlugin::DEBUG_OUTPUT_FILENAME, "a", _SH_DENYNO);
-    setvbuf(SharedMemoryPlugin::msDebugFile, nullptr, _IOFBF, SharedMemoryPlugin::BUFFER_IO_BYTES);
-  }
+  OpenDebugFile();
+  if (SharedMemoryPlugin::msDebugFile == nullptr)
+    return;
 
   fprintf(SharedMemoryPlugin::msDebugFile, "TID:0x%04x  ", GetCurrentThreadId());
-  if (SharedMemoryPlugin::msDebugFile != nullptr) {
-    va_start(argList, format);
-    vfprintf(SharedMemoryPlugin::msDebugFile, format, argList);
-    va_end(argList);
-  }
+  va_start(argList, format);
+  vfprintf(SharedMemoryPlugin::msDebugFile, format, argList);
+  va_end(argList);
 
   // Flush periodically for low volume messages.
   static ULONGLONG lastFlushTicks = 0uLL;
-  auto const ticksNow = GetTickCount64();
+  auto const ticksNow = Platform::TickCountMillis();
   if ((ticksNow - lastFlushTicks) / MILLISECONDS_IN_SECOND > DEBUG_IO_FLUSH_PERIOD_SECS) {
     fflush(SharedMemoryPlugin::msDebugFile);
     lastFlushTicks = ticksNow;
   }
+}
+
+// Used when DebugLogger is not running.
+void SharedMemoryPlugin::WriteDebugRecordSync(DebugLevel lvl, DebugLogger::Format format, char const* function, int line,
+  char const* msg, char const* msg2, char const* msg3, int intValue, double floatValue)
+{
+  auto const pFormat = DebugLogger::FormatString(format);
+  if (format == DebugLogger::Format::Int2)
+    SharedMemoryPlugin::WriteDebugMsg(lvl, pFormat, function, line, msg, intValue);
+  else if (format == DebugLogger::Format::Float2)
+    SharedMemoryPlugin::WriteDebugMsg(lvl, pFormat, function, line, msg, floatValue);
+  else
+    SharedMemoryPlugin::WriteDebugMsg(lvl, pFormat, function, line, msg, msg2, msg3);
 }
\ No newline at end of file
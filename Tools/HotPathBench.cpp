@@ -0,0 +1,480 @@
+/*
+Publication hot path microbenchmarks.
+
+Author: The Iron Wolf (vleonavicius@hotmail.com)
+Website: thecrewchief.org
+
+Description:
+  Measures each stage of the plugin's publication hot path in isolation, using the plugin's own
+  code (MappedDoubleBuffer, SharedMemoryPlugin::WriteDebugMsg, DebugLogger) compiled into this tool:
+    - per-vehicle memcpy into rF2Telemetry::mVehicles
+    - MappedDoubleBuffer::FlipBuffersHelper in each sync mode
+    - MappedDoubleBuffer::TryFlipBuffers, uncontended and with reader threads holding the mutex
+    - MappedDoubleBuffer::TryFlipBuffers in Seqlock mode, with and without flip notification (and a client waiting on it)
+    - rF2Extended copy done on every scoring update (see SharedMemoryPlugin::ExtendedFlipBuffers)
+    - memset of mParticipantTelemetryUpdated
+    - SharedMemoryPlugin::WriteDebugMsg for each DebugLevel, enabled and filtered out
+    - DEBUG_* macros queued to DebugLogger for each DebugLevel
+
+  Each benchmark is run several times, and the median ns/op and TSC cycles/op are reported, so
+  results are stable enough to be compared between builds.  Use --csv to get machine readable output.
+
+  Buffers are mapped under separate names, so benchmark does not interfere with a running plugin.
+  Debug output goes to HotPathBench_DebugOutput.txt in the current directory, and is deleted on exit.
+
+Build (Linux):
+  g++ -std=c++14 -O2 -pthread -Wno-invalid-offsetof -Wno-unknown-pragmas -Wno-format -I../Include HotPathBench.cpp ../Source/rFactor2SharedMemoryMap.cpp ../VC12/ISIInternalsDump.cpp -o HotPathBench
+
+Usage:
+  HotPathBench [--csv] [--filter <substring>] [--reps <n>]
+*/
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "rFactor2SharedMemoryMap.hpp"
+
+static char const* const BENCH_DEBUG_OUTPUT_FILENAME = "HotPathBench_DebugOutput.txt";
+
+struct BenchConfig
+{
+  bool mCsv = false;
+  char const* mFilter = nullptr;
+  int mRepetitions = 11;
+};
+
+
+struct BenchResult
+{
+  double mNsPerOp = 0.0;
+  double mMinNsPerOp = 0.0;
+  double mCyclesPerOp = 0.0;
+};
+
+
+inline unsigned long long ReadCycles()
+{
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return 0uLL;
+#endif
+}
+
+
+// Prevents compiler from dropping stores into memory it can prove is not read afterwards.
+inline void ClobberMemory()
+{
+#ifdef _MSC_VER
+  _ReadWriteBarrier();
+#else
+  asm volatile("" : : : "memory");
+#endif
+}
+
+
+class BenchRunner
+{
+public:
+  BenchRunner(BenchConfig const& config)
+    : mConfig(config)
+  {
+    if (mConfig.mCsv)
+      printf("name,ops,ns_per_op,min_ns_per_op,cycles_per_op\n");
+    else
+      printf("%-44s %10s %12s %12s %12s\n", "Benchmark", "Ops", "ns/op", "min ns/op", "cycles/op");
+  }
+
+  bool Enabled(char const* name) const
+  {
+    return mConfig.mFilter == nullptr || strstr(name, mConfig.mFilter) != nullptr;
+  }
+
+  // Runs opsPerRun operations per repetition (runOps does the actual work), and reports median of repetitions.
+  // Optional betweenRuns is called before each repetition, outside of the measurement.
+  void Run(char const* name, int opsPerRun, std::function<void(int)> const& runOps, std::function<void()> const& betweenRuns = nullptr)
+  {
+    if (!Enabled(name))
+      return;
+
+    // Warm up caches, page in mapped memory.
+    if (betweenRuns)
+      betweenRuns();
+
+    runOps(opsPerRun);
+
+    std::vector<double> nsPerOp(mConfig.mRepetitions);
+    std::vector<double> cyclesPerOp(mConfig.mRepetitions);
+    for (int rep = 0; rep < mConfig.mRepetitions; ++rep) {
+      if (betweenRuns)
+        betweenRuns();
+
+      auto const startCycles = ReadCycles();
+      auto const start = std::chrono::steady_clock::now();
+
+      runOps(opsPerRun);
+
+      auto const end = std::chrono::steady_clock::now();
+      auto const endCycles = ReadCycles();
+
+      nsPerOp[rep] = std::chrono::duration<double, std::nano>(end - start).count() / opsPerRun;
+      cyclesPerOp[rep] = static_cast<double>(endCycles - startCycles) / opsPerRun;
+    }
+
+    BenchResult result;
+    result.mMinNsPerOp = *std::min_element(nsPerOp.begin(), nsPerOp.end());
+    std::nth_element(nsPerOp.begin(), nsPerOp.begin() + nsPerOp.size() / 2, nsPerOp.end());
+    result.mNsPerOp = nsPerOp[nsPerOp.size() / 2];
+    std::nth_element(cyclesPerOp.begin(), cyclesPerOp.begin() + cyclesPerOp.size() / 2, cyclesPerOp.end());
+    result.mCyclesPerOp = cyclesPerOp[cyclesPerOp.size() / 2];
+
+    if (mConfig.mCsv)
+      printf("%s,%d,%.2f,%.2f,%.1f\n", name, opsPerRun, result.mNsPerOp, result.mMinNsPerOp, result.mCyclesPerOp);
+    else
+      printf("%-44s %10d %12.2f %12.2f %12.1f\n", name, opsPerRun, result.mNsPerOp, result.mMinNsPerOp, result.mCyclesPerOp);
+  }
+
+  // Extra information about the last benchmark, not included in CSV output.
+  void Note(char const* name, char const* format, double value) const
+  {
+    if (!Enabled(name) || mConfig.mCsv)
+      return;
+
+    printf("  ");
+    printf(format, value);
+    printf("\n");
+  }
+
+private:
+  BenchConfig const& mConfig;
+};
+
+
+static void BenchVehicleTelemetryCopy(BenchRunner& runner)
+{
+  MappedDoubleBuffer<rF2Telemetry> telemetry(SharedMemoryPlugin::MAX_ASYNC_RETRIES
+    , "$rFactor2SMMP_BenchTelemetryBuffer1$"
+    , "$rFactor2SMMP_BenchTelemetryBuffer2$"
+    , "Global\\$rFactor2SMMP_BenchTelemetryMutex$"
+    , "$rFactor2SMMP_BenchTelemetryMultiBuffer$"
+    , "Global\\$rFactor2SMMP_BenchTelemetryFlipEvent");
+
+  SharedMemoryPlugin::msSyncMode = SyncMode::Seqlock;
+  if (!telemetry.Initialize())
+    return;
+
+  telemetry.ClearState(nullptr);
+
+  std::vector<TelemInfoV01> infos(rF2Telemetry::MAX_MAPPED_VEHICLES);
+  for (int i = 0; i < rF2Telemetry::MAX_MAPPED_VEHICLES; ++i)
+    infos[i].mID = i;
+
+  // Same copy as SharedMemoryPlugin::UpdateTelemetry does, op is one vehicle.
+  runner.Run("VehicleTelemetryCopy", 128 * 1000, [&](int ops) {
+    for (int i = 0; i < ops; ++i) {
+      auto const vehicle = i % rF2Telemetry::MAX_MAPPED_VEHICLES;
+      memcpy(&(telemetry.mpCurWriteBuf->mVehicles[vehicle]), &(infos[vehicle]), sizeof(rF2VehicleTelemetry));
+    }
+
+    ClobberMemory();
+  });
+}
+
+
+static void BenchFlipBuffersHelper(BenchRunner& runner, SyncMode syncMode, char const* name)
+{
+  MappedDoubleBuffer<rF2Telemetry> telemetry(SharedMemoryPlugin::MAX_ASYNC_RETRIES
+    , "$rFactor2SMMP_BenchTelemetryBuffer1$"
+    , "$rFactor2SMMP_BenchTelemetryBuffer2$"
+    , "Global\\$rFactor2SMMP_BenchTelemetryMutex$"
+    , "$rFactor2SMMP_BenchTelemetryMultiBuffer$"
+    , "Global\\$rFactor2SMMP_BenchTelemetryFlipEvent");
+
+  SharedMemoryPlugin::msSyncMode = syncMode;
+  if (!telemetry.Initialize())
+    return;
+
+  telemetry.ClearState(nullptr);
+
+  runner.Run(name, 100000, [&](int ops) {
+    for (int i = 0; i < ops; ++i)
+      telemetry.FlipBuffersHelper();
+  });
+}
+
+
+static void BenchTryFlipBuffers(BenchRunner& runner, int numReaders, char const* name)
+{
+  MappedDoubleBuffer<rF2Telemetry> telemetry(SharedMemoryPlugin::MAX_ASYNC_RETRIES
+    , "$rFactor2SMMP_BenchTelemetryBuffer1$"
+    , "$rFactor2SMMP_BenchTelemetryBuffer2$"
+    , "Global\\$rFactor2SMMP_BenchTelemetryMutex$"
+    , "$rFactor2SMMP_BenchTelemetryMultiBuffer$"
+    , "Global\\$rFactor2SMMP_BenchTelemetryFlipEvent");
+
+  SharedMemoryPlugin::msSyncMode = SyncMode::Mutex;
+  if (!telemetry.Initialize())
+    return;
+
+  telemetry.ClearState(nullptr);
+
+  // Readers behave like a client polling in a tight loop: take the mutex, copy the buffer, release.
+  auto const pReadBuf = telemetry.mpCurReadBuf;
+  std::atomic<bool> stop(false);
+  std::vector<std::thread> readers;
+  for (int r = 0; r < numReaders; ++r) {
+    readers.emplace_back([&]() {
+      auto const hMutex = Platform::CreateNamedLock("Global\\$rFactor2SMMP_BenchTelemetryMutex$");
+      std::vector<char> copy(sizeof(rF2Telemetry));
+      while (!stop.load(std::memory_order_relaxed)) {
+        if (!Platform::IsLockAcquired(Platform::AcquireLock(hMutex, INFINITE)))
+          break;
+
+        memcpy(copy.data(), pReadBuf, offsetof(rF2Telemetry, mVehicles) + 8 * sizeof(rF2VehicleTelemetry));
+        Platform::ReleaseLock(hMutex);
+      }
+
+      Platform::CloseLock(hMutex);
+    });
+  }
+
+  auto retries = 0LL;
+  auto totalOps = 0LL;
+  runner.Run(name, 20000, [&](int ops) {
+    for (int i = 0; i < ops; ++i) {
+      telemetry.TryFlipBuffers();
+      if (telemetry.RetryPending())
+        ++retries;
+    }
+
+    totalOps += ops;
+  });
+
+  stop = true;
+  for (auto& reader : readers)
+    reader.join();
+
+  if (numReaders > 0)
+    runner.Note(name, "flips deferred to retry: %.1f%%", 100.0 * retries / max(totalOps, 1LL));
+}
+
+
+static void BenchFlipNotification(BenchRunner& runner, bool notify, bool waitingClient, char const* name)
+{
+  MappedDoubleBuffer<rF2Telemetry> telemetry(SharedMemoryPlugin::MAX_ASYNC_RETRIES
+    , "$rFactor2SMMP_BenchTelemetryBuffer1$"
+    , "$rFactor2SMMP_BenchTelemetryBuffer2$"
+    , "Global\\$rFactor2SMMP_BenchTelemetryMutex$"
+    , "$rFactor2SMMP_BenchTelemetryMultiBuffer$"
+    , "Global\\$rFactor2SMMP_BenchTelemetryFlipEvent");
+
+  SharedMemoryPlugin::msSyncMode = SyncMode::Seqlock;
+  SharedMemoryPlugin::msFlipNotification = notify;
+  auto const initialized = telemetry.Initialize();
+  SharedMemoryPlugin::msFlipNotification = false;
+  if (!initialized)
+    return;
+
+  telemetry.ClearState(nullptr);
+
+  // Client blocks on the event and wakes on every flip, the way a non-polling reader would.
+  std::atomic<bool> stop(false);
+  std::atomic<long long> wakeups(0LL);
+  std::thread client;
+  if (waitingClient) {
+    client = std::thread([&]() {
+      auto const hEvent = Platform::CreateNamedEvent("Global\\$rFactor2SMMP_BenchTelemetryFlipEvent");
+      while (!stop.load(std::memory_order_relaxed)) {
+        if (Platform::WaitEvent(hEvent, 10u) == Platform::WaitResult::Signaled)
+          ++wakeups;
+      }
+
+      Platform::CloseEvent(hEvent);
+    });
+  }
+
+  auto totalOps = 0LL;
+  runner.Run(name, 20000, [&](int ops) {
+    for (int i = 0; i < ops; ++i)
+      telemetry.TryFlipBuffers();
+
+    totalOps += ops;
+  });
+
+  stop = true;
+  if (client.joinable())
+    client.join();
+
+  if (waitingClient)
+    runner.Note(name, "client wakeups per flip: %.2f", static_cast<double>(wakeups.load()) / max(totalOps, 1LL));
+}
+
+
+static void BenchExtendedCopy(BenchRunner& runner)
+{
+  MappedDoubleBuffer<rF2Extended> extended(SharedMemoryPlugin::MAX_ASYNC_RETRIES
+    , "$rFactor2SMMP_BenchExtendedBuffer1$"
+    , "$rFactor2SMMP_BenchExtendedBuffer2$"
+    , "Global\\$rFactor2SMMP_BenchExtendedMutex$"
+    , "$rFactor2SMMP_BenchExtendedMultiBuffer$"
+    , "Global\\$rFactor2SMMP_BenchExtendedFlipEvent");
+
+  SharedMemoryPlugin::msSyncMode = SyncMode::Seqlock;
+  if (!extended.Initialize())
+    return;
+
+  extended.ClearState(nullptr);
+
+  rF2Extended source;
+  memset(&source, 0, sizeof(rF2Extended));
+
+  // Same copy as SharedMemoryPlugin::ExtendedFlipBuffers does.
+  runner.Run("ExtendedCopy", 100000, [&](int ops) {
+    auto const headerBytes = offsetof(rF2Extended, mVersion);
+    for (int i = 0; i < ops; ++i) {
+      memcpy(reinterpret_cast<char*>(extended.mpCurWriteBuf) + headerBytes,
+        reinterpret_cast<char const*>(&source) + headerBytes,
+        sizeof(rF2Extended) - headerBytes);
+
+      ClobberMemory();
+    }
+  });
+}
+
+
+static void BenchParticipantUpdatedMemset(BenchRunner& runner)
+{
+  static bool participantTelemetryUpdated[SharedMemoryPlugin::MAX_PARTICIPANT_SLOTS];
+
+  runner.Run("ParticipantTelemetryUpdatedMemset", 1000000, [&](int ops) {
+    for (int i = 0; i < ops; ++i) {
+      memset(participantTelemetryUpdated, 0, sizeof(participantTelemetryUpdated));
+      ClobberMemory();
+    }
+  });
+}
+
+
+static void BenchWriteDebugMsg(BenchRunner& runner)
+{
+  // Redirect debug output away from the plugin's debug file.
+  SharedMemoryPlugin::msDebugFile = _fsopen(BENCH_DEBUG_OUTPUT_FILENAME, "w", _SH_DENYNO);
+  if (SharedMemoryPlugin::msDebugFile == nullptr)
+    return;
+
+  setvbuf(SharedMemoryPlugin::msDebugFile, nullptr, _IOFBF, SharedMemoryPlugin::BUFFER_IO_BYTES);
+
+  static char const* const levelNames[] = { "Off", "Errors", "Warnings", "Synchronization", "Perf", "Timing", "Verbose" };
+
+  char name[128] = {};
+  for (int lvl = DebugLevel::Errors; lvl <= DebugLevel::Verbose; ++lvl) {
+    // Message written.
+    sprintf(name, "WriteDebugMsg(%s) enabled", levelNames[lvl]);
+    SharedMemoryPlugin::msDebugOutputLevel = static_cast<DebugLevel>(lvl);
+    runner.Run(name, 20000, [&](int ops) {
+      for (int i = 0; i < ops; ++i)
+        DEBUG_INT2(static_cast<DebugLevel>(lvl), "TELEMETRY - Update chain started at:", i);
+    });
+
+    // Message filtered out by the configured level.
+    sprintf(name, "WriteDebugMsg(%s) filtered", levelNames[lvl]);
+    SharedMemoryPlugin::msDebugOutputLevel = static_cast<DebugLevel>(lvl - 1);
+    runner.Run(name, 1000000, [&](int ops) {
+      for (int i = 0; i < ops; ++i)
+        DEBUG_INT2(static_cast<DebugLevel>(lvl), "TELEMETRY - Update chain started at:", i);
+    });
+  }
+
+  // Same messages queued to DebugLogger.  Runs are kept to half a ring, and writer is given time to drain it
+  // between runs, so that drop path is not measured.
+  if (SharedMemoryPlugin::msDebugLogger.Start(SharedMemoryPlugin::msDebugFile)) {
+    static int const asyncOps = static_cast<int>(DebugLogger::RECORDS_PER_THREAD / 2u);
+    auto const drain = []() { Platform::SleepMillis(DebugLogger::CALIBRATION_MS + 4uL * DebugLogger::WRITER_IDLE_SLEEP_MS); };
+
+    for (int lvl = DebugLevel::Errors; lvl <= DebugLevel::Verbose; ++lvl) {
+      sprintf(name, "DebugLogger(%s) enabled", levelNames[lvl]);
+      SharedMemoryPlugin::msDebugOutputLevel = static_cast<DebugLevel>(lvl);
+      runner.Run(name, asyncOps, [&](int ops) {
+        for (int i = 0; i < ops; ++i)
+          DEBUG_INT2(static_cast<DebugLevel>(lvl), "TELEMETRY - Update chain started at:", i);
+      }, drain);
+
+      runner.Note(name, "messages dropped: %.0f", static_cast<double>(SharedMemoryPlugin::msDebugLogger.Dropped()));
+    }
+
+    SharedMemoryPlugin::msDebugLogger.Stop();
+  }
+
+  SharedMemoryPlugin::msDebugOutputLevel = DebugLevel::Off;
+  fclose(SharedMemoryPlugin::msDebugFile);
+  SharedMemoryPlugin::msDebugFile = nullptr;
+  remove(BENCH_DEBUG_OUTPUT_FILENAME);
+}
+
+
+static bool ParseArgs(int argc, char* argv[], BenchConfig& config)
+{
+  for (int i = 1; i < argc; ++i) {
+    auto const hasValue = i + 1 < argc;
+    if (strcmp(argv[i], "--csv") == 0)
+      config.mCsv = true;
+    else if (strcmp(argv[i], "--filter") == 0 && hasValue)
+      config.mFilter = argv[++i];
+    else if (strcmp(argv[i], "--reps") == 0 && hasValue) {
+      // Note: min/max are macros, do not pass expressions with side effects.
+      auto const repetitions = atoi(argv[++i]);
+      config.mRepetitions = max(1, repetitions);
+    }
+    else {
+      printf("Unknown or incomplete option: %s\n", argv[i]);
+      return false;
+    }
+  }
+
+  return true;
+}
+
+
+int main(int argc, char* argv[])
+{
+  BenchConfig config;
+  if (!ParseArgs(argc, argv, config))
+    return 2;
+
+  // Buffers are used directly, without plugin Startup.
+  Platform::InitializeClock();
+
+  // Benchmarks must not write debug output unless measuring it.
+  SharedMemoryPlugin::msDebugOutputLevel = DebugLevel::Off;
+
+  BenchRunner runner(config);
+
+  BenchVehicleTelemetryCopy(runner);
+
+  BenchFlipBuffersHelper(runner, SyncMode::Mutex, "FlipBuffersHelper(Mutex)");
+  BenchFlipBuffersHelper(runner, SyncMode::Seqlock, "FlipBuffersHelper(Seqlock)");
+  BenchFlipBuffersHelper(runner, SyncMode::MultiBuffer, "FlipBuffersHelper(MultiBuffer)");
+
+  BenchTryFlipBuffers(runner, 0, "TryFlipBuffers(uncontended)");
+  BenchTryFlipBuffers(runner, 1, "TryFlipBuffers(1 reader)");
+  BenchTryFlipBuffers(runner, 4, "TryFlipBuffers(4 readers)");
+
+  BenchFlipNotification(runner, false /*notify*/, false /*waitingClient*/, "TryFlipBuffers(Seqlock)");
+  BenchFlipNotification(runner, true /*notify*/, false /*waitingClient*/, "TryFlipBuffers(Seqlock, notify)");
+  BenchFlipNotification(runner, true /*notify*/, true /*waitingClient*/, "TryFlipBuffers(Seqlock, notify, waiter)");
+
+  BenchExtendedCopy(runner);
+  BenchParticipantUpdatedMemset(runner);
+  BenchWriteDebugMsg(runner);
+
+  return 0;
+}
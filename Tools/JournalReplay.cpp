@@ -0,0 +1,482 @@
+/*
+Callback journal replay.
+
+Author: The Iron Wolf (vleonavicius@hotmail.com)
+Website: thecrewchief.org
+
+Description:
+  Loads plugin binary and feeds it a callback journal captured with callbackJournal=1 (see CallbackJournal.h),
+  in the recorded order and with the recorded arguments.  Replay can run at recorded speed, N times faster,
+  or as fast as possible.  Reports cost of each callback type, buffer flips, and digests (CRC32 chain) of
+  every published telemetry frame and scoring update.  Since plugin output only depends on callback order
+  and arguments, digests are stable between runs and builds, unless frame assembly or publication changed,
+  so they can be used as a regression check.
+
+  Telemetry digest covers rF2Telemetry from mNumVehicles up to mBytesUpdatedHint.  Scoring digest only covers
+  mVehicles, since rF2ScoringInfo carries raw pointer values.
+
+  Plugin configuration is read by the plugin as usual, from UserData/player/rf2smmp.ini relative to the current
+  directory.  Leave callbackJournal=0 there, unless you want the replay journaled again.
+
+Build (Linux, plugin built as described in README.md):
+  g++ -std=c++14 -O2 -pthread -Wno-invalid-offsetof -I../Include JournalReplay.cpp -o JournalReplay -ldl
+
+Usage:
+  JournalReplay <journal.rf2cj> [options]
+    --plugin <path>         plugin binary (default ./librf2smmp.so, rFactor2SharedMemoryMapPlugin64.dll on Windows)
+    --speed <x>             replay speed relative to recorded timestamps, 0 means as fast as possible (default 1)
+*/
+#include <chrono>
+#include <cstddef>                              // offsetof
+#include <thread>
+#include <vector>
+
+#include "Seqlock.h"
+#include "Platform.h"
+
+#pragma warning(push)
+#pragma warning(disable : 4263)   // UpdateGraphics virtual incorrect signature
+#pragma warning(disable : 4264)   // UpdateGraphics virtual incorrect signature
+#pragma warning(disable : 4121)   // Alignment sensitivity (ISI sets 4 byte pack)
+#pragma warning(disable : 4100)   // Unreferenced params
+#include "InternalsPlugin.hpp"
+#pragma warning(pop)
+
+#include "rF2State.h"
+#include "TelemetryRecording.h"                 // Crc32
+#include "CallbackJournal.h"
+
+#ifndef _WIN32
+#include <dlfcn.h>
+#endif
+
+using CallbackJournal::EventType;
+
+struct ReplayConfig
+{
+  char const* mJournalPath = nullptr;
+  char const* mPluginPath = nullptr;
+  double mSpeed = 1.0;
+};
+
+
+struct CallbackStats
+{
+  char const* mName = nullptr;
+  unsigned long long mCalls = 0uLL;
+  unsigned long long mTotalNs = 0uLL;
+  unsigned long long mMaxNs = 0uLL;
+
+  void Add(unsigned long long ns)
+  {
+    ++mCalls;
+    mTotalNs += ns;
+    mMaxNs = max(mMaxNs, ns);
+  }
+
+  void Print() const
+  {
+    printf("%-18s %12llu %12.1f %12llu\n", mName, mCalls, mCalls > 0uLL ? static_cast<double>(mTotalNs) / mCalls : 0.0, mMaxNs);
+  }
+};
+
+
+// Times a single callback.
+template <typename CallbackT>
+inline void TimeCallback(CallbackStats& stats, CallbackT callback)
+{
+  auto const start = std::chrono::steady_clock::now();
+  callback();
+  auto const end = std::chrono::steady_clock::now();
+  stats.Add(static_cast<unsigned long long>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()));
+}
+
+
+// Maps buffers of one type, detects flips by watching sequence counters and digests each published buffer.
+template <typename BuffT>
+class PublicationDigest
+{
+public:
+  PublicationDigest(size_t payloadOffset)
+    : mPayloadOffset(payloadOffset)
+  {}
+
+  void Attach(char const* fileName1, char const* fileName2, char const* multiBufferFileName)
+  {
+    void* pView = nullptr;
+    mhMap1 = Platform::MapMemoryFile(fileName1, sizeof(BuffT), pView);
+    mpBuf1 = static_cast<BuffT*>(pView);
+
+    mhMap2 = Platform::MapMemoryFile(fileName2, sizeof(BuffT), pView);
+    mpBuf2 = static_cast<BuffT*>(pView);
+
+    // Map control block first to learn the layout, then the whole file.
+    auto const hControl = Platform::MapMemoryFile(multiBufferFileName, sizeof(rF2MultiBufferControl), pView);
+    if (hControl != nullptr) {
+      auto const pControl = static_cast<rF2MultiBufferControl*>(pView);
+      auto const numBuffers = pControl->mNumBuffers;
+      auto const multiBufferBytes = pControl->mFirstBufferOffset + pControl->mNumBuffers * pControl->mBufferStride;
+      Platform::UnmapMemoryFile(hControl, pView);
+
+      if (numBuffers > 0) {
+        mhMultiMap = Platform::MapMemoryFile(multiBufferFileName, multiBufferBytes, pView);
+        mpControl = static_cast<rF2MultiBufferControl*>(pView);
+      }
+    }
+
+    mLastSequenceSum = SequenceSum();
+  }
+
+  void Detach()
+  {
+    Platform::UnmapMemoryFile(mhMap1, mpBuf1);
+    Platform::UnmapMemoryFile(mhMap2, mpBuf2);
+    Platform::UnmapMemoryFile(mhMultiMap, mpControl);
+    mhMap1 = mhMap2 = mhMultiMap = nullptr;
+    mpBuf1 = mpBuf2 = nullptr;
+    mpControl = nullptr;
+  }
+
+  // Call after each callback that might have published the buffer.
+  void Update()
+  {
+    auto const sequenceSum = SequenceSum();
+    if (sequenceSum == mLastSequenceSum)
+      return;
+
+    // Each flip advances the sum by two.
+    mFlips += (sequenceSum - mLastSequenceSum) / 2uLL;
+    mLastSequenceSum = sequenceSum;
+
+    auto const pBuf = PublishedBuffer();
+    if (pBuf == nullptr)
+      return;
+
+    auto const bytesUpdated = pBuf->mBytesUpdatedHint > 0 ? static_cast<size_t>(pBuf->mBytesUpdatedHint) : sizeof(BuffT);
+    if (bytesUpdated <= mPayloadOffset)
+      return;
+
+    auto const crc = TelemetryRecording::Crc32(reinterpret_cast<char const*>(pBuf) + mPayloadOffset, bytesUpdated - mPayloadOffset);
+    mDigest = TelemetryRecording::Crc32(&crc, sizeof(crc)) ^ mDigest * 31u;
+    ++mDigestedPublishes;
+  }
+
+  unsigned long long Flips() const { return mFlips; }
+  unsigned long long DigestedPublishes() const { return mDigestedPublishes; }
+  unsigned int Digest() const { return mDigest; }
+
+private:
+  unsigned long long SequenceSum() const
+  {
+    auto sum = 0uLL;
+    if (mpBuf1 != nullptr)
+      sum += Seqlock::LoadSequence(mpBuf1);
+
+    if (mpBuf2 != nullptr)
+      sum += Seqlock::LoadSequence(mpBuf2);
+
+    if (mpControl != nullptr) {
+      for (int i = 0; i < mpControl->mNumBuffers; ++i)
+        sum += Seqlock::LoadSequence(MultiBuffer(i));
+    }
+
+    return sum;
+  }
+
+  BuffT const* MultiBuffer(int i) const
+  {
+    return reinterpret_cast<BuffT const*>(reinterpret_cast<char const*>(mpControl) + mpControl->mFirstBufferOffset + i * mpControl->mBufferStride);
+  }
+
+  BuffT const* PublishedBuffer() const
+  {
+    if (mpControl != nullptr && mpControl->mNumBuffers > 0)
+      return MultiBuffer(mpControl->mLatest);
+
+    if (mpBuf1 == nullptr || mpBuf2 == nullptr)
+      return nullptr;
+
+    return mpBuf1->mCurrentRead ? mpBuf1 : mpBuf2;
+  }
+
+  size_t const mPayloadOffset;
+  Platform::MapHandle mhMap1 = nullptr;
+  Platform::MapHandle mhMap2 = nullptr;
+  Platform::MapHandle mhMultiMap = nullptr;
+  BuffT* mpBuf1 = nullptr;
+  BuffT* mpBuf2 = nullptr;
+  rF2MultiBufferControl* mpControl = nullptr;
+  unsigned long long mLastSequenceSum = 0uLL;
+  unsigned long long mFlips = 0uLL;
+  unsigned long long mDigestedPublishes = 0uLL;
+  unsigned int mDigest = 0u;
+};
+
+
+static bool ParseArgs(int argc, char* argv[], ReplayConfig& config)
+{
+  for (int i = 1; i < argc; ++i) {
+    auto const hasValue = i + 1 < argc;
+    if (strcmp(argv[i], "--plugin") == 0 && hasValue)
+      config.mPluginPath = argv[++i];
+    else if (strcmp(argv[i], "--speed") == 0 && hasValue)
+      config.mSpeed = atof(argv[++i]);
+    else if (argv[i][0] != '-' && config.mJournalPath == nullptr)
+      config.mJournalPath = argv[i];
+    else {
+      printf("Unknown or incomplete option: %s\n", argv[i]);
+      return false;
+    }
+  }
+
+  if (config.mJournalPath == nullptr) {
+    printf("Usage: JournalReplay <journal.rf2cj> [--plugin <path>] [--speed <x>]\n");
+    return false;
+  }
+
+  return true;
+}
+
+
+static bool ReadJournalHeader(FILE* f)
+{
+  CallbackJournal::rF2CallbackJournalFileHeader header = {};
+  if (fread(&header, sizeof(header), 1, f) != 1 || memcmp(header.mMagic, CallbackJournal::FILE_MAGIC, sizeof(header.mMagic)) != 0) {
+    printf("Not a callback journal\n");
+    return false;
+  }
+
+  if (header.mVersion != CallbackJournal::FORMAT_VERSION
+    || header.mTelemInfoBytes != sizeof(TelemInfoV01)
+    || header.mScoringInfoBytes != sizeof(ScoringInfoV01)
+    || header.mVehicleScoringInfoBytes != sizeof(VehicleScoringInfoV01)
+    || header.mPhysicsOptionsBytes != sizeof(PhysicsOptionsV01)) {
+    printf("Journal was captured by an incompatible build (version %u, TelemInfoV01 %u bytes, ScoringInfoV01 %u bytes)\n",
+      header.mVersion, header.mTelemInfoBytes, header.mScoringInfoBytes);
+    return false;
+  }
+
+  return true;
+}
+
+
+int main(int argc, char* argv[])
+{
+  ReplayConfig config;
+  if (!ParseArgs(argc, argv, config))
+    return 2;
+
+  auto const f = fopen(config.mJournalPath, "rb");
+  if (f == nullptr) {
+    printf("Failed to open journal: %s\n", config.mJournalPath);
+    return 1;
+  }
+
+  if (!ReadJournalHeader(f)) {
+    fclose(f);
+    return 1;
+  }
+
+#ifdef _WIN32
+  auto const pluginPath = config.mPluginPath != nullptr ? config.mPluginPath : "rFactor2SharedMemoryMapPlugin64.dll";
+  auto const hPlugin = LoadLibrary(pluginPath);
+  auto const createPluginObject = hPlugin != nullptr ? reinterpret_cast<CREATEPLUGINOBJECT>(GetProcAddress(hPlugin, "CreatePluginObject")) : nullptr;
+  auto const destroyPluginObject = hPlugin != nullptr ? reinterpret_cast<DESTROYPLUGINOBJECT>(GetProcAddress(hPlugin, "DestroyPluginObject")) : nullptr;
+#else
+  auto const pluginPath = config.mPluginPath != nullptr ? config.mPluginPath : "./librf2smmp.so";
+  auto const hPlugin = dlopen(pluginPath, RTLD_NOW);
+  auto const createPluginObject = hPlugin != nullptr ? reinterpret_cast<CREATEPLUGINOBJECT>(dlsym(hPlugin, "CreatePluginObject")) : nullptr;
+  auto const destroyPluginObject = hPlugin != nullptr ? reinterpret_cast<DESTROYPLUGINOBJECT>(dlsym(hPlugin, "DestroyPluginObject")) : nullptr;
+#endif
+
+  if (createPluginObject == nullptr || destroyPluginObject == nullptr) {
+    printf("Failed to load plugin: %s\n", pluginPath);
+    fclose(f);
+    return 1;
+  }
+
+  if (config.mSpeed > 0.0)
+    printf("Replaying %s at %.2fx\n", config.mJournalPath, config.mSpeed);
+  else
+    printf("Replaying %s as fast as possible\n", config.mJournalPath);
+
+  auto const pPlugin = static_cast<InternalsPluginV07*>(createPluginObject());
+
+  CallbackStats telemetryStats;
+  telemetryStats.mName = "UpdateTelemetry";
+  CallbackStats scoringStats;
+  scoringStats.mName = "UpdateScoring";
+  CallbackStats physicsStats;
+  physicsStats.mName = "SetPhysicsOptions";
+  CallbackStats lifecycleStats;
+  lifecycleStats.mName = "Lifecycle";
+
+  PublicationDigest<rF2Telemetry> telemetryDigest(offsetof(rF2Telemetry, mNumVehicles));
+  PublicationDigest<rF2Scoring> scoringDigest(offsetof(rF2Scoring, mVehicles));
+
+  // Payload storage, reused between events.
+  std::vector<char> payload;
+  TelemInfoV01 telemInfo = {};
+  ScoringInfoV01 scoringInfo = {};
+  std::vector<VehicleScoringInfoV01> vehicleScoring;
+  std::vector<char> resultsStream;
+  PhysicsOptionsV01 physicsOptions = {};
+
+  auto malformed = false;
+  auto attached = false;
+  auto shutdown = false;
+  auto events = 0uLL;
+  auto firstTimestamp = -1.0;
+  auto const wallStart = std::chrono::steady_clock::now();
+
+  CallbackJournal::rF2CallbackJournalEventHeader event = {};
+  while (!malformed && fread(&event, sizeof(event), 1, f) == 1) {
+    payload.resize(event.mPayloadBytes);
+    if (event.mPayloadBytes > 0u && fread(payload.data(), 1, event.mPayloadBytes, f) != event.mPayloadBytes) {
+      printf("Journal is truncated after %llu events\n", events);
+      break;
+    }
+
+    if (firstTimestamp < 0.0)
+      firstTimestamp = event.mTimestampMicroseconds;
+
+    if (config.mSpeed > 0.0)
+      std::this_thread::sleep_until(wallStart + std::chrono::duration<double, std::micro>((event.mTimestampMicroseconds - firstTimestamp) / config.mSpeed));
+
+    auto argument = 0;
+    if (event.mPayloadBytes >= sizeof(argument))
+      memcpy(&argument, payload.data(), sizeof(argument));
+
+    switch (event.mType) {
+      case EventType::Startup:
+        TimeCallback(lifecycleStats, [&]() { pPlugin->Startup(argument); });
+        if (!attached) {
+          // Buffers are mapped by the plugin in Startup.
+          telemetryDigest.Attach("$rFactor2SMMP_TelemetryBuffer1$", "$rFactor2SMMP_TelemetryBuffer2$", "$rFactor2SMMP_TelemetryMultiBuffer$");
+          scoringDigest.Attach("$rFactor2SMMP_ScoringBuffer1$", "$rFactor2SMMP_ScoringBuffer2$", "$rFactor2SMMP_ScoringMultiBuffer$");
+          attached = true;
+        }
+        break;
+
+      case EventType::Shutdown:
+        telemetryDigest.Detach();
+        scoringDigest.Detach();
+        attached = false;
+        TimeCallback(lifecycleStats, [&]() { pPlugin->Shutdown(); });
+        shutdown = true;
+        break;
+
+      case EventType::StartSession:
+        TimeCallback(lifecycleStats, [&]() { pPlugin->StartSession(); });
+        break;
+
+      case EventType::EndSession:
+        TimeCallback(lifecycleStats, [&]() { pPlugin->EndSession(); });
+        break;
+
+      case EventType::EnterRealtime:
+        TimeCallback(lifecycleStats, [&]() { pPlugin->EnterRealtime(); });
+        break;
+
+      case EventType::ExitRealtime:
+        TimeCallback(lifecycleStats, [&]() { pPlugin->ExitRealtime(); });
+        break;
+
+      case EventType::ThreadStarted:
+        TimeCallback(lifecycleStats, [&]() { pPlugin->ThreadStarted(argument); });
+        break;
+
+      case EventType::ThreadStopping:
+        TimeCallback(lifecycleStats, [&]() { pPlugin->ThreadStopping(argument); });
+        break;
+
+      case EventType::UpdateTelemetry:
+        if (event.mPayloadBytes != sizeof(TelemInfoV01)) {
+          malformed = true;
+          break;
+        }
+
+        memcpy(&telemInfo, payload.data(), sizeof(TelemInfoV01));
+        TimeCallback(telemetryStats, [&]() { pPlugin->UpdateTelemetry(telemInfo); });
+        telemetryDigest.Update();
+        break;
+
+      case EventType::UpdateScoring: {
+        if (event.mPayloadBytes < sizeof(ScoringInfoV01)) {
+          malformed = true;
+          break;
+        }
+
+        memcpy(&scoringInfo, payload.data(), sizeof(ScoringInfoV01));
+        auto const numVehicles = max(0, static_cast<int>(scoringInfo.mNumVehicles));
+        auto const vehicleBytes = numVehicles * sizeof(VehicleScoringInfoV01);
+        if (event.mPayloadBytes < sizeof(ScoringInfoV01) + vehicleBytes) {
+          malformed = true;
+          break;
+        }
+
+        vehicleScoring.resize(numVehicles);
+        if (numVehicles > 0)
+          memcpy(vehicleScoring.data(), payload.data() + sizeof(ScoringInfoV01), vehicleBytes);
+
+        // Rest is results stream text, restore the terminator.
+        resultsStream.assign(payload.data() + sizeof(ScoringInfoV01) + vehicleBytes, payload.data() + event.mPayloadBytes);
+        resultsStream.push_back('\0');
+
+        scoringInfo.mVehicle = numVehicles > 0 ? vehicleScoring.data() : nullptr;
+        scoringInfo.mResultsStream = resultsStream.data();
+
+        TimeCallback(scoringStats, [&]() { pPlugin->UpdateScoring(scoringInfo); });
+        scoringDigest.Update();
+
+        // Scoring update can also complete a pending telemetry flip.
+        telemetryDigest.Update();
+        break;
+      }
+
+      case EventType::SetPhysicsOptions:
+        if (event.mPayloadBytes != sizeof(PhysicsOptionsV01)) {
+          malformed = true;
+          break;
+        }
+
+        memcpy(&physicsOptions, payload.data(), sizeof(PhysicsOptionsV01));
+        TimeCallback(physicsStats, [&]() { pPlugin->SetPhysicsOptions(physicsOptions); });
+        break;
+
+      default:
+        malformed = true;
+        break;
+    }
+
+    if (malformed)
+      printf("Malformed event %llu (type %u, %u bytes)\n", events, static_cast<unsigned int>(event.mType), event.mPayloadBytes);
+    else
+      ++events;
+  }
+
+  fclose(f);
+
+  auto const wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+
+  // Journal of a session that did not end cleanly.
+  if (!shutdown) {
+    telemetryDigest.Detach();
+    scoringDigest.Detach();
+    TimeCallback(lifecycleStats, [&]() { pPlugin->Shutdown(); });
+  }
+
+  destroyPluginObject(pPlugin);
+
+  printf("\n%-18s %12s %12s %12s\n", "Callback", "Calls", "Avg ns", "Max ns");
+  telemetryStats.Print();
+  scoringStats.Print();
+  physicsStats.Print();
+  lifecycleStats.Print();
+
+  printf("\nEvents: %llu in %.2f s wall time\n", events, wallSeconds);
+  printf("Telemetry flips: %llu  digest: %08x (%llu publishes)\n", telemetryDigest.Flips(), telemetryDigest.Digest(), telemetryDigest.DigestedPublishes());
+  printf("Scoring flips:   %llu  digest: %08x (%llu publishes)\n", scoringDigest.Flips(), scoringDigest.Digest(), scoringDigest.DigestedPublishes());
+
+  return malformed ? 1 : 0;
+}
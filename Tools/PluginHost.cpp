@@ -0,0 +1,396 @@
+/*
+Headless plugin host.
+
+Author: The Iron Wolf (vleonavicius@hotmail.com)
+Website: thecrewchief.org
+
+Description:
+  Loads plugin binary, instantiates plugin via CreatePluginObject and drives it the way rF2 does:
+  Startup, StartSession, EnterRealtime, per-vehicle UpdateTelemetry for every telemetry frame and
+  periodic UpdateScoring, all with synthetic vehicle data.  Reports cost of each callback and buffer
+  flip rates, so the publication engine can be load tested (up to MAX_MAPPED_VEHICLES) without the game.
+
+  Flips are counted by mapping plugin's buffers and watching their sequence counters (each flip
+  advances them by two), so counts are correct in all sync modes.
+
+  Plugin configuration is read by the plugin as usual, from UserData/player/rf2smmp.ini relative to
+  the current directory.
+
+Build (Linux, plugin built as described in README.md):
+  g++ -std=c++14 -O2 -pthread -Wno-invalid-offsetof -I../Include PluginHost.cpp -o PluginHost -ldl
+
+Usage:
+  PluginHost [options]
+    --plugin <path>         plugin binary (default ./librf2smmp.so, rFactor2SharedMemoryMapPlugin64.dll on Windows)
+    --vehicles <n>          number of vehicles (default 128)
+    --rate <hz>             telemetry frames per second, 0 means as fast as possible (default 90)
+    --scoring-rate <hz>     scoring updates per second of session time (default 5)
+    --seconds <s>           session length in session time (default 10)
+    --missing-id0           vehicle with mID 0 is not in the session (IDs start at 1)
+    --duplicate-et          every telemetry frame is sent twice with the same ET (like the game does)
+*/
+#define _USE_MATH_DEFINES                       // M_PI
+#include <math.h>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "Seqlock.h"
+#include "Platform.h"
+
+#pragma warning(push)
+#pragma warning(disable : 4263)   // UpdateGraphics virtual incorrect signature
+#pragma warning(disable : 4264)   // UpdateGraphics virtual incorrect signature
+#pragma warning(disable : 4121)   // Alignment sensitivity (ISI sets 4 byte pack)
+#pragma warning(disable : 4100)   // Unreferenced params
+#include "InternalsPlugin.hpp"
+#pragma warning(pop)
+
+#include "rF2State.h"
+
+#ifndef _WIN32
+#include <dlfcn.h>
+#endif
+
+struct HostConfig
+{
+  char const* mPluginPath = nullptr;
+  int mNumVehicles = rF2MappedBufferHeader::MAX_MAPPED_VEHICLES;
+  double mTelemetryRate = 90.0;
+  double mScoringRate = 5.0;
+  double mSessionSeconds = 10.0;
+  bool mMissingId0 = false;
+  bool mDuplicateET = false;
+};
+
+
+struct CallbackStats
+{
+  char const* mName = nullptr;
+  unsigned long long mCalls = 0uLL;
+  unsigned long long mTotalNs = 0uLL;
+  unsigned long long mMaxNs = 0uLL;
+
+  void Add(unsigned long long ns)
+  {
+    ++mCalls;
+    mTotalNs += ns;
+    mMaxNs = max(mMaxNs, ns);
+  }
+
+  void Print() const
+  {
+    printf("%-18s %12llu %12.1f %12llu\n", mName, mCalls, mCalls > 0uLL ? static_cast<double>(mTotalNs) / mCalls : 0.0, mMaxNs);
+  }
+};
+
+
+// Times a single callback.
+template <typename CallbackT>
+inline void TimeCallback(CallbackStats& stats, CallbackT callback)
+{
+  auto const start = std::chrono::steady_clock::now();
+  callback();
+  auto const end = std::chrono::steady_clock::now();
+  stats.Add(static_cast<unsigned long long>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()));
+}
+
+
+// Maps buffers of one type, and sums their sequence counters.
+template <typename BuffT>
+class FlipCounter
+{
+public:
+  void Attach(char const* fileName1, char const* fileName2, char const* multiBufferFileName)
+  {
+    void* pView = nullptr;
+    mhMap1 = Platform::MapMemoryFile(fileName1, sizeof(BuffT), pView);
+    mpBuf1 = static_cast<BuffT*>(pView);
+
+    mhMap2 = Platform::MapMemoryFile(fileName2, sizeof(BuffT), pView);
+    mpBuf2 = static_cast<BuffT*>(pView);
+
+    // Map control block first to learn the layout, then the whole file.
+    auto const hControl = Platform::MapMemoryFile(multiBufferFileName, sizeof(rF2MultiBufferControl), pView);
+    if (hControl == nullptr)
+      return;
+
+    auto const pControl = static_cast<rF2MultiBufferControl*>(pView);
+    auto const numBuffers = pControl->mNumBuffers;
+    mMultiBufferBytes = pControl->mFirstBufferOffset + pControl->mNumBuffers * pControl->mBufferStride;
+    Platform::UnmapMemoryFile(hControl, pView);
+
+    if (numBuffers > 0) {
+      mhMultiMap = Platform::MapMemoryFile(multiBufferFileName, mMultiBufferBytes, pView);
+      mpControl = static_cast<rF2MultiBufferControl*>(pView);
+    }
+  }
+
+  void Detach()
+  {
+    Platform::UnmapMemoryFile(mhMap1, mpBuf1);
+    Platform::UnmapMemoryFile(mhMap2, mpBuf2);
+    Platform::UnmapMemoryFile(mhMultiMap, mpControl);
+  }
+
+  unsigned long long SequenceSum() const
+  {
+    auto sum = 0uLL;
+    if (mpBuf1 != nullptr)
+      sum += Seqlock::LoadSequence(mpBuf1);
+
+    if (mpBuf2 != nullptr)
+      sum += Seqlock::LoadSequence(mpBuf2);
+
+    if (mpControl != nullptr) {
+      for (int i = 0; i < mpControl->mNumBuffers; ++i) {
+        auto const pBuf = reinterpret_cast<BuffT const*>(reinterpret_cast<char const*>(mpControl) + mpControl->mFirstBufferOffset + i * mpControl->mBufferStride);
+        sum += Seqlock::LoadSequence(pBuf);
+      }
+    }
+
+    return sum;
+  }
+
+private:
+  Platform::MapHandle mhMap1 = nullptr;
+  Platform::MapHandle mhMap2 = nullptr;
+  Platform::MapHandle mhMultiMap = nullptr;
+  BuffT* mpBuf1 = nullptr;
+  BuffT* mpBuf2 = nullptr;
+  rF2MultiBufferControl* mpControl = nullptr;
+  int mMultiBufferBytes = 0;
+};
+
+
+class SyntheticSession
+{
+public:
+  SyntheticSession(HostConfig const& config)
+    : mConfig(config)
+    , mTelemetry(config.mNumVehicles)
+    , mVehicleScoring(config.mNumVehicles)
+  {
+    for (int i = 0; i < mConfig.mNumVehicles; ++i) {
+      auto const id = mConfig.mMissingId0 ? i + 1 : i;
+
+      auto& t = mTelemetry[i];
+      t.mID = id;
+      t.mGear = 3;
+      t.mEngineRPM = 7000.0;
+      sprintf(t.mVehicleName, "Synthetic Car #%d", id);
+      sprintf(t.mTrackName, "Synthetic Oval");
+
+      auto& v = mVehicleScoring[i];
+      v.mID = id;
+      v.mIsPlayer = i == 0;
+      v.mControl = i == 0 ? 0 : 1;
+      v.mPlace = static_cast<unsigned char>(min(i + 1, 255));
+      sprintf(v.mDriverName, "Driver %d", id);
+      sprintf(v.mVehicleName, "Synthetic Car #%d", id);
+    }
+
+    sprintf(mScoringInfo.mTrackName, "Synthetic Oval");
+    sprintf(mScoringInfo.mPlayerName, "Driver 0");
+    mScoringInfo.mSession = 10;
+    mScoringInfo.mEndET = mConfig.mSessionSeconds;
+    mScoringInfo.mLapDist = TRACK_LENGTH;
+    mScoringInfo.mGamePhase = 5;
+    mScoringInfo.mInRealtime = true;
+    mScoringInfo.mResultsStream = mResultsStream;
+  }
+
+  // Moves vehicles around a circular track.
+  void UpdateTelemetry(double et, double dt)
+  {
+    for (int i = 0; i < mConfig.mNumVehicles; ++i) {
+      auto& t = mTelemetry[i];
+      auto const speed = VehicleSpeed(i);
+      auto const distance = DistanceTravelled(i, et);
+      auto const lapDist = fmod(distance, TRACK_LENGTH);
+      auto const angle = 2.0 * M_PI * lapDist / TRACK_LENGTH;
+
+      t.mDeltaTime = dt;
+      t.mElapsedTime = et;
+      t.mLapNumber = static_cast<long>(distance / TRACK_LENGTH);
+      t.mPos.x = TRACK_RADIUS * cos(angle);
+      t.mPos.z = TRACK_RADIUS * sin(angle);
+      t.mLocalVel.z = -speed;
+      t.mOri[0].x = cos(angle);
+      t.mOri[2].z = cos(angle);
+      t.mUnfilteredThrottle = t.mFilteredThrottle = 1.0;
+    }
+  }
+
+  ScoringInfoV01& UpdateScoring(double et)
+  {
+    for (int i = 0; i < mConfig.mNumVehicles; ++i) {
+      auto const& t = mTelemetry[i];
+      auto& v = mVehicleScoring[i];
+
+      v.mTotalLaps = static_cast<short>(t.mLapNumber);
+      v.mLapDist = fmod(DistanceTravelled(i, et), TRACK_LENGTH);
+      v.mPos = t.mPos;
+      v.mLocalVel = t.mLocalVel;
+      v.mOri[0] = t.mOri[0];
+      v.mOri[2] = t.mOri[2];
+    }
+
+    mScoringInfo.mCurrentET = et;
+    mScoringInfo.mNumVehicles = mConfig.mNumVehicles;
+    mScoringInfo.mVehicle = mVehicleScoring.data();
+
+    return mScoringInfo;
+  }
+
+  TelemInfoV01 const& VehicleTelemetry(int vehicleIndex) const { return mTelemetry[vehicleIndex]; }
+
+private:
+  static double constexpr TRACK_RADIUS = 500.0;
+  static double constexpr TRACK_LENGTH = 2.0 * M_PI * TRACK_RADIUS;
+
+  // Vehicles run at constant, slightly different speeds, spread 10m apart at the start.
+  static double VehicleSpeed(int vehicleIndex) { return 50.0 + vehicleIndex * 0.1; }
+
+  // Monotonically increasing, lap distance is this modulo TRACK_LENGTH.
+  static double DistanceTravelled(int vehicleIndex, double et) { return VehicleSpeed(vehicleIndex) * et + vehicleIndex * 10.0; }
+
+  HostConfig const& mConfig;
+  std::vector<TelemInfoV01> mTelemetry;
+  std::vector<VehicleScoringInfoV01> mVehicleScoring;
+  ScoringInfoV01 mScoringInfo = {};
+  char mResultsStream[1] = {};
+};
+
+
+static bool ParseArgs(int argc, char* argv[], HostConfig& config)
+{
+  for (int i = 1; i < argc; ++i) {
+    auto const hasValue = i + 1 < argc;
+    if (strcmp(argv[i], "--plugin") == 0 && hasValue)
+      config.mPluginPath = argv[++i];
+    else if (strcmp(argv[i], "--vehicles") == 0 && hasValue) {
+      // Note: min/max are macros, do not pass expressions with side effects.
+      auto const numVehicles = atoi(argv[++i]);
+      config.mNumVehicles = max(1, min(numVehicles, rF2MappedBufferHeader::MAX_MAPPED_VEHICLES));
+    }
+    else if (strcmp(argv[i], "--rate") == 0 && hasValue)
+      config.mTelemetryRate = atof(argv[++i]);
+    else if (strcmp(argv[i], "--scoring-rate") == 0 && hasValue)
+      config.mScoringRate = atof(argv[++i]);
+    else if (strcmp(argv[i], "--seconds") == 0 && hasValue)
+      config.mSessionSeconds = atof(argv[++i]);
+    else if (strcmp(argv[i], "--missing-id0") == 0)
+      config.mMissingId0 = true;
+    else if (strcmp(argv[i], "--duplicate-et") == 0)
+      config.mDuplicateET = true;
+    else {
+      printf("Unknown or incomplete option: %s\n", argv[i]);
+      return false;
+    }
+  }
+
+  return true;
+}
+
+
+int main(int argc, char* argv[])
+{
+  HostConfig config;
+  if (!ParseArgs(argc, argv, config))
+    return 2;
+
+#ifdef _WIN32
+  auto const pluginPath = config.mPluginPath != nullptr ? config.mPluginPath : "rFactor2SharedMemoryMapPlugin64.dll";
+  auto const hPlugin = LoadLibrary(pluginPath);
+  auto const createPluginObject = hPlugin != nullptr ? reinterpret_cast<CREATEPLUGINOBJECT>(GetProcAddress(hPlugin, "CreatePluginObject")) : nullptr;
+  auto const destroyPluginObject = hPlugin != nullptr ? reinterpret_cast<DESTROYPLUGINOBJECT>(GetProcAddress(hPlugin, "DestroyPluginObject")) : nullptr;
+#else
+  auto const pluginPath = config.mPluginPath != nullptr ? config.mPluginPath : "./librf2smmp.so";
+  auto const hPlugin = dlopen(pluginPath, RTLD_NOW);
+  auto const createPluginObject = hPlugin != nullptr ? reinterpret_cast<CREATEPLUGINOBJECT>(dlsym(hPlugin, "CreatePluginObject")) : nullptr;
+  auto const destroyPluginObject = hPlugin != nullptr ? reinterpret_cast<DESTROYPLUGINOBJECT>(dlsym(hPlugin, "DestroyPluginObject")) : nullptr;
+#endif
+
+  if (createPluginObject == nullptr || destroyPluginObject == nullptr) {
+    printf("Failed to load plugin: %s\n", pluginPath);
+    return 1;
+  }
+
+  printf("Plugin host: %d vehicles, %.1f Hz telemetry, %.1f Hz scoring, %.1f s session%s%s\n",
+    config.mNumVehicles, config.mTelemetryRate, config.mScoringRate, config.mSessionSeconds,
+    config.mMissingId0 ? ", missing mID 0" : "", config.mDuplicateET ? ", duplicate ETs" : "");
+
+  auto const pPlugin = static_cast<InternalsPluginV07*>(createPluginObject());
+
+  CallbackStats telemetryStats;
+  telemetryStats.mName = "UpdateTelemetry";
+  CallbackStats scoringStats;
+  scoringStats.mName = "UpdateScoring";
+  CallbackStats lifecycleStats;
+  lifecycleStats.mName = "Startup/Session";
+
+  TimeCallback(lifecycleStats, [&]() { pPlugin->Startup(1100L); });
+  TimeCallback(lifecycleStats, [&]() { pPlugin->StartSession(); });
+  TimeCallback(lifecycleStats, [&]() { pPlugin->EnterRealtime(); });
+
+  FlipCounter<rF2Telemetry> telemetryFlips;
+  telemetryFlips.Attach("$rFactor2SMMP_TelemetryBuffer1$", "$rFactor2SMMP_TelemetryBuffer2$", "$rFactor2SMMP_TelemetryMultiBuffer$");
+  FlipCounter<rF2Scoring> scoringFlips;
+  scoringFlips.Attach("$rFactor2SMMP_ScoringBuffer1$", "$rFactor2SMMP_ScoringBuffer2$", "$rFactor2SMMP_ScoringMultiBuffer$");
+
+  auto const telemetrySequenceStart = telemetryFlips.SequenceSum();
+  auto const scoringSequenceStart = scoringFlips.SequenceSum();
+
+  SyntheticSession session(config);
+
+  // Session time advances at telemetry rate, even if wall clock runs faster.
+  auto const frameSeconds = 1.0 / (config.mTelemetryRate > 0.0 ? config.mTelemetryRate : 90.0);
+  auto const scoringSeconds = config.mScoringRate > 0.0 ? 1.0 / config.mScoringRate : config.mSessionSeconds + 1.0;
+  auto nextScoringET = 0.0;
+
+  auto const wallStart = std::chrono::steady_clock::now();
+  auto frames = 0LL;
+  for (auto et = 0.0; et < config.mSessionSeconds; et += frameSeconds, ++frames) {
+    if (config.mTelemetryRate > 0.0)
+      std::this_thread::sleep_until(wallStart + std::chrono::duration<double>(frames * frameSeconds));
+
+    if (et >= nextScoringET) {
+      auto& scoringInfo = session.UpdateScoring(et);
+      TimeCallback(scoringStats, [&]() { pPlugin->UpdateScoring(scoringInfo); });
+      nextScoringET += scoringSeconds;
+    }
+
+    session.UpdateTelemetry(et, frameSeconds);
+    for (int pass = 0; pass < (config.mDuplicateET ? 2 : 1); ++pass) {
+      for (int i = 0; i < config.mNumVehicles; ++i) {
+        auto const& info = session.VehicleTelemetry(i);
+        TimeCallback(telemetryStats, [&]() { pPlugin->UpdateTelemetry(info); });
+      }
+    }
+  }
+
+  auto const wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+  auto const telemetryFlipCount = (telemetryFlips.SequenceSum() - telemetrySequenceStart) / 2uLL;
+  auto const scoringFlipCount = (scoringFlips.SequenceSum() - scoringSequenceStart) / 2uLL;
+
+  TimeCallback(lifecycleStats, [&]() { pPlugin->ExitRealtime(); });
+  TimeCallback(lifecycleStats, [&]() { pPlugin->EndSession(); });
+
+  telemetryFlips.Detach();
+  scoringFlips.Detach();
+
+  TimeCallback(lifecycleStats, [&]() { pPlugin->Shutdown(); });
+  destroyPluginObject(pPlugin);
+
+  printf("\n%-18s %12s %12s %12s\n", "Callback", "Calls", "Avg ns", "Max ns");
+  telemetryStats.Print();
+  scoringStats.Print();
+  lifecycleStats.Print();
+
+  printf("\nFrames: %lld in %.2f s wall time (%.1f frames/s)\n", frames, wallSeconds, frames / wallSeconds);
+  printf("Telemetry flips: %llu (%.1f/s)\n", telemetryFlipCount, telemetryFlipCount / wallSeconds);
+  printf("Scoring flips:   %llu (%.1f/s)\n", scoringFlipCount, scoringFlipCount / wallSeconds);
+
+  return 0;
+}
@@ -0,0 +1,185 @@
+/*
+Seqlock publication torture test.
+
+Author: The Iron Wolf (vleonavicius@hotmail.com)
+Website: thecrewchief.org
+
+Description:
+  Runs a writer thread that publishes double buffered frames the same way MappedDoubleBuffer does
+  in SyncMode::Seqlock mode, against many readers spinning on Seqlock::ReadBegin/ReadValidate.
+  Every frame is filled with values derived from the frame number, so any torn copy that passes
+  validation is detected.  Readers also verify that frame numbers never go backwards.
+
+  Writer fills the write buffer in small chunks, similar to per-vehicle telemetry memcpy'es.
+
+Build (Linux):
+  g++ -std=c++11 -O2 -pthread -I../Include SeqlockTorture.cpp -o SeqlockTorture
+
+Usage:
+  SeqlockTorture [numReaders] [seconds]
+
+  Exit code is 0 if no inconsistent snapshot was accepted.
+*/
+#include "Seqlock.h"
+
+#include <atomic>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+#include <vector>
+
+#pragma pack(push, 4)
+struct TortureBuffer
+{
+  static int const NUM_CHUNKS = 128;
+  static int const CHUNK_WORDS = 32;
+
+  // Same header layout as rF2MappedBufferHeader.
+  bool mCurrentRead;
+  unsigned int mSequence;
+
+  unsigned long long mFrame;
+  unsigned long long mPayload[NUM_CHUNKS * TortureBuffer::CHUNK_WORDS];
+};
+#pragma pack(pop)
+
+static unsigned long long PayloadValue(unsigned long long frame, int i)
+{
+  return frame * 0x9E3779B97F4A7C15uLL ^ static_cast<unsigned long long>(i);
+}
+
+struct ReaderStats
+{
+  unsigned long long mSnapshots = 0uLL;
+  unsigned long long mRetries = 0uLL;
+  unsigned long long mInconsistent = 0uLL;
+  unsigned long long mWentBackwards = 0uLL;
+};
+
+static TortureBuffer gBuf1;
+static TortureBuffer gBuf2;
+static std::atomic<bool> gStop(false);
+
+
+// Mirrors MappedDoubleBuffer::ClearState/FlipBuffersHelper sequence counter handling.
+static void WriterThread(unsigned long long* pFramesPublished)
+{
+  auto pCurReadBuf = &gBuf1;
+  auto pCurWriteBuf = &gBuf2;
+
+  gBuf1.mCurrentRead = true;
+  gBuf2.mCurrentRead = false;
+  Seqlock::BeginWrite(pCurWriteBuf);
+
+  unsigned long long frame = 0uLL;
+  while (!gStop.load(std::memory_order_relaxed)) {
+    ++frame;
+
+    // Fill the write buffer in chunks.
+    pCurWriteBuf->mFrame = frame;
+    for (int chunk = 0; chunk < TortureBuffer::NUM_CHUNKS; ++chunk) {
+      for (int w = 0; w < TortureBuffer::CHUNK_WORDS; ++w) {
+        auto const i = chunk * TortureBuffer::CHUNK_WORDS + w;
+        pCurWriteBuf->mPayload[i] = PayloadValue(frame, i);
+      }
+    }
+
+    // Flip.
+    auto const pNewReadBuf = pCurWriteBuf;
+    pCurWriteBuf = pCurReadBuf;
+    pCurReadBuf = pNewReadBuf;
+
+    Seqlock::EndWrite(pCurReadBuf);
+
+    gBuf1.mCurrentRead = !gBuf1.mCurrentRead;
+    gBuf2.mCurrentRead = !gBuf2.mCurrentRead;
+
+    Seqlock::BeginWrite(pCurWriteBuf);
+  }
+
+  *pFramesPublished = frame;
+}
+
+
+static void ReaderThread(ReaderStats* pStats)
+{
+  // Keep snapshot off the stack, it is large.
+  std::vector<TortureBuffer> snapshotStorage(1);
+  auto& snapshot = snapshotStorage[0];
+
+  unsigned long long lastFrame = 0uLL;
+  while (!gStop.load(std::memory_order_relaxed)) {
+    auto const pBuf = *static_cast<bool const volatile*>(&gBuf1.mCurrentRead) ? &gBuf1 : &gBuf2;
+
+    auto const sequence = Seqlock::ReadBegin(pBuf);
+    if (Seqlock::IsWriteInProgress(sequence)) {
+      ++pStats->mRetries;
+      continue;
+    }
+
+    memcpy(&snapshot, pBuf, sizeof(TortureBuffer));
+
+    if (!Seqlock::ReadValidate(pBuf, sequence)) {
+      ++pStats->mRetries;
+      continue;
+    }
+
+    // Accepted snapshot has to be consistent.
+    ++pStats->mSnapshots;
+    for (int i = 0; i < TortureBuffer::NUM_CHUNKS * TortureBuffer::CHUNK_WORDS; ++i) {
+      if (snapshot.mPayload[i] != PayloadValue(snapshot.mFrame, i)) {
+        ++pStats->mInconsistent;
+        break;
+      }
+    }
+
+    if (snapshot.mFrame < lastFrame)
+      ++pStats->mWentBackwards;
+
+    lastFrame = snapshot.mFrame;
+  }
+}
+
+
+int main(int argc, char* argv[])
+{
+  auto const numReaders = argc > 1 ? atoi(argv[1]) : static_cast<int>(std::thread::hardware_concurrency()) * 2;
+  auto const seconds = argc > 2 ? atoi(argv[2]) : 10;
+
+  printf("Seqlock torture: %d readers, %d seconds, %d bytes per buffer.\n", numReaders, seconds, static_cast<int>(sizeof(TortureBuffer)));
+
+  std::vector<ReaderStats> stats(numReaders);
+  std::vector<std::thread> readers;
+
+  unsigned long long framesPublished = 0uLL;
+  std::thread writer(WriterThread, &framesPublished);
+  for (int i = 0; i < numReaders; ++i)
+    readers.emplace_back(ReaderThread, &stats[i]);
+
+  std::this_thread::sleep_for(std::chrono::seconds(seconds));
+  gStop.store(true);
+
+  writer.join();
+  for (auto& r : readers)
+    r.join();
+
+  ReaderStats total;
+  for (auto const& s : stats) {
+    total.mSnapshots += s.mSnapshots;
+    total.mRetries += s.mRetries;
+    total.mInconsistent += s.mInconsistent;
+    total.mWentBackwards += s.mWentBackwards;
+  }
+
+  printf("Frames published:          %llu\n", framesPublished);
+  printf("Snapshots accepted:        %llu\n", total.mSnapshots);
+  printf("Torn copies retried:       %llu\n", total.mRetries);
+  printf("Inconsistent accepted:     %llu\n", total.mInconsistent);
+  printf("Frame number went back:    %llu\n", total.mWentBackwards);
+
+  auto const failed = total.mInconsistent != 0uLL || total.mWentBackwards != 0uLL || total.mSnapshots == 0uLL;
+  printf("%s\n", failed ? "FAILED" : "PASSED");
+
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,279 @@
+/*
+Telemetry recording decoder.
+
+Author: The Iron Wolf (vleonavicius@hotmail.com)
+Website: thecrewchief.org
+
+Description:
+  Decodes recordings written by the plugin's telemetry recorder (telemetryRecorder=1, see TelemetryRecording.h),
+  verifies every frame against the CRC32 of the source records stored in its chunk, and prints a summary:
+  frames, keyframes, dropped frames, session time covered and compression ratio.  Exit code is non zero if
+  the file is malformed or any frame does not round trip.
+
+  Optionally, dumps a few channels of one vehicle as CSV.
+
+  --selftest encodes synthetic frames (128 vehicles moving around a circle, with randomly changing channels)
+  and decodes them back in memory, comparing records byte by byte.
+
+Build (Linux):
+  g++ -std=c++14 -O2 -pthread -Wno-invalid-offsetof -I../Include TelemetryRecordingDecoder.cpp -o TelemetryRecordingDecoder
+
+Usage:
+  TelemetryRecordingDecoder <file.rf2tr> [--csv <mID>]
+  TelemetryRecordingDecoder --selftest [frames]
+*/
+#define _USE_MATH_DEFINES                       // M_PI
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "Platform.h"                           // __cdecl and friends on Linux
+
+#pragma warning(push)
+#pragma warning(disable : 4263)   // UpdateGraphics virtual incorrect signature
+#pragma warning(disable : 4264)   // UpdateGraphics virtual incorrect signature
+#pragma warning(disable : 4121)   // Alignment sensitivity (ISI sets 4 byte pack)
+#pragma warning(disable : 4100)   // Unreferenced params
+#include "InternalsPlugin.hpp"
+#pragma warning(pop)
+
+#include "rF2State.h"
+#include "TelemetryRecording.h"
+
+using namespace TelemetryRecording;
+
+struct DecodeStats
+{
+  unsigned long long mFrames = 0uLL;
+  unsigned long long mKeyframes = 0uLL;
+  unsigned long long mDroppedFrames = 0uLL;
+  unsigned long long mCrcMismatches = 0uLL;
+  unsigned long long mRawBytes = 0uLL;
+  unsigned long long mFileBytes = 0uLL;
+  int mMaxVehicles = 0;
+  double mFirstET = 0.0;
+  double mLastET = 0.0;
+};
+
+
+static void PrintCsvHeader()
+{
+  printf("frame,et,x,y,z,speed,rpm,gear,throttle,brake,fuel\n");
+}
+
+
+static void PrintCsvRow(unsigned long long frameNumber, rF2VehicleTelemetry const& vehicle)
+{
+  auto const speed = sqrt(vehicle.mLocalVel.x * vehicle.mLocalVel.x + vehicle.mLocalVel.y * vehicle.mLocalVel.y + vehicle.mLocalVel.z * vehicle.mLocalVel.z);
+  printf("%llu,%.4f,%.3f,%.3f,%.3f,%.3f,%.1f,%ld,%.3f,%.3f,%.3f\n", frameNumber, vehicle.mElapsedTime,
+    vehicle.mPos.x, vehicle.mPos.y, vehicle.mPos.z, speed, vehicle.mEngineRPM, static_cast<long>(vehicle.mGear),
+    vehicle.mFilteredThrottle, vehicle.mFilteredBrake, vehicle.mFuel);
+}
+
+
+// Returns process exit code.
+static int DecodeFile(char const* fileName, bool csv, int csvId)
+{
+  auto const f = fopen(fileName, "rb");
+  if (f == nullptr) {
+    printf("Failed to open: %s\n", fileName);
+    return 1;
+  }
+
+  DecodeStats stats;
+
+  rF2TelemetryRecordingFileHeader header = {};
+  if (fread(&header, sizeof(header), 1, f) != 1 || memcmp(header.mMagic, FILE_MAGIC, sizeof(header.mMagic)) != 0) {
+    printf("Not a telemetry recording: %s\n", fileName);
+    fclose(f);
+    return 1;
+  }
+
+  if (header.mVersion != FORMAT_VERSION || header.mVehicleRecordBytes != sizeof(rF2VehicleTelemetry)) {
+    printf("Unsupported recording: version %u, record bytes %u (decoder: version %u, record bytes %u)\n",
+      header.mVersion, header.mVehicleRecordBytes, FORMAT_VERSION, static_cast<unsigned int>(sizeof(rF2VehicleTelemetry)));
+    fclose(f);
+    return 1;
+  }
+
+  stats.mFileBytes = sizeof(header);
+
+  FrameDecoder decoder;
+  if (!decoder.Initialize()) {
+    printf("Out of memory\n");
+    fclose(f);
+    return 1;
+  }
+
+  std::vector<unsigned char> payload(ReferenceRecords::MAX_PAYLOAD_BYTES);
+  std::vector<rF2VehicleTelemetry> vehicles(rF2MappedBufferHeader::MAX_MAPPED_VEHICLES);
+
+  if (csv)
+    PrintCsvHeader();
+
+  auto malformed = false;
+  auto truncated = false;
+  auto seenKeyframe = false;
+  auto lastFrameNumber = 0uLL;
+  rF2TelemetryRecordingChunkHeader chunk = {};
+  while (fread(&chunk, sizeof(chunk), 1, f) == 1) {
+    if (chunk.mMagic != CHUNK_MAGIC
+      || (chunk.mType != ChunkType::Keyframe && chunk.mType != ChunkType::Delta)
+      || chunk.mNumVehicles < 0 || chunk.mNumVehicles > rF2MappedBufferHeader::MAX_MAPPED_VEHICLES
+      || chunk.mPayloadBytes > ReferenceRecords::MAX_PAYLOAD_BYTES) {
+      printf("Malformed chunk header after frame %llu\n", stats.mFrames);
+      malformed = true;
+      break;
+    }
+
+    if (fread(payload.data(), 1, chunk.mPayloadBytes, f) != chunk.mPayloadBytes) {
+      // Expected if the game did not shut down cleanly.
+      truncated = true;
+      break;
+    }
+
+    seenKeyframe = seenKeyframe || chunk.mType == ChunkType::Keyframe;
+    if (!seenKeyframe) {
+      printf("Recording does not start with a keyframe\n");
+      malformed = true;
+      break;
+    }
+
+    if (!decoder.Decode(payload.data(), chunk.mPayloadBytes, chunk.mNumVehicles, chunk.mType, vehicles.data())) {
+      printf("Malformed payload in frame %llu\n", chunk.mFrameNumber);
+      malformed = true;
+      break;
+    }
+
+    if (Crc32(vehicles.data(), chunk.mNumVehicles * sizeof(rF2VehicleTelemetry)) != chunk.mFrameCrc) {
+      if (stats.mCrcMismatches == 0uLL)
+        printf("CRC mismatch in frame %llu\n", chunk.mFrameNumber);
+
+      ++stats.mCrcMismatches;
+    }
+
+    if (stats.mFrames == 0uLL)
+      stats.mFirstET = chunk.mElapsedTime;
+    else if (chunk.mFrameNumber > lastFrameNumber + 1uLL)
+      stats.mDroppedFrames += chunk.mFrameNumber - lastFrameNumber - 1uLL;
+
+    lastFrameNumber = chunk.mFrameNumber;
+    stats.mLastET = chunk.mElapsedTime;
+    ++stats.mFrames;
+    stats.mKeyframes += chunk.mType == ChunkType::Keyframe ? 1uLL : 0uLL;
+    stats.mRawBytes += chunk.mNumVehicles * sizeof(rF2VehicleTelemetry);
+    stats.mFileBytes += sizeof(chunk) + chunk.mPayloadBytes;
+    stats.mMaxVehicles = chunk.mNumVehicles > stats.mMaxVehicles ? chunk.mNumVehicles : stats.mMaxVehicles;
+
+    if (csv) {
+      for (int i = 0; i < chunk.mNumVehicles; ++i) {
+        if (vehicles[i].mID == csvId)
+          PrintCsvRow(chunk.mFrameNumber, vehicles[i]);
+      }
+    }
+  }
+
+  fclose(f);
+
+  // Keep stdout clean for CSV.
+  auto const out = csv ? stderr : stdout;
+  fprintf(out, "Recording:        %s\n", fileName);
+  fprintf(out, "Frames:           %llu (%llu keyframes, %llu dropped)\n", stats.mFrames, stats.mKeyframes, stats.mDroppedFrames);
+  fprintf(out, "Vehicles:         up to %d\n", stats.mMaxVehicles);
+  fprintf(out, "Session time:     %.3f - %.3f s\n", stats.mFirstET, stats.mLastET);
+  fprintf(out, "Raw bytes:        %llu\n", stats.mRawBytes);
+  fprintf(out, "File bytes:       %llu (%.1f%% of raw)\n", stats.mFileBytes, stats.mRawBytes > 0uLL ? 100.0 * stats.mFileBytes / stats.mRawBytes : 0.0);
+  fprintf(out, "CRC mismatches:   %llu\n", stats.mCrcMismatches);
+  if (truncated)
+    fprintf(out, "Last chunk is truncated\n");
+
+  return malformed || stats.mCrcMismatches > 0uLL ? 1 : 0;
+}
+
+
+// Synthetic frames: vehicles go around a circle, some channels change every frame, some rarely.
+static void FillSyntheticFrame(std::vector<rF2VehicleTelemetry>& vehicles, int frame)
+{
+  auto const et = frame * 0.02;
+  for (int i = 0; i < static_cast<int>(vehicles.size()); ++i) {
+    auto& v = vehicles[i];
+    auto const angle = 2.0 * M_PI * (et / 90.0 + i / static_cast<double>(vehicles.size()));
+
+    v.mID = i;
+    v.mDeltaTime = 0.02;
+    v.mElapsedTime = et;
+    v.mLapNumber = static_cast<long>(et / 90.0);
+    snprintf(v.mVehicleName, sizeof(v.mVehicleName), "Vehicle %d", i);
+    snprintf(v.mTrackName, sizeof(v.mTrackName), "Synthetic Circle");
+    v.mPos.x = 1000.0 * cos(angle);
+    v.mPos.z = 1000.0 * sin(angle);
+    v.mLocalVel.z = -70.0 + (rand() % 100) / 100.0;
+    v.mEngineRPM = 7000.0 + rand() % 2000;
+    v.mGear = 4 + (frame / 50 + i) % 3;
+    v.mFilteredThrottle = (rand() % 1000) / 1000.0;
+    v.mFuel = 100.0 - et * 0.01;
+
+    for (auto& wheel : v.mWheels) {
+      wheel.mSuspensionDeflection = 0.05 + (rand() % 100) / 10000.0;
+      wheel.mBrakeTemp = 500.0 + (rand() % 100) / 10.0;
+      wheel.mTemperature[0] = wheel.mTemperature[1] = wheel.mTemperature[2] = 360.0 + frame / 1000.0;
+    }
+  }
+}
+
+
+static int SelfTest(int numFrames)
+{
+  FrameEncoder encoder;
+  FrameDecoder decoder;
+  if (!encoder.Initialize() || !decoder.Initialize()) {
+    printf("Out of memory\n");
+    return 1;
+  }
+
+  std::vector<unsigned char> payload(ReferenceRecords::MAX_PAYLOAD_BYTES);
+  std::vector<rF2VehicleTelemetry> source(rF2MappedBufferHeader::MAX_MAPPED_VEHICLES);
+  std::vector<rF2VehicleTelemetry> decoded(rF2MappedBufferHeader::MAX_MAPPED_VEHICLES);
+  memset(source.data(), 0, source.size() * sizeof(rF2VehicleTelemetry));
+
+  auto const numVehicles = static_cast<int>(source.size());
+  auto rawBytes = 0uLL;
+  auto encodedBytes = 0uLL;
+  for (int frame = 0; frame < numFrames; ++frame) {
+    FillSyntheticFrame(source, frame);
+
+    auto const type = frame % 100 == 0 ? ChunkType::Keyframe : ChunkType::Delta;
+    auto const payloadBytes = encoder.Encode(source.data(), numVehicles, type, payload.data());
+    if (!decoder.Decode(payload.data(), payloadBytes, numVehicles, type, decoded.data())
+      || memcmp(source.data(), decoded.data(), numVehicles * sizeof(rF2VehicleTelemetry)) != 0) {
+      printf("Self test FAILED at frame %d\n", frame);
+      return 1;
+    }
+
+    rawBytes += numVehicles * sizeof(rF2VehicleTelemetry);
+    encodedBytes += sizeof(rF2TelemetryRecordingChunkHeader) + payloadBytes;
+  }
+
+  printf("Self test passed: %d frames of %d vehicles, encoded size %.1f%% of raw\n", numFrames, numVehicles, 100.0 * encodedBytes / rawBytes);
+  return 0;
+}
+
+
+int main(int argc, char* argv[])
+{
+  if (argc >= 2 && strcmp(argv[1], "--selftest") == 0)
+    return SelfTest(argc >= 3 ? atoi(argv[2]) : 1000);
+
+  if (argc == 2)
+    return DecodeFile(argv[1], false /*csv*/, 0);
+
+  if (argc == 4 && strcmp(argv[2], "--csv") == 0)
+    return DecodeFile(argv[1], true /*csv*/, atoi(argv[3]));
+
+  printf("Usage:\n");
+  printf("  TelemetryRecordingDecoder <file.rf2tr> [--csv <mID>]\n");
+  printf("  TelemetryRecordingDecoder --selftest [frames]\n");
+  return 2;
+}